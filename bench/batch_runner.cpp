@@ -0,0 +1,189 @@
+// ============================================================================
+// SOUL WORLD - Simulation de mondes en lot
+// ============================================================================
+//
+// Fait tourner des centaines de mondes indépendants, sans rendu, à pleine
+// vitesse sur tous les cœurs : équilibrage (balayage de graines) et tests
+// d'endurance. Chaque monde a sa graine, ses joueurs pilotés par un bot
+// déterministe, ses vagues, ennemis et projectiles ; rien n'est partagé.
+//
+// Usage : soulworld_batch [cle=valeur ...]
+// Sortie : JSON sur stdout (ticks/seconde agrégés, résultat de chaque monde).
+
+#define SOUL_WORLD_NO_MAIN
+#include "../main.cpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace Batch {
+
+struct Settings {
+    int worlds = 64;
+    int ticks = 36000; // 10 minutes de jeu à 60 Hz
+    unsigned int threads = 0; // 0 : un par cœur
+    unsigned int seed = 1234;
+    int players = 1;
+    bool god = false; // joueurs invulnérables : endurance sans fin de partie
+    std::string level;
+
+    bool set(const std::string& key, const std::string& value) {
+        if (key == "worlds") worlds = std::stoi(value);
+        else if (key == "ticks") ticks = std::stoi(value);
+        else if (key == "threads") threads = unsigned(std::stoul(value));
+        else if (key == "seed") seed = unsigned(std::stoul(value));
+        else if (key == "players") players = std::stoi(value);
+        else if (key == "god") god = std::stoi(value) != 0;
+        else if (key == "level") level = value;
+        else return false;
+        return true;
+    }
+
+    bool parse(const std::string& arg) {
+        auto eq = arg.find('=');
+        return eq != std::string::npos && set(arg.substr(0, eq), arg.substr(eq + 1));
+    }
+};
+
+// Pilote simple : se déplace par à-coups, saute, esquive et frappe en
+// rafales. Ses tirages viennent de sa propre graine, pas de celle du monde.
+class Bot {
+public:
+    explicit Bot(unsigned int seed) : rng(seed) {}
+
+    PlayerInput next() {
+        PlayerInput in;
+        in.previous = held;
+        if (--moveTimer <= 0) {
+            moveTimer = rng.range(20, 90);
+            direction = rng.range(0, 2);
+        }
+        held = 0;
+        if (direction == 1) held |= PlayerInput::Left;
+        else if (direction == 2) held |= PlayerInput::Right;
+        if (rng.range(0.f, 1.f) < 0.03f) held |= PlayerInput::Jump;
+        if (rng.range(0.f, 1.f) < 0.01f) held |= PlayerInput::Dash;
+        if ((++tick / 6) % 2 == 0) held |= PlayerInput::Attack;
+        in.held = held;
+        return in;
+    }
+
+private:
+    Random rng;
+    uint16_t held = 0;
+    int moveTimer = 0, direction = 0, tick = 0;
+};
+
+struct Outcome {
+    unsigned int seed = 0;
+    int wave = 0;
+    int ticks = 0;
+    bool alive = true;
+    int health = 0;
+    size_t enemies = 0;
+    uint32_t checksum = 0;
+};
+
+Outcome runWorld(const Settings& settings, unsigned int seed) {
+    World world;
+    // Chaque monde mappe le fichier de niveau pour lui-même (Level n'est pas copiable).
+    if (!settings.level.empty()) {
+        if (auto level = Level::load(settings.level)) world.loadLevel(std::move(*level));
+    }
+    world.setPlayerCount(size_t(settings.players));
+    world.setAutoAdvanceWaves(true);
+    world.seed(seed);
+    world.reset();
+    std::vector<Bot> bots;
+    for (size_t i = 0; i < world.getPlayerCount(); ++i) {
+        world.getPlayer(i).setGodMode(settings.god);
+        bots.emplace_back(seed * 31u + unsigned(i) + 1u);
+    }
+
+    Outcome out;
+    out.seed = seed;
+    PlayerInputs inputs{};
+    while (out.ticks < settings.ticks && !world.allPlayersDead()) {
+        for (size_t i = 0; i < bots.size(); ++i) inputs[i] = bots[i].next();
+        world.update(Config::FIXED_DT, inputs);
+        ++out.ticks;
+    }
+    out.wave = world.getWaveManager().getCurrentWave();
+    out.alive = !world.allPlayersDead();
+    out.health = world.getPlayer().getHealth();
+    out.enemies = world.getEnemyCount();
+    out.checksum = world.checksum();
+    return out;
+}
+
+} // namespace Batch
+
+int main(int argc, char** argv) {
+    using namespace Batch;
+    using Clock = std::chrono::steady_clock;
+
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        if (!settings.parse(argv[i])) {
+            std::cerr << "Usage: " << argv[0]
+                      << " [worlds=N] [ticks=N] [threads=N] [seed=N] [players=1|2] [god=0|1] [level=fichier.swl]" << std::endl;
+            return 2;
+        }
+    }
+    settings.worlds = std::max(settings.worlds, 1);
+    settings.players = std::clamp(settings.players, 1, int(Config::MAX_PLAYERS));
+    unsigned int threads = settings.threads ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, unsigned(settings.worlds));
+
+    if (!settings.level.empty()) {
+        if (!Level::load(settings.level)) {
+            std::cerr << "Niveau illisible: " << settings.level << std::endl;
+            return 1;
+        }
+    }
+
+    // Un monde par tâche, tiré par le premier thread libre : au plus un monde
+    // vivant par thread (chacun a son thread de streaming de niveau).
+    std::vector<Outcome> outcomes(size_t(settings.worlds));
+    std::atomic<int> nextJob{0};
+    auto worker = [&] {
+        for (int job = nextJob++; job < settings.worlds; job = nextJob++)
+            outcomes[size_t(job)] = runWorld(settings, settings.seed + unsigned(job));
+    };
+
+    auto start = Clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; ++t) pool.emplace_back(worker);
+    for (auto& thread : pool) thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    uint64_t totalTicks = 0;
+    int survivors = 0, bestWave = 0;
+    double waveSum = 0;
+    for (const auto& o : outcomes) {
+        totalTicks += uint64_t(o.ticks);
+        survivors += o.alive;
+        bestWave = std::max(bestWave, o.wave);
+        waveSum += o.wave;
+    }
+
+    std::printf("{\n");
+    std::printf("  \"worlds\": %d,\n  \"threads\": %u,\n  \"ticks_per_world\": %d,\n  \"seed\": %u,\n",
+                settings.worlds, threads, settings.ticks, settings.seed);
+    std::printf("  \"wall_seconds\": %.3f,\n  \"total_ticks\": %llu,\n  \"ticks_per_second\": %.0f,\n",
+                seconds, static_cast<unsigned long long>(totalTicks), seconds > 0 ? double(totalTicks) / seconds : 0.0);
+    std::printf("  \"survivors\": %d,\n  \"mean_wave\": %.2f,\n  \"best_wave\": %d,\n",
+                survivors, waveSum / double(outcomes.size()), bestWave);
+    std::printf("  \"results\": [\n");
+    for (size_t i = 0; i < outcomes.size(); ++i) {
+        const Outcome& o = outcomes[i];
+        std::printf("    {\"seed\": %u, \"wave\": %d, \"ticks\": %d, \"alive\": %s, \"health\": %d, \"enemies\": %zu, \"checksum\": \"%08x\"}%s\n",
+                    o.seed, o.wave, o.ticks, o.alive ? "true" : "false", o.health, o.enemies, o.checksum,
+                    i + 1 < outcomes.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,425 @@
+// ============================================================================
+// SOUL WORLD - Micro-benchmarks des sous-systèmes
+// ============================================================================
+//
+// Usage : soulworld_microbench [--filter <sous-chaine>] [--min-time <secondes>]
+// Sortie : JSON sur stdout (ns/op par benchmark), pour comparer les commits.
+
+#define SOUL_WORLD_NO_MAIN
+#include "../main.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace Bench {
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+struct Result {
+    std::string name;
+    std::string params;
+    long long ops = 0;
+    double nsPerOp = 0;
+    double minNsPerOp = 0;
+};
+
+struct Runner {
+    double minTime = 0.25;
+    std::string filter;
+    std::vector<Result> results;
+
+    // setup() construit un état neuf (non chronométré), body(état) exécute
+    // opsPerBatch opérations (chronométré). On répète jusqu'à minTime.
+    template <typename Setup, typename Body>
+    void run(const std::string& name, const std::string& params, long long opsPerBatch,
+             Setup setup, Body body) {
+        std::string fullName = params.empty() ? name : name + "/" + params;
+        if (!filter.empty() && fullName.find(filter) == std::string::npos) return;
+
+        using Clock = std::chrono::steady_clock;
+        double totalNs = 0, bestBatch = 1e300;
+        long long totalOps = 0;
+
+        while (totalNs < minTime * 1e9 || totalOps < opsPerBatch * 3) {
+            auto fixture = setup();
+            auto t0 = Clock::now();
+            body(fixture);
+            auto t1 = Clock::now();
+            double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+            totalNs += ns;
+            totalOps += opsPerBatch;
+            bestBatch = std::min(bestBatch, ns / opsPerBatch);
+            doNotOptimize(fixture);
+        }
+
+        results.push_back({name, params, totalOps, totalNs / totalOps, bestBatch});
+        std::fprintf(stderr, "%-48s %12.1f ns/op\n", fullName.c_str(), totalNs / totalOps);
+    }
+
+    void writeJson(std::FILE* out) const {
+        std::fprintf(out, "{\n  \"context\": {\"min_time_s\": %.3f},\n  \"benchmarks\": [\n", minTime);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            std::fprintf(out,
+                         "    {\"name\": \"%s\", \"params\": \"%s\", \"ops\": %lld, "
+                         "\"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f}%s\n",
+                         r.name.c_str(), r.params.c_str(), r.ops, r.nsPerOp, r.minNsPerOp,
+                         i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+    }
+};
+
+// Entrées pour les dégradés ad hoc des mesures (longLivedConfig n'est pas un préréglage).
+constexpr size_t CURVE_SLOTS = 4;
+
+// Particules quasi immortelles : le taux de remplissage reste stable pendant la mesure.
+ParticleConfig longLivedConfig() {
+    ParticleConfig cfg;
+    cfg.minLife = cfg.maxLife = 1e6f;
+    return cfg;
+}
+
+std::unique_ptr<ParticleSystem> filledSystem(size_t capacity, float fill) {
+    auto ps = std::make_unique<ParticleSystem>(capacity, 1, CURVE_SLOTS);
+    ps->emit({500.f, 500.f}, longLivedConfig(), int(capacity * fill));
+    return ps;
+}
+
+// Plateformes éparpillées hors du joueur, plus un sol sous lui.
+std::vector<Platform> makePlatforms(int count) {
+    std::vector<Platform> platforms;
+    platforms.reserve(count);
+    platforms.emplace_back(sf::Vector2f{2800.f, 50.f}, sf::Vector2f{100.f, 1050.f});
+    for (int i = 1; i < count; ++i) {
+        float x = 100.f + float((i * 137) % 2800);
+        float y = 200.f + float((i * 61) % 700);
+        platforms.emplace_back(sf::Vector2f{150.f, 25.f}, sf::Vector2f{x, y}, i % 2 == 0);
+    }
+    return platforms;
+}
+
+void benchParticles(Runner& r) {
+    constexpr size_t capacity = 2000;
+    for (float fill : {0.f, 0.5f, 0.9f}) {
+        std::string p = "fill=" + std::to_string(int(fill * 100));
+        ParticleConfig cfg = longLivedConfig();
+        r.run("ParticleSystem::emit", p, 100,
+              [&] { return filledSystem(capacity, fill); },
+              [&](auto& ps) { for (int i = 0; i < 100; ++i) ps->emit({500.f, 500.f}, cfg, 1); });
+    }
+    // Rafale depuis un préréglage teinté (mort d'ennemi) : un seul passage sur le pool.
+    for (float fill : {0.f, 0.5f}) {
+        std::string p = "count=50,fill=" + std::to_string(int(fill * 100));
+        r.run("ParticleSystem::emitBurst", p, 1,
+              [&] { return filledSystem(capacity, fill); },
+              [](auto& ps) {
+                  ps->emit({500.f, 500.f}, EnemyTints::get(0, ParticlePreset::EnemyDeath), 50);
+              });
+    }
+    for (float fill : {0.1f, 0.5f, 1.f}) {
+        std::string p = "fill=" + std::to_string(int(fill * 100));
+        r.run("ParticleSystem::update", p, 20,
+              [&] { return filledSystem(capacity, fill); },
+              [&](auto& ps) { for (int i = 0; i < 20; ++i) ps->update(1.f / 60.f); });
+    }
+    // Pool plein réparti sur plusieurs dégradés à quatre arrêts : la mise à jour
+    // ne lit que les tables cuites, quel que soit le nombre d'arrêts.
+    r.run("ParticleSystem::updateGradients", "curves=4,fill=100", 20,
+          [&] {
+              auto ps = std::make_unique<ParticleSystem>(capacity, 1, CURVE_SLOTS);
+              for (int c = 0; c < 4; ++c) {
+                  ParticleConfig cfg = longLivedConfig();
+                  uint8_t tint = uint8_t(60 * c);
+                  cfg.gradient = ParticleGradient::make(
+                      {{0.f, {255, 255, 255, 255}}, {0.2f, {255, tint, 80, 230}}, {0.6f, {tint, 80, 255, 160}}, {1.f, {0, 0, 0, 0}}},
+                      {{0.f, 0.5f}, {0.1f, 1.4f}, {0.5f, 1.f}, {1.f, 0.f}});
+                  ps->emit({500.f, 500.f}, cfg, int(capacity / 4));
+              }
+              return ps;
+          },
+          [&](auto& ps) { for (int i = 0; i < 20; ++i) ps->update(1.f / 60.f); });
+}
+
+void benchCollision(Runner& r) {
+    for (int n : {12, 100, 1000}) {
+        std::string p = "platforms=" + std::to_string(n);
+        auto platforms = makePlatforms(n);
+        Random rng(1234);
+        r.run("Player::resolveCollision", p, 10,
+              [&] { return std::make_unique<Player>(sf::Vector2f{1500.f, 1040.f}); },
+              [&](auto& player) {
+                  for (int i = 0; i < 10; ++i)
+                      for (const auto& plat : platforms) doNotOptimize(player->resolveCollision(plat));
+              });
+        r.run("Enemy::resolveCollision", p, 10,
+              [&] { return std::make_unique<Enemy>(sf::Vector2f{1500.f, 1040.f}, Enemy::Type::Red, 1, rng); },
+              [&](auto& enemy) {
+                  for (int i = 0; i < 10; ++i)
+                      for (const auto& plat : platforms) enemy->resolveCollision(plat);
+              });
+    }
+}
+
+void benchInput(Runner& r) {
+    auto setup = [] {
+        InputManager input;
+        input.setPressed("left", false);
+        input.setPressed("right", true);
+        input.beginFrame();
+        input.setPressed("jump", true);
+        return input;
+    };
+    r.run("InputManager::isPressed", "", 1000, setup,
+          [](auto& in) { for (int i = 0; i < 1000; ++i) doNotOptimize(in.isPressed("right")); });
+    r.run("InputManager::justPressed", "", 1000, setup,
+          [](auto& in) { for (int i = 0; i < 1000; ++i) doNotOptimize(in.justPressed("jump")); });
+    r.run("InputManager::getAxis", "", 1000, setup,
+          [](auto& in) { for (int i = 0; i < 1000; ++i) doNotOptimize(in.getAxis("left", "right")); });
+}
+
+void benchProjectiles(Runner& r) {
+    constexpr int count = 256, ticks = 60;
+    r.run("Projectile::update", "projectiles=256", count * ticks,
+          [] {
+              std::vector<Projectile> projectiles;
+              projectiles.reserve(count);
+              for (int i = 0; i < count; ++i)
+                  projectiles.emplace_back(sf::Vector2f{1500.f, 500.f},
+                                           sf::Vector2f{std::cos(float(i)), std::sin(float(i))},
+                                           200.f, sf::Color(100, 150, 255));
+              return projectiles;
+          },
+          [](auto& projectiles) {
+              LevelBounds bounds;
+              for (int t = 0; t < ticks; ++t)
+                  for (auto& p : projectiles) p.update(1.f / 60.f, bounds);
+          });
+}
+
+void benchWaves(Runner& r) {
+    struct WaveFixture {
+        Random rng{1234};
+        WaveManager waves{rng};
+        SlotMap<Enemy> enemies;
+    };
+    for (int wave : {1, 5, 10}) {
+        r.run("WaveManager::startWave", "wave=" + std::to_string(wave), 100,
+              [] { return std::make_unique<WaveFixture>(); },
+              [wave](auto& f) { for (int i = 0; i < 100; ++i) f->waves.startWave(wave); });
+    }
+
+    // Une vague complète simulée à 60 Hz : inclut les apparitions d'ennemis.
+    constexpr int ticks = 600;
+    r.run("WaveManager::update", "wave=10,spawning", ticks,
+          [] {
+              auto fixture = std::make_unique<WaveFixture>();
+              fixture->waves.startWave(10);
+              return fixture;
+          },
+          [](auto& f) {
+              for (int t = 0; t < ticks; ++t) f->waves.update(1.f / 60.f, f->enemies, {500.f, 900.f});
+          });
+    r.run("WaveManager::update", "wave=10,idle", ticks,
+          [] {
+              auto fixture = std::make_unique<WaveFixture>();
+              fixture->waves.startWave(10);
+              for (int t = 0; t < 2000; ++t) fixture->waves.update(1.f / 60.f, fixture->enemies, {500.f, 900.f});
+              return fixture;
+          },
+          [](auto& f) {
+              for (int t = 0; t < ticks; ++t) f->waves.update(1.f / 60.f, f->enemies, {500.f, 900.f});
+          });
+}
+
+// Entités par handle : une frame de projectiles qui naissent et meurent, et
+// la résolution des handles gardés par d'autres systèmes.
+void benchSlotMap(Runner& r) {
+    constexpr int count = 512;
+    struct Churn {
+        SlotMap<Projectile> projectiles;
+        std::vector<SlotHandle> handles;
+        int frame = 0;
+    };
+    auto setup = [] {
+        auto f = std::make_unique<Churn>();
+        f->projectiles.reserve(count);
+        for (int i = 0; i < count; ++i)
+            f->handles.push_back(f->projectiles.emplace(sf::Vector2f{float(i), 0.f}, sf::Vector2f{1.f, 0.f}, 100.f, sf::Color::White));
+        return f;
+    };
+    r.run("SlotMap::eraseIf+emplace", "live=512,churn=1/8", count, setup, [](auto& f) {
+        int phase = f->frame++ & 7;
+        size_t i = 0;
+        size_t removed = f->projectiles.eraseIf([&](const Projectile&) { return (i++ & 7) == size_t(phase); });
+        for (size_t k = 0; k < removed; ++k)
+            f->projectiles.emplace(sf::Vector2f{float(k), 0.f}, sf::Vector2f{1.f, 0.f}, 100.f, sf::Color::White);
+        doNotOptimize(f->projectiles.size());
+    });
+    r.run("SlotMap::get", "live=512", count, setup, [](auto& f) {
+        size_t found = 0;
+        for (SlotHandle h : f->handles) found += f->projectiles.get(h) != nullptr;
+        doNotOptimize(found);
+    });
+}
+
+// Monde chargé (ennemis + projectiles) et instantané préalloué.
+struct SnapshotFixture {
+    std::unique_ptr<World> world = std::make_unique<World>();
+    std::unique_ptr<WorldSnapshot> snap = std::make_unique<WorldSnapshot>();
+
+    explicit SnapshotFixture(int enemies) {
+        world->reset();
+        world->getWaveManager().startWave(10);
+        for (int i = 0; i < enemies; ++i)
+            world->spawnEnemy({300.f + float((i * 97) % 2400), 1000.f}, Enemy::Type(i % 3));
+        for (int i = 0; i < enemies * 2; ++i)
+            world->spawnProjectile({1500.f, 500.f}, {std::cos(float(i)), std::sin(float(i))}, 200.f, sf::Color(100, 150, 255));
+        world->capture(*snap);
+    }
+};
+
+void benchSnapshots(Runner& r) {
+    for (int n : {10, 100}) {
+        std::string p = "enemies=" + std::to_string(n) + ",projectiles=" + std::to_string(n * 2);
+        r.run("World::capture", p, 100,
+              [n] { return std::make_unique<SnapshotFixture>(n); },
+              [](auto& f) { for (int i = 0; i < 100; ++i) doNotOptimize(f->world->capture(*f->snap)); });
+        r.run("World::restore", p, 100,
+              [n] { return std::make_unique<SnapshotFixture>(n); },
+              [](auto& f) { for (int i = 0; i < 100; ++i) f->world->restore(*f->snap); });
+    }
+}
+
+// Hordes : le tick complet du monde, dominé par la mise à jour des ennemis.
+void benchEnemies(Runner& r) {
+    for (int n : {100, 1000, 4000}) {
+        r.run("World::update", "enemies=" + std::to_string(n), 10,
+              [n] {
+                  auto f = std::make_unique<SnapshotFixture>(0);
+                  f->world->getPlayer().setGodMode(true);
+                  for (int i = 0; i < n; ++i)
+                      f->world->spawnEnemy({300.f + float((i * 97) % 2400), 1000.f - float(i % 5) * 150.f}, Enemy::Type(i % 3));
+                  return f;
+              },
+              [](auto& f) { for (int i = 0; i < 10; ++i) f->world->update(Config::FIXED_DT, PlayerInputs{}); });
+    }
+}
+
+// Pire cas du rollback : restaurer puis rejouer toute la fenêtre en un tick.
+void benchRollback(Runner& r) {
+    for (int n : {10, 60}) {
+        std::string p = "enemies=" + std::to_string(n) + ",ticks=" + std::to_string(Config::ROLLBACK_WINDOW);
+        r.run("World::resimulate", p, 1,
+              [n] {
+                  auto f = std::make_unique<SnapshotFixture>(n);
+                  f->world->setPlayerCount(2);
+                  f->world->capture(*f->snap);
+                  return f;
+              },
+              [](auto& f) {
+                  f->world->restore(*f->snap);
+                  PlayerInputs inputs{};
+                  for (int t = 0; t < Config::ROLLBACK_WINDOW; ++t) {
+                      inputs[1] = {uint16_t(t & 1 ? PlayerInput::Left : PlayerInput::Right), inputs[1].held};
+                      f->world->update(Config::FIXED_DT, inputs);
+                  }
+              });
+    }
+
+    // Deux pairs reliés en mémoire, inputs distants imprévisibles : un rollback presque à chaque tick.
+    struct Peers {
+        LoopbackLink link{{4, 0, 0}};
+        std::unique_ptr<World> a = std::make_unique<World>(), b = std::make_unique<World>();
+        std::unique_ptr<RollbackSession> sa, sb;
+        std::mt19937 gen{7};
+
+        Peers() {
+            for (World* w : {a.get(), b.get()}) {
+                w->seed(Config::NETPLAY_SEED);
+                w->setPlayerCount(2);
+                w->setAutoAdvanceWaves(true);
+                w->reset();
+            }
+            sa = std::make_unique<RollbackSession>(*a, link.endpoint(0), 0);
+            sb = std::make_unique<RollbackSession>(*b, link.endpoint(1), 1);
+        }
+    };
+    r.run("RollbackSession::advance", "latency=4,peers=2", 100,
+          [] { return std::make_unique<Peers>(); },
+          [](auto& f) {
+              for (int i = 0; i < 100; ++i) {
+                  f->sa->advance(uint16_t(f->gen() & 0x7F));
+                  f->sb->advance(uint16_t(f->gen() & 0x7F));
+                  f->link.advance();
+              }
+              if (f->sa->isDesynced() || f->sb->isDesynced()) {
+                  std::cerr << "RollbackSession::advance : pairs desynchronises" << std::endl;
+                  std::exit(1);
+              }
+          });
+}
+
+// Télémétrie : coût côté jeu d'un événement (le thread d'écriture vide l'anneau en parallèle).
+void benchTelemetry(Runner& r) {
+    std::string path = (std::filesystem::temp_directory_path() / "soulworld_bench.swt").string();
+    r.run("TelemetryLog::record", "events=1000", 1000,
+          [path] { return TelemetryLog::open(path); },
+          [](auto& log) {
+              for (int i = 0; i < 1000; ++i)
+                  log->record(TelemetryLog::EventType::EnemyKill, uint8_t(i & 3), 1, i, {float(i), 0.f});
+          });
+    std::filesystem::remove(path);
+}
+
+// Portées chronométrées : un test tant que la capture est coupée, deux
+// lectures d'horloge et une écriture dans l'anneau du thread ensuite.
+// enable() est définitif : ce banc passe en dernier.
+void benchHitchTrace(Runner& r) {
+    auto scopes = [](int&) {
+        for (int i = 0; i < 1000; ++i) TraceScope scope("bench");
+    };
+    r.run("TraceScope", "scopes=1000,disabled", 1000, [] { return 0; }, scopes);
+    HitchTrace::enable();
+    r.run("TraceScope", "scopes=1000,enabled", 1000, [] { return 0; }, scopes);
+}
+
+} // namespace Bench
+
+int main(int argc, char** argv) {
+    Bench::Runner runner;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) runner.filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) runner.minTime = std::atof(argv[++i]);
+        else {
+            std::fprintf(stderr, "Usage: %s [--filter <nom>] [--min-time <s>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Bench::benchParticles(runner);
+    Bench::benchCollision(runner);
+    Bench::benchInput(runner);
+    Bench::benchProjectiles(runner);
+    Bench::benchWaves(runner);
+    Bench::benchSlotMap(runner);
+    Bench::benchSnapshots(runner);
+    Bench::benchEnemies(runner);
+    Bench::benchRollback(runner);
+    Bench::benchTelemetry(runner);
+    Bench::benchHitchTrace(runner);
+
+    runner.writeJson(stdout);
+    return 0;
+}
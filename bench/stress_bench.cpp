@@ -0,0 +1,353 @@
+// ============================================================================
+// SOUL WORLD - Benchmark de stress hors écran
+// ============================================================================
+//
+// Rend le vrai jeu dans une sf::RenderTexture (fonctionne sous Mesa llvmpipe,
+// sans écran ni GPU) pendant un nombre fixe de ticks, d'après un scénario.
+//
+// Usage : soulworld_stress [--scenario fichier] [cle=valeur ...]
+// Sortie : JSON sur stdout (percentiles de frame, split simulation/rendu,
+// mémoire crête, hash de la dernière image).
+
+#define SOUL_WORLD_NO_MAIN
+#include "../main.cpp"
+
+#include <SFML/OpenGL.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(_WIN32)
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace Stress {
+
+struct Scenario {
+    int redEnemies = 30;
+    int blueEnemies = 20;
+    int yellowEnemies = 20;
+    float projectilesPerSecond = 20.f;
+    int particlesPerTick = 40;
+    int platforms = 60;
+    int wave = 10;
+    int ticks = 1800;
+    unsigned int seed = 1234;
+    bool governor = false; // qualité adaptative : le hash de la dernière image dépend alors du timing
+    bool allocCheck = false; // échoue si une frame de jeu alloue après allocWarmup ticks
+    int allocWarmup = 120;
+    float hitchMs = 0; // > 0 : trace Chrome (hitch_<n>.json) des frames plus longues
+    bool dynamicResolution = false; // monde rendu en résolution réduite selon le temps de rendu
+    std::string level;
+    unsigned int width = Config::WINDOW_WIDTH;
+    unsigned int height = Config::WINDOW_HEIGHT;
+
+    bool set(const std::string& key, const std::string& value) {
+        if (key == "enemies_red") redEnemies = std::stoi(value);
+        else if (key == "enemies_blue") blueEnemies = std::stoi(value);
+        else if (key == "enemies_yellow") yellowEnemies = std::stoi(value);
+        else if (key == "projectiles_per_second") projectilesPerSecond = std::stof(value);
+        else if (key == "particles_per_tick") particlesPerTick = std::stoi(value);
+        else if (key == "platforms") platforms = std::stoi(value);
+        else if (key == "wave") wave = std::stoi(value);
+        else if (key == "ticks") ticks = std::stoi(value);
+        else if (key == "seed") seed = unsigned(std::stoul(value));
+        else if (key == "governor") governor = std::stoi(value) != 0;
+        else if (key == "alloc_check") allocCheck = std::stoi(value) != 0;
+        else if (key == "alloc_warmup") allocWarmup = std::stoi(value);
+        else if (key == "hitch_ms") hitchMs = std::stof(value);
+        else if (key == "dynamic_resolution") dynamicResolution = std::stoi(value) != 0;
+        else if (key == "level") level = value;
+        else if (key == "width") width = unsigned(std::stoul(value));
+        else if (key == "height") height = unsigned(std::stoul(value));
+        else return false;
+        return true;
+    }
+
+    bool parseLine(const std::string& raw) {
+        std::string line = raw.substr(0, raw.find('#'));
+        auto eq = line.find('=');
+        if (eq == std::string::npos) return line.find_first_not_of(" \t\r") == std::string::npos;
+        auto trim = [](std::string v) {
+            v.erase(0, v.find_first_not_of(" \t"));
+            v.erase(v.find_last_not_of(" \t\r") + 1);
+            return v;
+        };
+        return set(trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!parseLine(line)) {
+                std::cerr << "Scenario: ligne invalide: " << line << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct Percentiles {
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;
+};
+
+Percentiles percentiles(std::vector<double> samples) {
+    Percentiles p;
+    if (samples.empty()) return p;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[std::min(samples.size() - 1, size_t(q * samples.size()))]; };
+    double sum = 0;
+    for (double s : samples) sum += s;
+    p.mean = sum / samples.size();
+    p.p50 = at(0.5);
+    p.p90 = at(0.9);
+    p.p99 = at(0.99);
+    p.max = samples.back();
+    return p;
+}
+
+size_t peakMemoryBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize;
+    return 0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return size_t(usage.ru_maxrss);
+#else
+    return size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+uint64_t hashImage(const sf::Image& image) {
+    uint64_t h = 1469598103934665603ull;
+    const uint8_t* px = image.getPixelsPtr();
+    size_t n = size_t(image.getSize().x) * image.getSize().y * 4;
+    for (size_t i = 0; i < n; ++i) { h ^= px[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+// Le niveau du scénario complète celui de base avec des plateformes aléatoires.
+Level buildLevel(const Level& base, const Scenario& sc, Random& rng) {
+    LevelBuilder builder = LevelBuilder::from(base);
+    const LevelBounds bounds = base.bounds();
+    for (size_t i = base.platformCount(); i < size_t(std::max(sc.platforms, 0)); ++i) {
+        float w = rng.range(100.f, 300.f);
+        builder.platform({w, 25.f}, {rng.range(150.f, bounds.width - 150.f - w), rng.range(250.f, bounds.floorY - 80.f)}, true);
+    }
+    return *Level::fromBytes(builder.build());
+}
+
+void setupWorld(World& world, const Scenario& sc, Random& rng) {
+    world.getWaveManager().startWave(sc.wave);
+    world.getPlayer().setGodMode(true);
+
+    const LevelBounds& bounds = world.getBounds();
+
+    auto spawn = [&](int count, Enemy::Type type) {
+        for (int i = 0; i < count; ++i)
+            world.spawnEnemy({rng.range(200.f, bounds.width - 200.f), bounds.floorY - 30.f}, type);
+    };
+    spawn(sc.redEnemies, Enemy::Type::Red);
+    spawn(sc.blueEnemies, Enemy::Type::Blue);
+    spawn(sc.yellowEnemies, Enemy::Type::Yellow);
+
+    // Comme le jeu pendant l'écran d'améliorations : la vague puise dans la réserve.
+    world.prewarmWave(sc.wave);
+}
+
+void injectLoad(World& world, const Scenario& sc, float dt, float& projectileBudget, Random& rng) {
+    sf::Vector2f playerPos = world.getPlayer().getPosition();
+
+    projectileBudget += sc.projectilesPerSecond * dt;
+    while (projectileBudget >= 1.f) {
+        projectileBudget -= 1.f;
+        sf::Vector2f from = playerPos + sf::Vector2f{rng.range(-900.f, 900.f), rng.range(-500.f, -100.f)};
+        world.spawnProjectile(from, playerPos - from, rng.range(150.f, 300.f), sf::Color(100, 150, 255));
+    }
+
+    if (sc.particlesPerTick > 0) {
+        ParticleConfig cfg;
+        cfg.gradient = ParticleGradient::fade(sf::Color(255, 180, 90, 220), sf::Color(200, 60, 40, 0));
+        cfg.spread = 3.14159f;
+        cfg.minLife = 0.8f; cfg.maxLife = 1.6f;
+        world.emitEffect(playerPos + sf::Vector2f{rng.range(-800.f, 800.f), rng.range(-400.f, 200.f)},
+                         cfg, sc.particlesPerTick);
+    }
+}
+
+} // namespace Stress
+
+int main(int argc, char** argv) {
+    using namespace Stress;
+    using Clock = std::chrono::steady_clock;
+
+    Scenario sc;
+    std::string scenarioName = "default";
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--scenario") && i + 1 < argc) {
+            scenarioName = argv[++i];
+            if (!sc.load(scenarioName)) {
+                std::cerr << "Scenario illisible: " << scenarioName << std::endl;
+                return 2;
+            }
+        } else if (!sc.parseLine(argv[i])) {
+            std::cerr << "Usage: " << argv[0] << " [--scenario fichier] [cle=valeur ...]" << std::endl;
+            return 2;
+        }
+    }
+
+    if (sc.allocCheck && !AllocTracking::ENABLED) {
+        std::cerr << "alloc_check demande un build avec SOUL_WORLD_TRACK_ALLOCS (soulworld_stress_allocs)" << std::endl;
+        return 2;
+    }
+
+    // Tirages du scénario (plateformes, ennemis, projectiles) ; le monde a les siens.
+    Random rng(sc.seed);
+
+    sf::RenderTexture target;
+    if (!target.resize({sc.width, sc.height})) {
+        std::cerr << "Impossible de creer la RenderTexture" << std::endl;
+        return 1;
+    }
+
+    Game game(false);
+    if (!sc.level.empty() && !game.loadLevel(sc.level)) {
+        std::cerr << "Niveau illisible: " << sc.level << std::endl;
+        return 1;
+    }
+    game.getWorld().loadLevel(buildLevel(game.getWorld().getLevel(), sc, rng));
+    game.getWorld().seed(sc.seed);
+    game.startNewGame();
+    if (sc.dynamicResolution) game.enableDynamicResolution();
+    setupWorld(game.getWorld(), sc, rng);
+
+    constexpr float dt = 1.f / 60.f;
+    float projectileBudget = 0;
+    std::vector<double> simMs, renderMs, frameMs;
+    simMs.reserve(sc.ticks);
+    renderMs.reserve(sc.ticks);
+    frameMs.reserve(sc.ticks);
+    size_t peakEnemies = 0, peakProjectiles = 0, peakChunkBytes = 0, peakChunks = 0;
+    std::array<int, QualityLevels::COUNT> qualityFrames{};
+    int allocatingFrames = 0; // frames de jeu qui allouent après le préchauffage
+    double scaleSum = 0;
+    std::unique_ptr<HitchCapture> hitches;
+    if (sc.hitchMs > 0) {
+        HitchCapture::Settings settings;
+        settings.thresholdMs = sc.hitchMs;
+        hitches = std::make_unique<HitchCapture>(settings);
+    }
+
+    for (int tick = 0; tick < sc.ticks; ++tick) {
+        if (tick == sc.allocWarmup) AllocTracking::resetSummary();
+        AllocTracking::beginFrame();
+        int64_t frameStart = HitchTrace::now();
+        auto t0 = Clock::now();
+        injectLoad(game.getWorld(), sc, dt, projectileBudget, rng);
+        game.update(dt);
+        auto t1 = Clock::now();
+        game.render(target);
+        target.display();
+        glFinish();
+        auto t2 = Clock::now();
+        if (hitches) hitches->endFrame(frameStart, HitchTrace::now());
+        AllocTracking::FrameStats allocs = AllocTracking::endFrame();
+        if (AllocTracking::ENABLED && tick >= sc.allocWarmup && allocs.total.allocs && game.getState() == GameState::Playing) {
+            if (sc.allocCheck && allocatingFrames < 5) {
+                std::cerr << "Frame " << tick << " : " << allocs.total.allocs << " allocations (";
+                for (size_t i = 0; i < AllocTracking::SCOPE_COUNT; ++i)
+                    if (allocs.scopes[i].allocs) std::cerr << ' ' << AllocTracking::NAMES[i] << '=' << allocs.scopes[i].allocs;
+                std::cerr << " )" << std::endl;
+            }
+            ++allocatingFrames;
+        }
+
+        double sim = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double ren = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        simMs.push_back(sim);
+        renderMs.push_back(ren);
+        frameMs.push_back(sim + ren);
+        if (sc.governor) game.sampleFrameTime(float(sim + ren));
+        game.sampleRenderTime(float(ren));
+        scaleSum += game.getResolution().getScale();
+        ++qualityFrames[game.getQuality().getLevel()];
+        peakEnemies = std::max(peakEnemies, game.getWorld().getEnemyCount());
+        peakProjectiles = std::max(peakProjectiles, game.getWorld().getProjectileCount());
+        peakChunkBytes = std::max(peakChunkBytes, game.getWorld().getStreamer().getResidentBytes());
+        peakChunks = std::max(peakChunks, game.getWorld().getStreamer().getResidentCount());
+    }
+
+    if (hitches) hitches->finish();
+    uint64_t frameHash = hashImage(target.getTexture().copyToImage());
+    Percentiles frame = percentiles(frameMs), sim = percentiles(simMs), ren = percentiles(renderMs);
+
+    auto printStats = [](const char* name, const Percentiles& p, bool last) {
+        std::printf("    \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+                    name, p.mean, p.p50, p.p90, p.p99, p.max, last ? "" : ",");
+    };
+
+    std::printf("{\n");
+    std::printf("  \"scenario\": {\"name\": \"%s\", \"enemies_red\": %d, \"enemies_blue\": %d, "
+                "\"enemies_yellow\": %d, \"projectiles_per_second\": %.2f, \"particles_per_tick\": %d, "
+                "\"platforms\": %d, \"wave\": %d, \"ticks\": %d, \"seed\": %u, \"width\": %u, \"height\": %u, "
+                "\"governor\": %d, \"level\": \"%s\"},\n",
+                scenarioName.c_str(), sc.redEnemies, sc.blueEnemies, sc.yellowEnemies, sc.projectilesPerSecond,
+                sc.particlesPerTick, sc.platforms, sc.wave, sc.ticks, sc.seed, sc.width, sc.height, int(sc.governor),
+                sc.level.empty() ? "builtin" : sc.level.c_str());
+    std::printf("  \"frame_ms\": {\n");
+    printStats("total", frame, false);
+    printStats("simulation", sim, false);
+    printStats("render", ren, true);
+    std::printf("  },\n");
+    std::printf("  \"peak_enemies\": %zu,\n  \"peak_projectiles\": %zu,\n", peakEnemies, peakProjectiles);
+    std::printf("  \"peak_resident_chunks\": %zu,\n  \"peak_chunk_bytes\": %zu,\n", peakChunks, peakChunkBytes);
+    std::printf("  \"peak_frame_arena_bytes\": %zu,\n  \"frame_arena_overflows\": %zu,\n",
+                game.getFrameArena().getPeak(), game.getFrameArena().getOverflowCount());
+    std::printf("  \"quality\": {\"governor\": %s, \"final_level\": %d, \"changes\": %zu, \"frames_per_level\": [",
+                sc.governor ? "true" : "false", game.getQuality().getLevel(), game.getQuality().getChangeCount());
+    for (int l = 0; l < QualityLevels::COUNT; ++l) std::printf("%s%d", l ? ", " : "", qualityFrames[l]);
+    std::printf("]},\n");
+    std::printf("  \"resolution\": {\"dynamic\": %s, \"final_scale\": %.3f, \"mean_scale\": %.3f, \"changes\": %zu},\n",
+                sc.dynamicResolution ? "true" : "false", game.getResolution().getScale(),
+                scaleSum / std::max(1, sc.ticks), game.getResolution().getChangeCount());
+    if (AllocTracking::ENABLED) {
+        const AllocTracking::Summary& allocs = AllocTracking::summary();
+        std::printf("  \"allocations\": {\"warmup_ticks\": %d, \"frames\": %zu, \"frames_allocating\": %zu, "
+                    "\"peak_live_bytes\": %zu, \"scopes\": {",
+                    sc.allocWarmup, allocs.frames, allocs.framesWithAllocs, allocs.peakLiveBytes);
+        bool first = true;
+        for (size_t i = 0; i < AllocTracking::SCOPE_COUNT; ++i) {
+            const AllocTracking::ScopeSummary& scope = allocs.scopes[i];
+            if (!scope.allocs) continue;
+            std::printf("%s\"%s\": {\"allocs\": %zu, \"bytes\": %zu, \"frames_hit\": %zu, \"worst_frame\": %zu}",
+                        first ? "" : ", ", AllocTracking::NAMES[i], scope.allocs, scope.bytes, scope.framesHit, scope.worstFrame);
+            first = false;
+        }
+        std::printf("}},\n");
+        AllocTracking::report(std::cerr);
+    }
+    if (hitches)
+        std::printf("  \"hitches\": {\"threshold_ms\": %.2f, \"captured\": %zu, \"written\": %zu, \"skipped\": %zu},\n",
+                    hitches->getThresholdMs(), hitches->getCaptured(), hitches->getWritten(), hitches->getSkipped());
+    std::printf("  \"peak_memory_bytes\": %zu,\n", peakMemoryBytes());
+    std::printf("  \"final_frame_hash\": \"%016llx\"\n}\n", (unsigned long long)frameHash);
+    if (sc.allocCheck && allocatingFrames) {
+        std::cerr << "alloc_check : " << allocatingFrames << " frames de jeu allouent apres " << sc.allocWarmup
+                  << " ticks de prechauffage" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3,6 +3,7 @@
 // ============================================================================
 
 #include <SFML/Graphics.hpp>
+#include <SFML/Network.hpp>
 #include <vector>
 #include <memory>
 #include <unordered_map>
@@ -12,6 +13,42 @@
 #include <optional>
 #include <algorithm>
 #include <functional>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <array>
+#include <string_view>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <set>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <new>
+#include <coroutine>
+#include <bit>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // ============================================================================
 // CONFIGURATION
@@ -33,20 +70,453 @@ namespace Config {
     constexpr int MAX_SOUL_ENERGY = 100;
     constexpr float ENEMY_FLY_DURATION = 7.0f;
     constexpr float ENEMY_FLY_COOLDOWN = 5.0f;
+    constexpr float CHUNK_WIDTH = 1024.f;
+    constexpr float CHUNK_ACTIVE_MARGIN = 512.f;
+    constexpr float CHUNK_PREFETCH_MARGIN = 2048.f;
+    constexpr size_t STREAMING_MEMORY_BUDGET = 4 * 1024 * 1024;
+    constexpr float BACKGROUND_PARALLAX[] = {0.1f, 0.3f, 0.5f};
+    constexpr const char* ASSET_PACK_PATH = "assets.swp";
+    constexpr const char* QUICKSAVE_PATH = "quicksave.sws";
+    constexpr const char* ATLAS_CACHE_SUBDIR = "soulworld"; // dans le cache utilisateur : atlas_<empreinte>.swa
+    constexpr size_t MAX_PLAYERS = 2;
+    constexpr float FIXED_DT = 1.f / 60.f;
+    constexpr int ROLLBACK_WINDOW = 8;
+    constexpr int NETPLAY_INPUT_DELAY = 2;
+    constexpr unsigned int NETPLAY_SEED = 0x5EED;
+    constexpr size_t FRAME_ARENA_BYTES = 4 * 1024 * 1024;
+    constexpr float AI_FULL_RATE_RADIUS = 1200.f;
+    constexpr size_t AI_FAR_THINKS_PER_TICK = 32;
+    constexpr float FRAME_BUDGET_MS = 1000.f / 60.f;
+    constexpr float RENDER_BUDGET_MS = 10.f; // rendu du monde, pour la résolution dynamique
+    constexpr float RENDER_SCALE_MIN = 0.5f;
+    constexpr float RENDER_SCALE_STEP = 0.125f;
+    constexpr size_t PREWARM_PROJECTILES = 64;
+    constexpr size_t MAX_PROJECTILES = 512; // plafond en jeu, place réservée au démarrage
+    constexpr float HITCH_THRESHOLD_MS = 20.f;
 }
 
+// ============================================================================
+// CAPTURE DES À-COUPS (TRACE CHROME)
+// ============================================================================
+
+// Chaque thread garde ses derniers intervalles chronométrés (TraceScope) dans
+// un anneau de taille fixe, sans verrou. HitchCapture surveille la durée des
+// frames et, au-delà d'un seuil, recopie la fenêtre autour de l'à-coup ; un
+// thread d'écriture la sauve en JSON « trace event » (Perfetto,
+// chrome://tracing). Tant que enable() n'a pas été appelé, une portée ne
+// coûte qu'un test.
+namespace HitchTrace {
+
+constexpr size_t MAX_THREADS = 16;
+constexpr size_t EVENTS_PER_THREAD = 1 << 12; // puissance de deux
+constexpr size_t HISTORY_FRAMES = 300;
+
+struct Event {
+    const char* name; // littéral : doit vivre aussi longtemps que le programme
+    int64_t startNs, durationNs;
+};
+
+struct TracedEvent {
+    Event event;
+    uint32_t thread; // indice de l'anneau
+};
+
+namespace detail {
+// Entrée lue pendant que son thread la réécrit : champs atomiques relâchés,
+// encadrés par seq (verrou de séquence). seq vaut l'indice + 1 une fois
+// l'entrée écrite, 0 pendant l'écriture ; une lecture qui ne retrouve pas la
+// même valeur avant et après a vu une entrée en cours et l'ignore.
+struct Entry {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> startNs{0}, durationNs{0};
+};
+
+struct ThreadRing {
+    std::array<Entry, EVENTS_PER_THREAD> entries;
+    std::atomic<uint64_t> head{0};
+    std::atomic<const char*> name{nullptr}; // nullptr : anneau libre
+    std::atomic<bool> taken{false};
+    std::atomic<uint32_t> owner{0}; // incrémenté à chaque prise et à chaque rendu
+};
+
+// Anneaux alloués une fois par enable() (thread de jeu), jamais libérés avant
+// la sortie. Les autres threads démarrent avant : rings et enabled sont
+// publiés en release et lus en acquire.
+inline std::unique_ptr<ThreadRing[]> ringStorage;
+inline std::atomic<ThreadRing*> rings{nullptr};
+inline std::atomic<bool> enabled{false};
+inline thread_local const char* threadName = nullptr;
+
+// Rend l'anneau à la fin du thread : les threads recréés à chaque chargement
+// de niveau ou partie en réseau n'épuisent pas les MAX_THREADS anneaux, et un
+// thread terminé disparaît des traces suivantes.
+struct RingLease {
+    ThreadRing* ring = nullptr;
+
+    ~RingLease() {
+        if (!ring) return;
+        ring->name.store(nullptr, std::memory_order_relaxed);
+        ring->owner.fetch_add(1, std::memory_order_release);
+        ring->taken.store(false, std::memory_order_release);
+    }
+};
+
+// Anneau du thread appelant, pris au premier événement dans un anneau libre ;
+// nullptr s'il n'en reste plus (nouvel essai à l'événement suivant).
+inline ThreadRing* claim() {
+    thread_local RingLease lease;
+    if (lease.ring) return lease.ring;
+    ThreadRing* all = rings.load(std::memory_order_acquire);
+    if (!all) return nullptr; // capture pas encore activée
+    for (size_t i = 0; i < MAX_THREADS; ++i) {
+        ThreadRing& ring = all[i];
+        bool expected = false;
+        if (ring.taken.load(std::memory_order_relaxed) ||
+            !ring.taken.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            continue;
+        // Les entrées du propriétaire précédent sont hors de [0, head) : invisibles.
+        ring.owner.fetch_add(1, std::memory_order_relaxed);
+        ring.head.store(0, std::memory_order_relaxed);
+        ring.name.store(threadName ? threadName : "thread", std::memory_order_release);
+        lease.ring = &ring;
+        return lease.ring;
+    }
+    return nullptr;
+}
+} // namespace detail
+
+inline int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline bool isEnabled() { return detail::enabled.load(std::memory_order_acquire); }
+
+// Nom du thread appelant dans la trace ; à appeler au début du thread.
+inline void nameThread(const char* name) { detail::threadName = name; }
+
+inline void enable() {
+    if (!detail::ringStorage) {
+        detail::ringStorage = std::make_unique<detail::ThreadRing[]>(MAX_THREADS);
+        detail::rings.store(detail::ringStorage.get(), std::memory_order_release);
+    }
+    detail::enabled.store(true, std::memory_order_release);
+}
+
+inline void record(const char* name, int64_t startNs, int64_t endNs) {
+    detail::ThreadRing* ring = detail::claim();
+    if (!ring) return;
+    uint64_t h = ring->head.load(std::memory_order_relaxed);
+    detail::Entry& e = ring->entries[h & (EVENTS_PER_THREAD - 1)];
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // seq à 0 visible avant les champs
+    e.name.store(name, std::memory_order_relaxed);
+    e.startNs.store(startNs, std::memory_order_relaxed);
+    e.durationNs.store(endNs - startNs, std::memory_order_relaxed);
+    e.seq.store(h + 1, std::memory_order_release);
+    ring->head.store(h + 1, std::memory_order_release);
+}
+
+// Copie les événements de tous les threads qui recoupent [fromNs, toNs], et
+// le nom de chaque anneau tenu par un thread (nullptr pour un anneau libre).
+// Les anneaux sont lus pendant que leurs threads écrivent : chaque entrée est
+// validée par son numéro de séquence (une entrée réécrite ou en cours
+// d'écriture est sautée), et un anneau rendu ou repris pendant la copie est
+// écarté.
+inline void collect(int64_t fromNs, int64_t toNs, std::vector<TracedEvent>& out,
+                    std::array<const char*, MAX_THREADS>& names) {
+    names.fill(nullptr);
+    detail::ThreadRing* rings = detail::rings.load(std::memory_order_acquire);
+    if (!rings) return;
+    for (size_t t = 0; t < MAX_THREADS; ++t) {
+        detail::ThreadRing& ring = rings[t];
+        uint32_t owner = ring.owner.load(std::memory_order_acquire);
+        const char* name = ring.name.load(std::memory_order_acquire);
+        if (!name) continue;
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+        size_t mark = out.size();
+        for (uint64_t i = first; i < head; ++i) {
+            const detail::Entry& entry = ring.entries[i & (EVENTS_PER_THREAD - 1)];
+            if (entry.seq.load(std::memory_order_acquire) != i + 1) continue;
+            Event e{entry.name.load(std::memory_order_relaxed), entry.startNs.load(std::memory_order_relaxed),
+                    entry.durationNs.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire); // champs lus avant de relire seq
+            if (entry.seq.load(std::memory_order_relaxed) != i + 1) continue;
+            if (e.startNs + e.durationNs >= fromNs && e.startNs <= toNs) out.push_back({e, uint32_t(t)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (ring.owner.load(std::memory_order_relaxed) != owner) {
+            out.resize(mark);
+            continue;
+        }
+        names[t] = name;
+    }
+}
+
+// Anneau du thread appelant (identifiant dans la trace), MAX_THREADS s'il n'en a pas.
+inline size_t threadIndex() {
+    detail::ThreadRing* ring = detail::claim();
+    return ring ? size_t(ring - detail::rings.load(std::memory_order_acquire)) : MAX_THREADS;
+}
+
+// Chronomètre le bloc sur le thread courant.
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(isEnabled() ? name : nullptr), start(this->name ? now() : 0) {}
+    ~TraceScope() { if (name) record(name, start, now()); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+} // namespace HitchTrace
+
+using HitchTrace::TraceScope;
+
+// Suit la durée des frames (thread de jeu uniquement). Une frame au-delà du
+// seuil arme une capture : framesAfter frames plus tard, les événements de
+// framesBefore frames avant jusqu'à maintenant sont recopiés dans un tampon
+// réservé d'avance, et le thread d'écriture produit hitch_<n>.json. Pendant
+// une écriture, les nouveaux à-coups sont seulement comptés.
+class HitchCapture {
+public:
+    struct Settings {
+        float thresholdMs = Config::HITCH_THRESHOLD_MS;
+        int framesBefore = 120, framesAfter = 30; // ensemble < HISTORY_FRAMES
+        std::string directory = ".";
+    };
+
+    explicit HitchCapture(Settings s) : settings(std::move(s)) {
+        settings.framesBefore = std::clamp(settings.framesBefore, 0, int(HitchTrace::HISTORY_FRAMES) / 2);
+        settings.framesAfter = std::clamp(settings.framesAfter, 0, int(HitchTrace::HISTORY_FRAMES) / 2 - 1);
+        pending.reserve(HitchTrace::MAX_THREADS * HitchTrace::EVENTS_PER_THREAD);
+        HitchTrace::nameThread("jeu");
+        HitchTrace::enable();
+        writer = std::thread([this] { writerLoop(); });
+    }
+
+    ~HitchCapture() { finish(); }
+
+    HitchCapture(const HitchCapture&) = delete;
+    HitchCapture& operator=(const HitchCapture&) = delete;
+
+    // Fin de frame, bornes en HitchTrace::now().
+    void endFrame(int64_t startNs, int64_t endNs) {
+        HitchTrace::record("frame", startNs, endNs);
+        frames[frameCount % HitchTrace::HISTORY_FRAMES] = {startNs, endNs};
+        ++frameCount;
+
+        if (framesUntilCapture < 0) {
+            float ms = float(endNs - startNs) / 1e6f;
+            if (ms <= settings.thresholdMs) return;
+            if (busy.load(std::memory_order_acquire)) {
+                ++skipped;
+                return;
+            }
+            hitchFrame = frameCount - 1;
+            hitchMs = ms;
+            framesUntilCapture = settings.framesAfter;
+        }
+        if (framesUntilCapture-- > 0) return;
+        capture(endNs);
+    }
+
+    // Termine l'écriture en cours et arrête le thread d'écriture ; une capture
+    // armée mais pas encore recopiée est perdue.
+    void finish() {
+        running.store(false, std::memory_order_release);
+        if (writer.joinable()) writer.join();
+    }
+
+    float getThresholdMs() const { return settings.thresholdMs; }
+    size_t getCaptured() const { return captured; }
+    size_t getSkipped() const { return skipped; }
+    size_t getWritten() const { return written.load(std::memory_order_relaxed); }
+
+private:
+    struct FrameMark {
+        int64_t startNs, endNs;
+    };
+
+    void capture(int64_t endNs) {
+        uint64_t first = hitchFrame - std::min<uint64_t>(hitchFrame, uint64_t(settings.framesBefore));
+        const FrameMark& hitch = frames[hitchFrame % HitchTrace::HISTORY_FRAMES];
+        pending.clear();
+        HitchTrace::collect(frames[first % HitchTrace::HISTORY_FRAMES].startNs, endNs, pending, pendingNames);
+        pendingHitch = hitch;
+        pendingMs = hitchMs;
+        pendingThread = HitchTrace::threadIndex();
+        ++captured;
+        busy.store(true, std::memory_order_release);
+    }
+
+    // Thread d'écriture : attend une capture, comme le journal de télémétrie.
+    void writerLoop() {
+        for (;;) {
+            if (busy.load(std::memory_order_acquire)) {
+                writeTrace();
+                busy.store(false, std::memory_order_release);
+                continue;
+            }
+            if (!running.load(std::memory_order_acquire)) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    // Horodatages en microsecondes depuis le début de la fenêtre.
+    void writeTrace() {
+        std::string path = settings.directory + "/hitch_" + std::to_string(written.load(std::memory_order_relaxed) + 1) + ".json";
+        std::ofstream out(path);
+        if (!out) {
+            std::cerr << "Trace d'a-coup impossible a ecrire: " << path << std::endl;
+            return;
+        }
+        int64_t origin = pendingHitch.startNs;
+        for (const auto& e : pending) origin = std::min(origin, e.event.startNs);
+        auto us = [origin](int64_t ns) { return double(ns - origin) / 1000.0; };
+
+        char line[256];
+        out << "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"hitch_ms\": " << pendingMs
+            << ", \"threshold_ms\": " << settings.thresholdMs << "},\n\"traceEvents\": [\n";
+        for (size_t t = 0; t < pendingNames.size(); ++t) {
+            if (!pendingNames[t]) continue;
+            std::snprintf(line, sizeof(line), "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %zu, \"args\": {\"name\": \"%s\"}},\n",
+                          t + 1, pendingNames[t]);
+            out << line;
+        }
+        for (const auto& e : pending) {
+            std::snprintf(line, sizeof(line), "{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u},\n",
+                          e.event.name, us(e.event.startNs), double(e.event.durationNs) / 1000.0, e.thread + 1);
+            out << line;
+        }
+        std::snprintf(line, sizeof(line), "{\"name\": \"a-coup\", \"ph\": \"i\", \"s\": \"g\", \"ts\": %.3f, \"pid\": 1, \"tid\": %zu, \"args\": {\"ms\": %.2f}}\n]}\n",
+                      us(pendingHitch.startNs), pendingThread + 1, pendingMs);
+        out << line;
+        if (!out) {
+            std::cerr << "Trace d'a-coup incomplete: " << path << std::endl;
+            return;
+        }
+        written.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "A-coup de " << pendingMs << " ms : trace ecrite dans " << path << std::endl;
+    }
+
+    Settings settings;
+    std::array<FrameMark, HitchTrace::HISTORY_FRAMES> frames{};
+    uint64_t frameCount = 0, hitchFrame = 0;
+    int framesUntilCapture = -1; // -1 : aucune capture armée
+    float hitchMs = 0;
+    size_t captured = 0, skipped = 0;
+
+    // Capture remise au thread d'écriture (busy vrai : il en est propriétaire).
+    std::vector<HitchTrace::TracedEvent> pending;
+    std::array<const char*, HitchTrace::MAX_THREADS> pendingNames{}; // anneaux tenus au moment de la copie
+    FrameMark pendingHitch{};
+    size_t pendingThread = 0;
+    float pendingMs = 0;
+    std::atomic<bool> busy{false}, running{true};
+    std::atomic<size_t> written{0};
+    std::thread writer;
+};
+
+// ============================================================================
+// CHARGEMENT ASYNCHRONE DES RESSOURCES
+// ============================================================================
+
+// Petit pool de threads pour les ressources (polices, niveaux) : submit()
+// renvoie un std::future, le jeu l'interroge sans bloquer à chaque frame.
+class AssetLoader {
+public:
+    explicit AssetLoader(unsigned int threads = std::clamp(std::thread::hardware_concurrency(), 1u, 4u)) {
+        for (unsigned int i = 0; i < threads; ++i) workers.emplace_back([this] { workerLoop(); });
+    }
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Les tâches non commencées sont abandonnées (leurs futures restent sans valeur).
+    ~AssetLoader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            tasks.clear();
+        }
+        cv.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    template <typename Fn>
+    auto submit(Fn fn) -> std::future<std::invoke_result_t<Fn>> {
+        using Result = std::invoke_result_t<Fn>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(fn));
+        std::future<Result> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace_back([task] { (*task)(); });
+            ++submitted;
+        }
+        cv.notify_one();
+        return result;
+    }
+
+    // Fraction des tâches soumises déjà terminées (barre de progression).
+    float progress() const {
+        unsigned int total = submitted.load();
+        return total == 0 ? 1.f : float(completed.load()) / float(total);
+    }
+
+    template <typename T>
+    static bool isReady(const std::future<T>& f) {
+        return f.valid() && f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+private:
+    void workerLoop() {
+        HitchTrace::nameThread("ressources");
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            {
+                TraceScope scope("AssetLoader::task");
+                task();
+            }
+            ++completed;
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    std::atomic<unsigned int> submitted{0}, completed{0};
+    bool stopping = false;
+};
+
 // ============================================================================
 // GESTIONNAIRE DE POLICE
 // ============================================================================
 
+// Police de l'interface, possédée par le jeu et prêtée aux menus et au HUD.
 class FontManager {
 public:
-    static FontManager& instance() {
-        static FontManager inst;
-        return inst;
-    }
+    bool loadFont() { return setFont(findFont()); }
+
+    // Statique : peut tourner sur un thread de AssetLoader.
+    // packed : police du paquet de ressources, essayée avant les chemins système.
+    static std::optional<sf::Font> findFont(const void* packed = nullptr, size_t packedSize = 0) {
+        sf::Font found;
+        if (packed && found.openFromMemory(packed, packedSize)) return found;
 
-    bool loadFont() {
         std::vector<std::string> fontPaths = {
             "/usr/share/fonts/TTF/DejaVuSans.ttf",
             "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
@@ -69,23 +539,32 @@ public:
         };
 
         for (const auto& path : fontPaths) {
-            if (font.openFromFile(path)) {
+            if (found.openFromFile(path)) {
                 std::cout << "Police chargee: " << path << std::endl;
-                fontLoaded = true;
-                return true;
+                return found;
             }
         }
 
         std::cerr << "ATTENTION: Aucune police trouvee!" << std::endl;
-        fontLoaded = false;
-        return false;
+        return std::nullopt;
     }
 
-    sf::Font& getFont() { return font; }
+    // memory : garde en vie les octets d'une police ouverte avec openFromMemory.
+    bool setFont(std::optional<sf::Font> loaded, std::shared_ptr<const void> memory = nullptr) {
+        fontLoaded = loaded.has_value();
+        if (loaded) {
+            font = std::move(*loaded);
+            fontMemory = std::move(memory);
+        }
+        return fontLoaded;
+    }
+
+    const sf::Font& getFont() const { return font; }
     bool isLoaded() const { return fontLoaded; }
 
 private:
     sf::Font font;
+    std::shared_ptr<const void> fontMemory;
     bool fontLoaded = false;
 };
 
@@ -94,7 +573,7 @@ private:
 // ============================================================================
 
 namespace Math {
-    inline float lerp(float a, float b, float t) {
+    constexpr float lerp(float a, float b, float t) {
         return a + (b - a) * std::clamp(t, 0.f, 1.f);
     }
 
@@ -116,12 +595,13 @@ namespace Math {
     }
 }
 
-class Random {
+// Générateur pseudo-aléatoire par valeur : pas d'état global, chaque monde
+// et chaque système d'effets a le sien (plusieurs mondes en parallèle).
+template <typename Engine>
+class BasicRandom {
 public:
-    static Random& instance() {
-        static Random inst;
-        return inst;
-    }
+    BasicRandom() : gen(std::random_device{}()) {}
+    explicit BasicRandom(unsigned int s) : gen(s) {}
 
     float range(float min, float max) {
         std::uniform_real_distribution<float> dist(min, max);
@@ -139,1191 +619,3700 @@ public:
         return {std::cos(angle) * r, std::sin(angle) * r};
     }
 
+    // Graine fixe pour des exécutions reproductibles (benchmarks).
+    void seed(unsigned int s) { gen.seed(s); }
+
+    // État complet du générateur (instantanés du monde).
+    const Engine& getEngine() const { return gen; }
+    void setEngine(const Engine& e) { gen = e; }
+
 private:
-    std::mt19937 gen{std::random_device{}()};
+    Engine gen;
 };
 
+// Simulation : l'état du générateur entre dans les instantanés du monde.
+using Random = BasicRandom<std::mt19937>;
+
+// Effets visuels (particules, tremblement) : 8 octets, un par système, sans
+// influence sur la simulation. Graines fixes : le rendu reste reproductible.
+using EffectsRandom = BasicRandom<std::minstd_rand>;
+
 // ============================================================================
-// PARTICULES
+// SLOT MAP (HANDLES GÉNÉRATIONNELS)
 // ============================================================================
 
-struct ParticleConfig {
-    sf::Color startColor{255, 255, 255, 255};
-    sf::Color endColor{255, 255, 255, 0};
-    float minSpeed = 50.f, maxSpeed = 150.f;
-    float minLife = 0.5f, maxLife = 1.5f;
-    float minSize = 3.f, maxSize = 8.f;
-    float endSize = 0.f;
-    float direction = -1.57f;
-    float spread = 0.5f;
-    float spawnRadius = 5.f;
-    float rotationSpeed = 2.f;
-};
-
-struct Particle {
-    sf::Vector2f position;
-    sf::Vector2f velocity;
-    sf::Color color, endColor;
-    float life, maxLife;
-    float size, endSize;
-    float rotation, rotationSpeed;
-    bool active = false;
+// Référence stable vers un élément d'un SlotMap. La génération vient d'un
+// compteur du conteneur et n'est jamais réattribuée : un handle vers un
+// élément retiré ne résout plus, même quand son slot a servi à un autre.
+// Elle identifie donc aussi l'élément pour toute sa vie (télémétrie).
+struct SlotHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0; // 0 : handle nul
+
+    explicit operator bool() const { return generation != 0; }
+    bool operator==(const SlotHandle& o) const { return index == o.index && generation == o.generation; }
+    bool operator!=(const SlotHandle& o) const { return !(*this == o); }
 };
 
-class ParticleSystem {
+// Éléments rangés de façon contiguë (itération dense, sans trous) et
+// adressés par handle. Retirer déplace le dernier élément dans le trou :
+// O(1), mais l'ordre d'itération change et les pointeurs vers le dernier
+// élément sont invalidés ; seuls les handles restent valides.
+// Les éléments retirés sont gardés en réserve avec leurs tampons : respawn()
+// les remet à neuf (T::reset) au lieu d'en construire de nouveaux.
+template <typename T>
+class SlotMap {
 public:
-    ParticleSystem(size_t maxParticles = 2000) : particles(maxParticles) {
-        vertices.setPrimitiveType(sf::PrimitiveType::Triangles);
-        vertices.resize(maxParticles * 6);
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    void reserve(size_t n) {
+        values.reserve(n);
+        denseSlot.reserve(n);
+        slots.reserve(n);
+        freeSlots.reserve(n);
+        spares.reserve(n);
     }
 
-    void emit(sf::Vector2f pos, const ParticleConfig& cfg, int count = 1) {
-        for (int i = 0; i < count; ++i) {
-            for (auto& p : particles) {
-                if (!p.active) {
-                    p.active = true;
-                    p.position = pos + Random::instance().insideCircle(cfg.spawnRadius);
-                    float angle = cfg.direction + Random::instance().range(-cfg.spread, cfg.spread);
-                    float speed = Random::instance().range(cfg.minSpeed, cfg.maxSpeed);
-                    p.velocity = {std::cos(angle) * speed, std::sin(angle) * speed};
-                    p.life = p.maxLife = Random::instance().range(cfg.minLife, cfg.maxLife);
-                    p.color = cfg.startColor;
-                    p.endColor = cfg.endColor;
-                    p.size = Random::instance().range(cfg.minSize, cfg.maxSize);
-                    p.endSize = cfg.endSize;
-                    p.rotation = Random::instance().range(0.f, 6.28f);
-                    p.rotationSpeed = Random::instance().range(-cfg.rotationSpeed, cfg.rotationSpeed);
-                    break;
-                }
-            }
-        }
+    // Plafond d'éléments vivants, place réservée d'avance : plein, emplace et
+    // respawn refusent (handle nul) au lieu de réallouer en cours de partie.
+    void setCapacity(size_t n) {
+        capacity = n;
+        reserve(n);
     }
+    bool full() const { return values.size() >= capacity; }
 
-    void update(float dt) {
-        size_t idx = 0;
-        for (auto& p : particles) {
-            if (!p.active) continue;
-            p.life -= dt;
-            if (p.life <= 0) { p.active = false; continue; }
+    // Préchauffage : spareCount éléments construits d'avance (T() : dormant),
+    // et la place pour qu'ils vivent et meurent tous sans réallouer.
+    void prewarm(size_t spareCount) {
+        reserve(values.size() + std::max(spareCount, spares.size()));
+        while (spares.size() < spareCount) spares.emplace_back();
+    }
 
-            float ratio = p.life / p.maxLife;
-            p.velocity.y += gravity * dt;
-            p.velocity *= 1.f - drag * dt;
-            p.position += p.velocity * dt;
-            p.rotation += p.rotationSpeed * dt;
+    template <typename... Args>
+    SlotHandle emplace(Args&&... args) {
+        if (full()) return {};
+        values.emplace_back(std::forward<Args>(args)...);
+        return link();
+    }
 
-            float t = 1.f - ratio;
-            sf::Color col(
-                uint8_t(Math::lerp(float(p.color.r), float(p.endColor.r), t)),
-                          uint8_t(Math::lerp(float(p.color.g), float(p.endColor.g), t)),
-                          uint8_t(Math::lerp(float(p.color.b), float(p.endColor.b), t)),
-                          uint8_t(float(p.color.a) * ratio)
-            );
+    // Comme emplace, mais recycle d'abord un élément en réserve.
+    template <typename... Args>
+    SlotHandle respawn(Args&&... args) {
+        if (full()) return {};
+        if (spares.empty()) return emplace(std::forward<Args>(args)...);
+        values.push_back(std::move(spares.back()));
+        spares.pop_back();
+        values.back().reset(std::forward<Args>(args)...);
+        return link();
+    }
 
-            float sz = Math::lerp(p.size, p.endSize, t);
-            float c = std::cos(p.rotation) * sz, s = std::sin(p.rotation) * sz;
+    // nullptr si l'élément a été retiré.
+    T* get(SlotHandle h) {
+        if (!h || h.index >= slots.size() || slots[h.index].generation != h.generation) return nullptr;
+        return &values[slots[h.index].dense];
+    }
+    const T* get(SlotHandle h) const { return const_cast<SlotMap*>(this)->get(h); }
 
-            sf::Vector2f corners[4] = {{-c+s,-s-c}, {c+s,s-c}, {c-s,s+c}, {-c-s,-s+c}};
-            vertices[idx++] = {p.position + corners[0], col};
-            vertices[idx++] = {p.position + corners[1], col};
-            vertices[idx++] = {p.position + corners[2], col};
-            vertices[idx++] = {p.position + corners[0], col};
-            vertices[idx++] = {p.position + corners[2], col};
-            vertices[idx++] = {p.position + corners[3], col};
-        }
-        activeVerts = idx;
+    bool erase(SlotHandle h) {
+        if (!get(h)) return false;
+        removeAt(slots[h.index].dense);
+        return true;
     }
 
-    void draw(sf::RenderTarget& target) const {
-        if (activeVerts > 0) {
-            sf::VertexArray vis(sf::PrimitiveType::Triangles, activeVerts);
-            for (size_t i = 0; i < activeVerts; ++i) vis[i] = vertices[i];
-            target.draw(vis, sf::RenderStates(blendMode));
+    // Retire les éléments pour lesquels pred est vrai ; renvoie leur nombre.
+    template <typename Pred>
+    size_t eraseIf(Pred pred) {
+        size_t removed = 0;
+        for (size_t i = 0; i < values.size();) {
+            if (pred(values[i])) {
+                removeAt(i); // le dernier prend la place i : on la reteste
+                ++removed;
+            } else {
+                ++i;
+            }
         }
+        return removed;
     }
 
-    float gravity = 200.f, drag = 0.5f;
-    sf::BlendMode blendMode = sf::BlendAdd;
-
-private:
-    std::vector<Particle> particles;
-    sf::VertexArray vertices;
-    size_t activeVerts = 0;
-};
-
-// ============================================================================
-// INPUT
-// ============================================================================
-
-class InputManager {
-public:
-    void update() {
-        prevState = currState;
-        updateKey("left", sf::Keyboard::Key::Left, sf::Keyboard::Key::A);
-        updateKey("right", sf::Keyboard::Key::Right, sf::Keyboard::Key::D);
-        updateKey("up", sf::Keyboard::Key::Up, sf::Keyboard::Key::W);
-        updateKey("down", sf::Keyboard::Key::Down, sf::Keyboard::Key::S);
-        updateKey("jump", sf::Keyboard::Key::Space, sf::Keyboard::Key::Space);
-        updateKey("dash", sf::Keyboard::Key::LShift, sf::Keyboard::Key::K);
-        updateKey("attack", sf::Keyboard::Key::V, sf::Keyboard::Key::V);
-        updateKey("y", sf::Keyboard::Key::Y, sf::Keyboard::Key::Y);
-        updateKey("h", sf::Keyboard::Key::H, sf::Keyboard::Key::H);
-        updateKey("p", sf::Keyboard::Key::P, sf::Keyboard::Key::P);
-        updateKey("pause", sf::Keyboard::Key::Escape, sf::Keyboard::Key::Escape);
-        updateKey("confirm", sf::Keyboard::Key::Enter, sf::Keyboard::Key::Enter);
-        updateKey("back", sf::Keyboard::Key::Escape, sf::Keyboard::Key::Backspace);
-        updateKey("num1", sf::Keyboard::Key::Num1, sf::Keyboard::Key::Numpad1);
-        updateKey("num2", sf::Keyboard::Key::Num2, sf::Keyboard::Key::Numpad2);
-        updateKey("num3", sf::Keyboard::Key::Num3, sf::Keyboard::Key::Numpad3);
+    // Les éléments vivants passent en réserve.
+    void clear() {
+        for (T& value : values) spares.push_back(std::move(value));
+        values.clear();
+        denseSlot.clear();
+        slots.clear();
+        freeSlots.clear();
     }
 
-    bool isPressed(const std::string& a) const {
-        auto it = currState.find(a);
-        return it != currState.end() && it->second;
+    SlotHandle handleAt(size_t denseIndex) const {
+        uint32_t index = denseSlot[denseIndex];
+        return {index, slots[index].generation};
     }
 
-    bool justPressed(const std::string& a) const {
-        auto c = currState.find(a), p = prevState.find(a);
-        return (c != currState.end() && c->second) &&
-        (p == prevState.end() || !p->second);
-    }
+    T& operator[](size_t denseIndex) { return values[denseIndex]; }
+    const T& operator[](size_t denseIndex) const { return values[denseIndex]; }
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    iterator begin() { return values.begin(); }
+    iterator end() { return values.end(); }
+    const_iterator begin() const { return values.begin(); }
+    const_iterator end() const { return values.end(); }
+    uint32_t getNextGeneration() const { return nextGeneration; }
+    size_t getSpareCount() const { return spares.size(); }
+
+    // Restauration d'instantané : count éléments denses avec leurs handles
+    // d'origine. Les éléments en place ou en réserve sont repris (l'appelant
+    // les remet en état), make(i) construit ceux qui manquent. Les slots
+    // libres sont refaits du plus petit au plus grand : le résultat ne dépend
+    // que de l'instantané.
+    template <typename Make>
+    void restore(const SlotHandle* handles, size_t count, uint32_t generation, Make make) {
+        while (values.size() > count) {
+            spares.push_back(std::move(values.back()));
+            values.pop_back();
+        }
+        while (values.size() < count) {
+            if (spares.empty()) {
+                values.push_back(make(values.size()));
+            } else {
+                values.push_back(std::move(spares.back()));
+                spares.pop_back();
+            }
+        }
 
-    bool justReleased(const std::string& a) const {
-        auto c = currState.find(a), p = prevState.find(a);
-        return (c == currState.end() || !c->second) &&
-        (p != prevState.end() && p->second);
+        uint32_t slotCount = 0;
+        for (size_t i = 0; i < count; ++i) slotCount = std::max(slotCount, handles[i].index + 1);
+        slots.assign(slotCount, Slot{});
+        denseSlot.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            slots[handles[i].index] = {uint32_t(i), handles[i].generation};
+            denseSlot[i] = handles[i].index;
+        }
+        freeSlots.clear();
+        for (uint32_t s = slotCount; s-- > 0;)
+            if (slots[s].generation == 0) freeSlots.push_back(s);
+        nextGeneration = generation;
     }
 
-    float getAxis(const std::string& neg, const std::string& pos) const {
-        float v = 0;
-        if (isPressed(neg)) v -= 1.f;
-        if (isPressed(pos)) v += 1.f;
-        return v;
+private:
+    struct Slot {
+        uint32_t dense = 0;
+        uint32_t generation = 0; // 0 : libre
+    };
+
+    // Slot pour l'élément qui vient d'être ajouté en fin de tableau dense.
+    SlotHandle link() {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = uint32_t(slots.size());
+            slots.emplace_back();
+        }
+        slots[index] = {uint32_t(values.size() - 1), nextGeneration++};
+        denseSlot.push_back(index);
+        return {index, slots[index].generation};
     }
 
-private:
-    void updateKey(const std::string& a, sf::Keyboard::Key k1, sf::Keyboard::Key k2) {
-        currState[a] = sf::Keyboard::isKeyPressed(k1) || sf::Keyboard::isKeyPressed(k2);
+    void removeAt(size_t denseIndex) {
+        uint32_t index = denseSlot[denseIndex];
+        size_t last = values.size() - 1;
+        if (denseIndex != last) {
+            std::swap(values[denseIndex], values[last]);
+            denseSlot[denseIndex] = denseSlot[last];
+            slots[denseSlot[denseIndex]].dense = uint32_t(denseIndex);
+        }
+        spares.push_back(std::move(values[last]));
+        values.pop_back();
+        denseSlot.pop_back();
+        slots[index].generation = 0;
+        freeSlots.push_back(index);
     }
-    std::unordered_map<std::string, bool> currState, prevState;
+
+    std::vector<T> values;
+    std::vector<uint32_t> denseSlot; // slot de chaque élément dense
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<T> spares; // retirés ou préchauffés, prêts pour respawn()
+    size_t capacity = SIZE_MAX;
+    uint32_t nextGeneration = 1;
 };
 
 // ============================================================================
-// PROJECTILE
+// TÉLÉMÉTRIE (ANNEAU SANS VERROU -> JOURNAL BINAIRE)
 // ============================================================================
 
-class Projectile {
-public:
-    Projectile(sf::Vector2f pos, sf::Vector2f dir, float speed, sf::Color color)
-    : position(pos), velocity(Math::normalize(dir) * speed), baseColor(color) {
-        shape.setRadius(initialRadius);
-        shape.setOrigin({initialRadius, initialRadius});
-        shape.setFillColor(color);
-        shape.setOutlineThickness(2.f);
-        shape.setOutlineColor(sf::Color(color.r, color.g, color.b, 150));
-    }
-
-    void update(float dt) {
-        if (!active) return;
-
-        lifetime += dt;
-        position += velocity * dt;
+// Fichier .swt : en-tête puis records de taille fixe, dans l'ordre d'émission.
+// Relu par soulworld_teldump (CSV).
+namespace TelemetryFormat {
+    constexpr uint32_t MAGIC = 0x54575753; // "SWWT" en little-endian
+    constexpr uint16_t VERSION = 2;
+
+    enum class EventType : uint8_t {
+        EnemySpawn,     // subject : type d'ennemi ; entity : génération du handle
+        EnemyKill,      // subject : type d'ennemi ; amount : joueur ; entity : comme à l'apparition
+        DamageTaken,    // subject : joueur ; amount : dégâts ; value : vie restante
+        UpgradeChosen,  // subject : amélioration
+        WaveStart,      // amount : vague ; value : ennemis à venir
+        WaveEnd,        // amount : vague
+        FrameTime,      // subject : palier de qualité ; x : ms de travail
+        Count
+    };
 
-        float growthFactor = 1.f + lifetime * growthRate;
-        currentRadius = std::min(initialRadius * growthFactor, maxRadius);
+    constexpr const char* NAMES[] = {"enemy_spawn", "enemy_kill", "damage_taken", "upgrade_chosen",
+                                     "wave_start", "wave_end", "frame_time"};
+    static_assert(std::size(NAMES) == size_t(EventType::Count));
 
-        shape.setRadius(currentRadius);
-        shape.setOrigin({currentRadius, currentRadius});
-        shape.setPosition(position);
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t recordSize;
+    };
 
-        rotation += velocity.x * dt * 0.1f;
-        shape.setRotation(sf::degrees(rotation));
+    struct Event {
+        float time; // secondes depuis l'ouverture du journal
+        EventType type;
+        uint8_t subject;
+        int16_t amount;
+        int32_t value;
+        uint32_t entity; // 0 : aucune
+        float x, y;
+    };
 
-        if (int(lifetime * 20) % 2 == 0) {
-            trailPositions.push_back(position);
-            if (trailPositions.size() > 10) trailPositions.erase(trailPositions.begin());
-        }
+    static_assert(std::is_trivially_copyable_v<Event> && sizeof(Event) == 24);
+}
 
-        if (position.x < -100 || position.x > 3200 || position.y > 1200) {
-            active = false;
+// Journal d'événements de jeu. Le thread de jeu dépose chaque événement dans
+// un anneau à un producteur et un consommateur (deux compteurs atomiques, pas
+// de verrou) ; un thread d'écriture le vide vers le fichier. record() ne
+// bloque jamais : anneau plein, l'événement est perdu et compté.
+class TelemetryLog {
+public:
+    using EventType = TelemetryFormat::EventType;
+    static constexpr size_t CAPACITY = 1 << 14; // puissance de deux
+
+    // nullptr si le fichier ne peut pas être créé.
+    static std::unique_ptr<TelemetryLog> open(const std::string& path) {
+        std::unique_ptr<TelemetryLog> log(new TelemetryLog());
+        log->out.open(path, std::ios::binary);
+        TelemetryFormat::Header header{TelemetryFormat::MAGIC, TelemetryFormat::VERSION, sizeof(TelemetryFormat::Event)};
+        if (!log->out.write(reinterpret_cast<const char*>(&header), sizeof(header))) {
+            std::cerr << "Journal de telemetrie impossible a creer: " << path << std::endl;
+            return nullptr;
         }
+        log->pending.reserve(PENDING_CAPACITY);
+        log->writer = std::thread([raw = log.get()] {
+            HitchTrace::nameThread("telemetrie");
+            raw->drain();
+        });
+        return log;
     }
 
-    void draw(sf::RenderTarget& target) const {
-        if (!active) return;
+    ~TelemetryLog() {
+        running.store(false, std::memory_order_release);
+        if (writer.joinable()) writer.join();
+    }
 
-        for (size_t i = 0; i < trailPositions.size(); ++i) {
-            float alpha = float(i) / trailPositions.size() * 100.f;
-            float radius = currentRadius * 0.3f * (float(i) / trailPositions.size());
-            sf::CircleShape trail(radius);
-            trail.setOrigin({radius, radius});
-            trail.setPosition(trailPositions[i]);
-            trail.setFillColor(sf::Color(baseColor.r, baseColor.g, baseColor.b, uint8_t(alpha)));
-            target.draw(trail);
+    TelemetryLog(const TelemetryLog&) = delete;
+    TelemetryLog& operator=(const TelemetryLog&) = delete;
+
+    // Thread de jeu uniquement.
+    void record(EventType type, uint8_t subject, int16_t amount = 0, int32_t value = 0, sf::Vector2f pos = {0, 0},
+                uint32_t entity = 0) {
+        float time = std::chrono::duration<float>(std::chrono::steady_clock::now() - opened).count();
+        TelemetryFormat::Event event{time, type, subject, amount, value, entity, pos.x, pos.y};
+        if (speculativeFrame < 0) {
+            push(event);
+        } else if (pending.size() < PENDING_CAPACITY) {
+            pending.push_back({speculativeFrame, event});
+        } else {
+            ++dropped;
         }
+    }
 
-        target.draw(shape);
+    // Rollback : une frame simulée avec un input prédit garde ses événements de
+    // côté. Rejouée, ils sont remplacés (discardFrom) ; confirmée, ils passent
+    // dans l'anneau (confirmThrough). Le journal ne contient ainsi que la
+    // partie confirmée. Thread de jeu uniquement.
+    void beginSpeculative(int frame) { speculativeFrame = frame; }
+    void endSpeculative() { speculativeFrame = -1; }
 
-        sf::CircleShape glow(currentRadius * 1.3f);
-        glow.setOrigin({currentRadius * 1.3f, currentRadius * 1.3f});
-        glow.setPosition(position);
-        glow.setFillColor(sf::Color(baseColor.r, baseColor.g, baseColor.b, 30));
-        target.draw(glow, sf::RenderStates(sf::BlendAdd));
+    void discardFrom(int frame) {
+        while (!pending.empty() && pending.back().frame >= frame) pending.pop_back();
     }
 
-    sf::FloatRect getBounds() const {
-        return {{position.x - currentRadius, position.y - currentRadius},
-        {currentRadius * 2, currentRadius * 2}};
+    void confirmThrough(int frame) {
+        size_t n = 0;
+        for (; n < pending.size() && pending[n].frame <= frame; ++n) push(pending[n].event);
+        pending.erase(pending.begin(), pending.begin() + std::ptrdiff_t(n));
     }
 
-    bool isActive() const { return active; }
-    void deactivate() { active = false; }
-    float getDamage() const { return 1.f + (currentRadius / maxRadius); }
+    size_t getRecorded() const { return head.load(std::memory_order_relaxed); }
+    size_t getDropped() const { return dropped; }
+    size_t getWritten() const { return written.load(std::memory_order_relaxed); }
 
 private:
-    sf::Vector2f position;
-    sf::Vector2f velocity;
-    sf::CircleShape shape;
-    sf::Color baseColor;
+    static constexpr size_t PENDING_CAPACITY = 1024; // événements en attente de confirmation
 
-    float initialRadius = 12.f;
-    float currentRadius = 12.f;
-    float maxRadius = 50.f;
-    float growthRate = 0.8f;
-    float lifetime = 0;
-    float rotation = 0;
-    bool active = true;
+    struct PendingEvent {
+        int frame;
+        TelemetryFormat::Event event;
+    };
+
+    TelemetryLog() = default;
+
+    void push(const TelemetryFormat::Event& event) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tailCache == CAPACITY) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h - tailCache == CAPACITY) { ++dropped; return; }
+        }
+        ring[h & (CAPACITY - 1)] = event;
+        head.store(h + 1, std::memory_order_release);
+    }
 
-    std::vector<sf::Vector2f> trailPositions;
+    // Thread d'écriture : recopie par tranches contiguës, dort quand l'anneau est vide.
+    void drain() {
+        for (;;) {
+            bool stopping = !running.load(std::memory_order_acquire);
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t h = head.load(std::memory_order_acquire);
+            if (h == t) {
+                if (stopping) break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                continue;
+            }
+            size_t first = t & (CAPACITY - 1);
+            size_t n = std::min(h - t, CAPACITY - first);
+            TraceScope scope("TelemetryLog::write");
+            out.write(reinterpret_cast<const char*>(&ring[first]), std::streamsize(n * sizeof(TelemetryFormat::Event)));
+            tail.store(t + n, std::memory_order_release);
+            written.fetch_add(n, std::memory_order_relaxed);
+        }
+        out.flush();
+    }
+
+    std::array<TelemetryFormat::Event, CAPACITY> ring;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) size_t tailCache = 0; // vue du producteur, relue seulement quand l'anneau semble plein
+    size_t dropped = 0;
+    alignas(64) std::atomic<size_t> tail{0};
+    std::atomic<size_t> written{0};
+    std::atomic<bool> running{true};
+    std::vector<PendingEvent> pending; // triés par frame
+    int speculativeFrame = -1;
+    std::ofstream out;
+    std::thread writer;
+    std::chrono::steady_clock::time_point opened = std::chrono::steady_clock::now();
 };
 
 // ============================================================================
-// PLATEFORME
+// NIVEAU (FORMAT BINAIRE MAPPÉ EN MÉMOIRE)
 // ============================================================================
 
-class Platform {
-public:
-    Platform(sf::Vector2f size, sf::Vector2f pos, bool oneWay = false)
-    : isOneWay(oneWay), originalPos(pos), previousPos(pos) {
-        shape.setSize(size);
-        shape.setPosition(pos);
-        shape.setFillColor(oneWay ? sf::Color(55, 45, 65, 200) : sf::Color(35, 30, 45, 255));
-        shape.setOutlineThickness(2.f);
-        shape.setOutlineColor(sf::Color(90, 80, 110, 150));
+// Limites du monde, lues depuis le niveau chargé.
+struct LevelBounds {
+    float width = 3000.f;
+    float height = 1200.f;
+    float floorY = 1030.f;
+};
 
-        highlight.setSize({size.x, 3.f});
-        highlight.setPosition(pos);
-        highlight.setFillColor(sf::Color(140, 130, 170, 100));
+// Fichier .swl : en-tête fixe suivi de tableaux de records POD, alignés sur
+// 4 octets et lus directement dans le mapping, sans étape de parsing.
+// v2 : plateformes triées par chunk + table de chunks pour le streaming.
+namespace LevelFormat {
+    constexpr uint32_t MAGIC = 0x4C575753; // "SWWL" en little-endian
+    constexpr uint16_t VERSION = 2;
+
+    enum PlatformFlags : uint32_t {
+        OneWay = 1u << 0,
+        Moving = 1u << 1,
+        MoveHorizontal = 1u << 2,
+    };
 
-        bounds = shape.getGlobalBounds();
-    }
+    struct Section {
+        uint32_t offset;
+        uint32_t count;
+    };
 
-    void update(float dt) {
-        previousPos = shape.getPosition();
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t headerSize;
+        uint32_t fileSize;
+        float width, height, floorY;
+        float startX, startY;
+        uint32_t backgroundSeed;
+        float chunkWidth;
+        uint32_t chunkReach;   // chunks à gauche dont une plateforme peut déborder
+        Section platforms;
+        Section spawnZones;
+        Section chunks;
+    };
+
+    struct PlatformRecord {
+        float x, y, w, h;
+        uint32_t flags;
+        float moveRange, moveSpeed;
+    };
 
-        if (isMoving) {
-            moveTimer += dt * moveSpeed;
-            float offset = std::sin(moveTimer) * moveRange;
-            sf::Vector2f newPos = originalPos;
-            if (moveHorizontal) newPos.x += offset;
-            else newPos.y += offset;
-            shape.setPosition(newPos);
-            highlight.setPosition(newPos);
-            bounds = shape.getGlobalBounds();
-            velocity = (shape.getPosition() - previousPos) / dt;
+    struct SpawnZone {
+        float minX, maxX, y;
+    };
+
+    // Plages de records appartenant à un chunk (par bord gauche balayé).
+    struct ChunkRecord {
+        uint32_t firstPlatform, platformCount;
+        uint32_t firstSpawnZone, spawnZoneCount;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 68);
+    static_assert(std::is_trivially_copyable_v<ChunkRecord> && sizeof(ChunkRecord) == 16);
+    static_assert(std::is_trivially_copyable_v<PlatformRecord> && sizeof(PlatformRecord) == 28);
+    static_assert(std::is_trivially_copyable_v<SpawnZone> && sizeof(SpawnZone) == 12);
+}
+
+// Fichier en lecture seule mappé en mémoire (mmap / MapViewOfFile).
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& o) noexcept { *this = std::move(o); }
+    MappedFile& operator=(MappedFile&& o) noexcept {
+        if (this != &o) {
+            close();
+            std::swap(ptr, o.ptr);
+            std::swap(length, o.length);
         }
+        return *this;
     }
-
-    void draw(sf::RenderTarget& target) const {
-        target.draw(shape);
-        target.draw(highlight);
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(file, &sz) || sz.QuadPart == 0) { CloseHandle(file); return false; }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) return false;
+        ptr = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping);
+        if (!ptr) return false;
+        length = size_t(sz.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* m = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED) return false;
+        ptr = static_cast<const uint8_t*>(m);
+        length = size_t(st.st_size);
+#endif
+        return true;
     }
 
-    sf::FloatRect getBounds() const { return bounds; }
-    bool getIsOneWay() const { return isOneWay; }
-    sf::Vector2f getVelocity() const { return velocity; }
-
-    void setMoving(bool horizontal, float range, float speed) {
-        isMoving = true;
-        moveHorizontal = horizontal;
-        moveRange = range;
-        moveSpeed = speed;
+    void close() {
+        if (!ptr) return;
+#if defined(_WIN32)
+        UnmapViewOfFile(ptr);
+#else
+        munmap(const_cast<uint8_t*>(ptr), length);
+#endif
+        ptr = nullptr;
+        length = 0;
     }
 
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+    bool isOpen() const { return ptr != nullptr; }
+
 private:
-    sf::RectangleShape shape, highlight;
-    sf::FloatRect bounds;
-    bool isOneWay;
-    sf::Vector2f originalPos, previousPos;
-    sf::Vector2f velocity{0, 0};
-    bool isMoving = false;
-    bool moveHorizontal = true;
-    float moveRange = 0, moveSpeed = 1.f, moveTimer = 0;
+    const uint8_t* ptr = nullptr;
+    size_t length = 0;
 };
 
-// ============================================================================
-// STATS DU JOUEUR
-// ============================================================================
-
-struct PlayerStats {
-    float speedMultiplier = 1.f;
-    float jumpMultiplier = 1.f;
-    float dashCooldownMultiplier = 1.f;
-    float flightDurationMultiplier = 1.f;
-    int maxHealth = Config::MAX_HEALTH;
-    float attackRange = 40.f;
-    float attackSpeed = 1.f;
-    int attackDamage = 1;
-
-    void reset() {
-        speedMultiplier = jumpMultiplier = 1.f;
-        dashCooldownMultiplier = flightDurationMultiplier = attackSpeed = 1.f;
-        maxHealth = Config::MAX_HEALTH;
-        attackRange = 40.f;
-        attackDamage = 1;
+// Vue validée sur un niveau (mappé ou construit en mémoire).
+class Level {
+public:
+    static std::optional<Level> load(const std::string& path) {
+        MappedFile file;
+        if (!file.open(path)) return std::nullopt;
+        Level level;
+        level.base = file.data();
+        level.length = file.size();
+        level.file = std::move(file);
+        if (!level.validate()) {
+            std::cerr << "Niveau invalide: " << path << std::endl;
+            return std::nullopt;
+        }
+        return level;
     }
-};
 
-// ============================================================================
-// JOUEUR
-// ============================================================================
+    // Niveau lu en place dans une mémoire externe (paquet de ressources) ; owner la garde en vie.
+    static std::optional<Level> fromMemory(const uint8_t* data, size_t size, std::shared_ptr<const void> owner) {
+        Level level;
+        level.base = data;
+        level.length = size;
+        level.owner = std::move(owner);
+        if (!level.validate()) return std::nullopt;
+        return level;
+    }
 
-class Player {
-public:
-    enum class State { Idle, Running, Jumping, Falling, Dashing, Attacking, Hurt, Dead, Flying };
+    // Copie indépendante des octets (second monde du même niveau).
+    std::optional<Level> copy() const { return fromBytes(std::vector<uint8_t>(base, base + length)); }
 
-    Player(sf::Vector2f startPos) : position(startPos) {
-        body.setRadius(18.f);
-        body.setOrigin({18.f, 18.f});
-        body.setFillColor(sf::Color(180, 220, 255, 230));
-        body.setOutlineThickness(2.f);
-        body.setOutlineColor(sf::Color(100, 150, 200, 200));
+    static std::optional<Level> fromBytes(std::vector<uint8_t> bytes) {
+        Level level;
+        level.owned = std::move(bytes);
+        level.base = level.owned.data();
+        level.length = level.owned.size();
+        if (!level.validate()) return std::nullopt;
+        return level;
+    }
 
-        glow.setRadius(25.f);
-        glow.setOrigin({25.f, 25.f});
-        glow.setFillColor(sf::Color(150, 200, 255, 50));
+    // Niveau par défaut, embarqué dans l'exécutable.
+    static Level builtin();
 
-        eye.setRadius(4.f);
-        eye.setOrigin({4.f, 4.f});
-        eye.setFillColor(sf::Color(50, 50, 80));
+    const LevelFormat::Header& header() const { return *reinterpret_cast<const LevelFormat::Header*>(base); }
 
-        trail.gravity = 50.f;
-        trail.drag = 2.f;
+    const LevelFormat::PlatformRecord* platforms() const {
+        return reinterpret_cast<const LevelFormat::PlatformRecord*>(base + header().platforms.offset);
     }
+    uint32_t platformCount() const { return header().platforms.count; }
 
-    void handleInput(const InputManager& input, float dt) {
-        if (state == State::Dead || state == State::Hurt) return;
+    const LevelFormat::SpawnZone* spawnZones() const {
+        return reinterpret_cast<const LevelFormat::SpawnZone*>(base + header().spawnZones.offset);
+    }
+    uint32_t spawnZoneCount() const { return header().spawnZones.count; }
 
-        float moveInput = input.getAxis("left", "right");
+    const LevelFormat::ChunkRecord* chunks() const {
+        return reinterpret_cast<const LevelFormat::ChunkRecord*>(base + header().chunks.offset);
+    }
+    uint32_t chunkCount() const { return header().chunks.count; }
+    float chunkWidth() const { return header().chunkWidth; }
+    int chunkReach() const { return int(header().chunkReach); }
 
-        if (state != State::Dashing) {
-            if (std::abs(moveInput) > 0.1f) facingRight = moveInput > 0;
+    LevelBounds bounds() const { return {header().width, header().height, header().floorY}; }
+    sf::Vector2f startPosition() const { return {header().startX, header().startY}; }
+    uint32_t backgroundSeed() const { return header().backgroundSeed; }
 
-            if (state != State::Flying) {
-                float targetSpeed = moveInput * Config::PLAYER_SPEED * stats.speedMultiplier;
-                velocity.x = Math::lerp(velocity.x, targetSpeed, isGrounded ? 15.f * dt : 8.f * dt);
-            }
+private:
+    Level() = default;
+
+    bool validate() const {
+        using namespace LevelFormat;
+        if (length < sizeof(Header) || reinterpret_cast<uintptr_t>(base) % alignof(Header) != 0) return false;
+        const Header& h = header();
+        if (h.magic != MAGIC || h.version != VERSION || h.headerSize != sizeof(Header)) return false;
+        if (h.fileSize != length || h.width <= 0 || h.height <= 0 || h.chunkWidth <= 0) return false;
+        auto sectionOk = [&](const Section& sec, size_t recordSize) {
+            return sec.offset % 4 == 0 && sec.offset >= sizeof(Header) &&
+                   uint64_t(sec.offset) + uint64_t(sec.count) * recordSize <= length;
+        };
+        if (!sectionOk(h.platforms, sizeof(PlatformRecord)) || !sectionOk(h.spawnZones, sizeof(SpawnZone)) ||
+            !sectionOk(h.chunks, sizeof(ChunkRecord)))
+            return false;
+        if (h.chunks.count != uint32_t(std::ceil(h.width / h.chunkWidth))) return false;
+        for (uint32_t i = 0; i < h.chunks.count; ++i) {
+            const ChunkRecord& c = chunks()[i];
+            if (uint64_t(c.firstPlatform) + c.platformCount > h.platforms.count ||
+                uint64_t(c.firstSpawnZone) + c.spawnZoneCount > h.spawnZones.count)
+                return false;
         }
+        return true;
+    }
 
-        coyoteTimer = isGrounded ? Config::COYOTE_TIME : coyoteTimer - dt;
-        jumpBufferTimer = input.justPressed("jump") ? Config::JUMP_BUFFER_TIME : jumpBufferTimer - dt;
+    MappedFile file;
+    std::vector<uint8_t> owned;
+    std::shared_ptr<const void> owner;
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+};
 
-        if (jumpBufferTimer > 0 && coyoteTimer > 0 && state != State::Flying) {
-            velocity.y = -Config::JUMP_FORCE * stats.jumpMultiplier;
-            isGrounded = false;
-            coyoteTimer = jumpBufferTimer = 0;
-            createJumpParticles();
-        }
+// Écrit un niveau au format binaire (outil de build et niveau embarqué).
+class LevelBuilder {
+public:
+    LevelBuilder& bounds(float width, float height, float floorY) {
+        header.width = width; header.height = height; header.floorY = floorY;
+        return *this;
+    }
+    LevelBuilder& start(sf::Vector2f pos) { header.startX = pos.x; header.startY = pos.y; return *this; }
+    LevelBuilder& backgroundSeed(uint32_t seed) { header.backgroundSeed = seed; return *this; }
 
-        if (input.justReleased("jump") && velocity.y < 0) velocity.y *= 0.5f;
-        if (input.justPressed("dash") && dashCooldown <= 0 && state != State::Flying) startDash();
-        if (input.justPressed("attack") && state != State::Dashing && attackCooldown <= 0) startAttack();
+    LevelBuilder& platform(sf::Vector2f size, sf::Vector2f pos, bool oneWay = false) {
+        platforms.push_back({pos.x, pos.y, size.x, size.y, oneWay ? uint32_t(LevelFormat::OneWay) : 0u, 0.f, 0.f});
+        return *this;
+    }
 
-        handleInvocation(input);
+    LevelBuilder& movingPlatform(sf::Vector2f size, sf::Vector2f pos, bool horizontal, float range, float speed) {
+        uint32_t flags = LevelFormat::OneWay | LevelFormat::Moving | (horizontal ? LevelFormat::MoveHorizontal : 0u);
+        platforms.push_back({pos.x, pos.y, size.x, size.y, flags, range, speed});
+        return *this;
     }
 
-    void handleInvocation(const InputManager& input) {
-        invocationTimer -= 1.f/60.f;
+    LevelBuilder& spawnZone(float minX, float maxX, float y) {
+        zones.push_back({minX, maxX, y});
+        return *this;
+    }
 
-        if (input.justPressed("y")) { invocationSeq = "Y"; invocationTimer = 2.f; }
-        else if (input.justPressed("h") && invocationSeq == "Y" && invocationTimer > 0) invocationSeq = "YH";
-        else if (input.justPressed("p") && invocationSeq == "YH" && invocationTimer > 0) activateFlight();
+    LevelBuilder& chunkWidth(float width) { header.chunkWidth = width; return *this; }
 
-        if (invocationTimer <= 0) invocationSeq = "";
+    // Repart d'un niveau existant (scénarios générés, outils).
+    static LevelBuilder from(const Level& level) {
+        LevelBuilder b;
+        b.header = level.header();
+        b.platforms.assign(level.platforms(), level.platforms() + level.platformCount());
+        b.zones.assign(level.spawnZones(), level.spawnZones() + level.spawnZoneCount());
+        return b;
     }
 
-    void activateFlight() {
-        state = State::Flying;
-        flightTimer = Config::FLIGHT_DURATION * stats.flightDurationMultiplier;
-        invocationSeq = "";
+    std::vector<uint8_t> build() const {
+        using namespace LevelFormat;
+        Header h = header;
+        h.magic = MAGIC;
+        h.version = VERSION;
+        h.headerSize = sizeof(Header);
+
+        // Une plateforme appartient au chunk de son bord gauche balayé (mouvement compris).
+        auto sweptMinX = [](const PlatformRecord& r) {
+            bool horizontal = (r.flags & Moving) && (r.flags & MoveHorizontal);
+            return r.x - (horizontal ? r.moveRange : 0.f);
+        };
+        uint32_t chunkCount = uint32_t(std::ceil(h.width / h.chunkWidth));
+        auto chunkOf = [&](float x) {
+            return uint32_t(std::clamp(int(std::floor(x / h.chunkWidth)), 0, int(chunkCount) - 1));
+        };
 
-        ParticleConfig cfg;
-        cfg.startColor = sf::Color(100, 200, 255, 255);
-        cfg.endColor = sf::Color(50, 100, 200, 0);
-        cfg.minSpeed = 200.f; cfg.maxSpeed = 400.f;
-        cfg.spread = 3.14159f;
-        dragonFx.emit(position, cfg, 100);
+        std::vector<PlatformRecord> sortedPlatforms = platforms;
+        std::stable_sort(sortedPlatforms.begin(), sortedPlatforms.end(), [&](const auto& a, const auto& b) {
+            return chunkOf(sweptMinX(a)) < chunkOf(sweptMinX(b));
+        });
+        std::vector<SpawnZone> sortedZones = zones;
+        std::stable_sort(sortedZones.begin(), sortedZones.end(), [&](const auto& a, const auto& b) {
+            return chunkOf(a.minX) < chunkOf(b.minX);
+        });
+
+        std::vector<ChunkRecord> chunkTable(chunkCount, ChunkRecord{0, 0, 0, 0});
+        float maxExtent = 0;
+        for (uint32_t i = 0; i < sortedPlatforms.size(); ++i) {
+            const auto& r = sortedPlatforms[i];
+            ChunkRecord& c = chunkTable[chunkOf(sweptMinX(r))];
+            if (c.platformCount++ == 0) c.firstPlatform = i;
+            bool horizontal = (r.flags & Moving) && (r.flags & MoveHorizontal);
+            maxExtent = std::max(maxExtent, r.w + (horizontal ? 2.f * r.moveRange : 0.f));
+        }
+        for (uint32_t i = 0; i < sortedZones.size(); ++i) {
+            ChunkRecord& c = chunkTable[chunkOf(sortedZones[i].minX)];
+            if (c.spawnZoneCount++ == 0) c.firstSpawnZone = i;
+        }
+        h.chunkReach = uint32_t(std::ceil(maxExtent / h.chunkWidth));
+
+        h.platforms = {uint32_t(sizeof(Header)), uint32_t(sortedPlatforms.size())};
+        h.spawnZones = {uint32_t(h.platforms.offset + sortedPlatforms.size() * sizeof(PlatformRecord)),
+                        uint32_t(sortedZones.size())};
+        h.chunks = {uint32_t(h.spawnZones.offset + sortedZones.size() * sizeof(SpawnZone)), chunkCount};
+        h.fileSize = uint32_t(h.chunks.offset + chunkTable.size() * sizeof(ChunkRecord));
+
+        std::vector<uint8_t> bytes(h.fileSize);
+        auto put = [&](uint32_t offset, const void* src, size_t n) { if (n) std::memcpy(bytes.data() + offset, src, n); };
+        put(0, &h, sizeof(h));
+        put(h.platforms.offset, sortedPlatforms.data(), sortedPlatforms.size() * sizeof(PlatformRecord));
+        put(h.spawnZones.offset, sortedZones.data(), sortedZones.size() * sizeof(SpawnZone));
+        put(h.chunks.offset, chunkTable.data(), chunkTable.size() * sizeof(ChunkRecord));
+        return bytes;
+    }
 
-        body.setFillColor(sf::Color(100, 200, 255, 255));
-        glow.setRadius(40.f);
-        glow.setOrigin({40.f, 40.f});
-        glow.setFillColor(sf::Color(50, 150, 255, 100));
+    bool save(const std::string& path) const {
+        std::vector<uint8_t> bytes = build();
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+        return bool(out);
     }
 
-    void update(float dt, const std::vector<Platform>& platforms) {
-        if (dashCooldown > 0) dashCooldown -= dt;
-        if (invincibility > 0) invincibility -= dt;
-        if (attackTimer > 0) attackTimer -= dt;
-        if (attackCooldown > 0) attackCooldown -= dt;
-        if (hurtTimer > 0) {
-            hurtTimer -= dt;
-            if (hurtTimer <= 0 && state == State::Hurt) state = State::Idle;
+private:
+    LevelFormat::Header header{0, 0, 0, 0, 3000.f, 1200.f, 1030.f, 200.f, 900.f, 1,
+                               Config::CHUNK_WIDTH, 0, {0, 0}, {0, 0}, {0, 0}};
+    std::vector<LevelFormat::PlatformRecord> platforms;
+    std::vector<LevelFormat::SpawnZone> zones;
+};
+
+inline Level Level::builtin() {
+    LevelBuilder b;
+    b.bounds(3000.f, 1200.f, 1030.f).start({200.f, 900.f}).backgroundSeed(1);
+    b.platform({2800.f, 50.f}, {100.f, 1050.f});
+    b.platform({250.f, 25.f}, {300.f, 850.f}, true);
+    b.platform({300.f, 25.f}, {650.f, 700.f}, true);
+    b.platform({200.f, 25.f}, {1050.f, 600.f}, true);
+    b.platform({350.f, 25.f}, {1400.f, 750.f}, true);
+    b.platform({200.f, 25.f}, {1850.f, 550.f}, true);
+    b.platform({300.f, 25.f}, {2200.f, 680.f}, true);
+    b.platform({50.f, 400.f}, {50.f, 700.f});
+    b.platform({50.f, 400.f}, {2900.f, 700.f});
+    b.movingPlatform({150.f, 25.f}, {500.f, 500.f}, true, 150.f, 1.5f);
+    b.movingPlatform({150.f, 25.f}, {1200.f, 450.f}, false, 100.f, 2.f);
+    b.movingPlatform({200.f, 25.f}, {2000.f, 400.f}, true, 200.f, 1.f);
+    b.spawnZone(200.f, 1000.f, 1000.f);
+    b.spawnZone(2000.f, 2800.f, 1000.f);
+    return *fromBytes(b.build());
+}
+
+// ============================================================================
+// PAQUET DE RESSOURCES (MAPPÉ EN MÉMOIRE)
+// ============================================================================
+
+// Fichier .swp : en-tête, index d'entrées trié par nom, puis les données de
+// chaque ressource alignées sur 16 octets. Un seul open/mmap au lancement.
+namespace PackFormat {
+    constexpr uint32_t MAGIC = 0x4B505753; // "SWPK" en little-endian
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t NAME_SIZE = 48;
+    constexpr uint32_t DATA_ALIGN = 16;
+
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t headerSize;
+        uint32_t fileSize;
+        uint32_t entryCount;
+    };
+
+    struct Entry {
+        char name[NAME_SIZE];   // terminé par '\0'
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 16);
+    static_assert(std::is_trivially_copyable_v<Entry> && sizeof(Entry) == 56);
+}
+
+class AssetPack {
+public:
+    // Octets d'une ressource, valides tant que owner existe.
+    struct Asset {
+        const uint8_t* data;
+        size_t size;
+        std::shared_ptr<const void> owner;
+    };
+
+    static std::optional<AssetPack> open(const std::string& path) {
+        auto file = std::make_shared<MappedFile>();
+        if (!file->open(path)) return std::nullopt;
+        AssetPack pack;
+        pack.file = std::move(file);
+        if (!pack.validate()) {
+            std::cerr << "Paquet de ressources invalide: " << path << std::endl;
+            return std::nullopt;
         }
+        return pack;
+    }
 
-        if (state == State::Flying) {
-            flightTimer -= dt;
-            velocity.y = -150.f;
-            velocity.x *= 0.95f;
+    std::optional<Asset> find(std::string_view name) const {
+        const PackFormat::Entry* first = entries();
+        const PackFormat::Entry* last = first + entryCount();
+        const PackFormat::Entry* it = std::lower_bound(first, last, name, [](const PackFormat::Entry& e, std::string_view n) {
+            return std::string_view(e.name) < n;
+        });
+        if (it == last || std::string_view(it->name) != name) return std::nullopt;
+        return Asset{file->data() + it->offset, it->size, file};
+    }
 
-            ParticleConfig cfg;
-            cfg.startColor = sf::Color(100, 200, 255, 200);
-            cfg.endColor = sf::Color(50, 100, 200, 0);
-            cfg.direction = 1.57f; cfg.spread = 0.5f;
-            cfg.minSpeed = 50.f; cfg.maxSpeed = 100.f;
-            cfg.minLife = 0.3f; cfg.maxLife = 0.6f;
-            trail.emit(position + sf::Vector2f{0, 15.f}, cfg, 2);
+    const PackFormat::Entry* entries() const {
+        return reinterpret_cast<const PackFormat::Entry*>(file->data() + sizeof(PackFormat::Header));
+    }
+    uint32_t entryCount() const { return header().entryCount; }
+    const PackFormat::Header& header() const { return *reinterpret_cast<const PackFormat::Header*>(file->data()); }
 
-            if (flightTimer <= 0) {
-                state = State::Falling;
-                body.setFillColor(sf::Color(180, 220, 255, 230));
-                glow.setRadius(25.f);
-                glow.setOrigin({25.f, 25.f});
-                glow.setFillColor(sf::Color(150, 200, 255, 50));
-            }
+private:
+    AssetPack() = default;
+
+    bool validate() const {
+        using namespace PackFormat;
+        size_t length = file->size();
+        if (length < sizeof(Header)) return false;
+        const Header& h = header();
+        if (h.magic != MAGIC || h.version != VERSION || h.headerSize != sizeof(Header) || h.fileSize != length)
+            return false;
+        if (sizeof(Header) + uint64_t(h.entryCount) * sizeof(Entry) > length) return false;
+        for (uint32_t i = 0; i < h.entryCount; ++i) {
+            const Entry& e = entries()[i];
+            if (std::memchr(e.name, '\0', NAME_SIZE) == nullptr) return false;
+            if (e.offset % DATA_ALIGN != 0 || uint64_t(e.offset) + e.size > length) return false;
+            if (i > 0 && !(std::string_view(entries()[i - 1].name) < std::string_view(e.name))) return false;
         }
+        return true;
+    }
 
-        if (state == State::Dashing) {
-            dashTimer -= dt;
-            if (dashTimer <= 0) {
-                state = isGrounded ? State::Idle : State::Falling;
-                velocity.x = facingRight ? 150.f : -150.f;
-            }
+    std::shared_ptr<const MappedFile> file;
+};
+
+// Assemble un paquet (outil de build).
+class PackBuilder {
+public:
+    bool add(const std::string& name, std::vector<uint8_t> bytes) {
+        if (name.empty() || name.size() >= PackFormat::NAME_SIZE || assets.count(name)) return false;
+        assets.emplace(name, std::move(bytes));
+        return true;
+    }
 
-            ParticleConfig cfg;
-            cfg.startColor = sf::Color(200, 230, 255, 200);
-            cfg.endColor = sf::Color(100, 150, 200, 0);
-            cfg.minSpeed = 20.f; cfg.maxSpeed = 50.f;
-            cfg.minLife = 0.15f; cfg.maxLife = 0.3f;
-            cfg.minSize = 8.f; cfg.maxSize = 15.f;
-            trail.emit(position, cfg, 3);
+    std::vector<uint8_t> build() const {
+        using namespace PackFormat;
+        auto align = [](size_t v) { return (v + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN; };
+
+        // std::map : entrées déjà triées par nom pour la recherche dichotomique.
+        std::vector<Entry> index;
+        size_t offset = align(sizeof(Header) + assets.size() * sizeof(Entry));
+        for (const auto& [name, bytes] : assets) {
+            Entry e{};
+            std::memcpy(e.name, name.data(), name.size());
+            e.offset = uint32_t(offset);
+            e.size = uint32_t(bytes.size());
+            index.push_back(e);
+            offset = align(offset + bytes.size());
         }
 
-        if (state != State::Dashing && state != State::Flying) {
-            velocity.y = std::min(velocity.y + Config::GRAVITY * dt, 800.f);
+        Header h{MAGIC, VERSION, uint16_t(sizeof(Header)), uint32_t(offset), uint32_t(index.size())};
+        std::vector<uint8_t> out(offset);
+        std::memcpy(out.data(), &h, sizeof(h));
+        if (!index.empty()) std::memcpy(out.data() + sizeof(h), index.data(), index.size() * sizeof(Entry));
+        size_t i = 0;
+        for (const auto& [name, bytes] : assets) {
+            if (!bytes.empty()) std::memcpy(out.data() + index[i].offset, bytes.data(), bytes.size());
+            ++i;
         }
+        return out;
+    }
 
-        position += velocity * dt;
+    bool save(const std::string& path) const {
+        std::vector<uint8_t> bytes = build();
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+        return bool(out);
+    }
 
-        isGrounded = false;
-        platformVelocity = {0, 0};
+private:
+    std::map<std::string, std::vector<uint8_t>> assets;
+};
 
-        for (const auto& plat : platforms) {
-            if (resolveCollision(plat)) {
-                if (isGrounded && (plat.getVelocity().x != 0 || plat.getVelocity().y != 0)) {
-                    platformVelocity = plat.getVelocity();
-                }
-            }
-        }
+// ============================================================================
+// QUALITÉ ADAPTATIVE
+// ============================================================================
 
-        if (isGrounded) position += platformVelocity * dt;
+// Un palier de qualité. Les paliers se cumulent : on renonce d'abord aux
+// particules, puis aux traînées et halos des projectiles, puis aux détails
+// des ennemis éloignés, enfin au décor. Rien ici ne touche la simulation.
+struct QualityLevel {
+    const char* name;
+    float particleScale;      // part des particules émises
+    bool projectileTrails;
+    bool projectileGlow;
+    float enemyDetailRadius;  // au-delà (depuis le centre de la vue) : ni ailes ni barre de vie
+    float backgroundMoteRate; // part des particules du décor
+};
 
-        position.x = std::clamp(position.x, 20.f, 3000.f);
+namespace QualityLevels {
+    inline constexpr QualityLevel TABLE[] = {
+        {"complete", 1.f, true, true, 1e9f, 1.f},
+        {"particules reduites", 0.5f, true, true, 1e9f, 1.f},
+        {"sans trainees", 0.5f, false, false, 1e9f, 1.f},
+        {"ennemis simplifies", 0.35f, false, false, 700.f, 1.f},
+        {"minimale", 0.25f, false, false, 700.f, 0.25f},
+    };
+    inline constexpr int COUNT = int(std::size(TABLE));
 
-        updateState();
-        trail.update(dt);
-        dragonFx.update(dt);
+    constexpr const QualityLevel& get(int level) { return TABLE[std::clamp(level, 0, COUNT - 1)]; }
+}
+
+// Hystérésis des régulateurs sur un temps mesuré (moyenne lissée) : on
+// descend après une demi-seconde au-dessus du budget, on ne remonte qu'après
+// deux secondes nettement en dessous (restoreRatio du budget), et chaque
+// changement repart de zéro (settle) pour ne pas osciller entre deux crans.
+class BudgetHysteresis {
+public:
+    enum class Verdict : uint8_t { Hold, Degrade, Restore };
 
-        body.setPosition(position);
-        glow.setPosition(position);
-        eye.setPosition(position + sf::Vector2f{facingRight ? 6.f : -6.f, -5.f});
+    BudgetHysteresis(float budgetMs, float restoreRatio) : budgetMs(budgetMs), restoreMs(budgetMs * restoreRatio) {}
 
-        float breathe = 1.f + std::sin(animTimer * 3.f) * 0.05f;
-        body.setScale({breathe, breathe});
-        animTimer += dt;
+    Verdict sample(float ms) {
+        smoothedMs = smoothedMs <= 0 ? ms : Math::lerp(smoothedMs, ms, 0.1f);
+
+        if (smoothedMs > budgetMs) { ++overBudget; underBudget = 0; }
+        else if (smoothedMs < restoreMs) { ++underBudget; overBudget = 0; }
+        else { overBudget = 0; underBudget = 0; }
+
+        if (overBudget >= DEGRADE_FRAMES) return Verdict::Degrade;
+        if (underBudget >= RESTORE_FRAMES) return Verdict::Restore;
+        return Verdict::Hold;
     }
 
-    bool resolveCollision(const Platform& plat) {
-        sf::FloatRect pBounds = getCollisionBounds();
-        sf::FloatRect tBounds = plat.getBounds();
+    void settle() { overBudget = underBudget = 0; }
+    void reset() { smoothedMs = 0; settle(); }
 
-        if (!pBounds.findIntersection(tBounds)) return false;
+    float getSmoothedMs() const { return smoothedMs; }
 
-        float oL = (pBounds.position.x + pBounds.size.x) - tBounds.position.x;
-        float oR = (tBounds.position.x + tBounds.size.x) - pBounds.position.x;
-        float oT = (pBounds.position.y + pBounds.size.y) - tBounds.position.y;
-        float oB = (tBounds.position.y + tBounds.size.y) - pBounds.position.y;
+private:
+    static constexpr int DEGRADE_FRAMES = 30;
+    static constexpr int RESTORE_FRAMES = 120;
 
-        float minX = oL < oR ? -oL : oR;
-        float minY = oT < oB ? -oT : oB;
+    float budgetMs, restoreMs;
+    float smoothedMs = 0;
+    int overBudget = 0, underBudget = 0;
+};
 
-        if (plat.getIsOneWay()) {
-            if (velocity.y > 0 && oT < 15.f) {
-                position.y = tBounds.position.y - 18.f;
-                velocity.y = 0;
-                isGrounded = true;
-                return true;
-            }
-            return false;
+// Choisit le palier d'après le temps de travail des frames.
+class QualityGovernor {
+public:
+    // true si le palier a changé.
+    bool sample(float frameMs) {
+        int next = level;
+        switch (hysteresis.sample(frameMs)) {
+            case BudgetHysteresis::Verdict::Degrade: next = std::min(level + 1, QualityLevels::COUNT - 1); break;
+            case BudgetHysteresis::Verdict::Restore: next = std::max(level - 1, 0); break;
+            case BudgetHysteresis::Verdict::Hold: break;
         }
+        if (next == level) return false;
 
-        if (std::abs(minX) < std::abs(minY)) {
-            position.x += minX;
-            velocity.x = 0;
-        } else {
-            position.y += minY;
-            if (minY < 0) isGrounded = true;
-            velocity.y = 0;
-        }
+        level = next;
+        hysteresis.settle();
+        ++changes;
         return true;
     }
 
-    sf::FloatRect getCollisionBounds() const {
-        return {{position.x - 15.f, position.y - 15.f}, {30.f, 33.f}};
-    }
+    void reset() { level = 0; hysteresis.reset(); }
 
-    void startDash() {
-        state = State::Dashing;
-        dashTimer = Config::DASH_DURATION;
-        dashCooldown = Config::DASH_COOLDOWN * stats.dashCooldownMultiplier;
-        velocity = {facingRight ? Config::DASH_SPEED : -Config::DASH_SPEED, 0};
-        invincibility = Config::DASH_DURATION;
-    }
+    int getLevel() const { return level; }
+    const QualityLevel& current() const { return QualityLevels::get(level); }
+    float getSmoothedMs() const { return hysteresis.getSmoothedMs(); }
+    size_t getChangeCount() const { return changes; }
 
-    void startAttack() {
-        state = State::Attacking;
-        attackTimer = 0.25f / stats.attackSpeed;
-        attackCooldown = 0.4f / stats.attackSpeed;
-        isAttacking = true;
+private:
+    BudgetHysteresis hysteresis{Config::FRAME_BUDGET_MS, 0.7f};
+    int level = 0;
+    size_t changes = 0;
+};
 
-        float range = stats.attackRange;
-        attackBounds = {{position.x + (facingRight ? 15.f : -15.f - range), position.y - 20.f}, {range, 40.f}};
+// Résolution interne du monde, entre RENDER_SCALE_MIN et 100 %, d'après le
+// temps de rendu mesuré : sur un rendu logiciel (llvmpipe), le remplissage
+// coûte à chaque pixel. Crans de RENDER_SCALE_STEP.
+class ResolutionScaler {
+public:
+    // true si l'échelle a changé.
+    bool sample(float renderMs) {
+        float next = scale;
+        switch (hysteresis.sample(renderMs)) {
+            case BudgetHysteresis::Verdict::Degrade: next = std::max(Config::RENDER_SCALE_MIN, scale - Config::RENDER_SCALE_STEP); break;
+            case BudgetHysteresis::Verdict::Restore: next = std::min(1.f, scale + Config::RENDER_SCALE_STEP); break;
+            case BudgetHysteresis::Verdict::Hold: break;
+        }
+        if (next == scale) return false;
 
-        ParticleConfig cfg;
-        cfg.startColor = sf::Color(255, 255, 255, 200);
-        cfg.endColor = sf::Color(200, 220, 255, 0);
-        cfg.direction = facingRight ? 0.f : 3.14159f;
-        cfg.spread = 0.5f;
-        cfg.minSpeed = 300.f; cfg.maxSpeed = 500.f;
-        cfg.minLife = 0.1f; cfg.maxLife = 0.2f;
-        trail.emit(position + sf::Vector2f{facingRight ? 20.f : -20.f, 0}, cfg, 20);
+        scale = next;
+        hysteresis.settle();
+        ++changes;
+        return true;
     }
 
-    void takeDamage(int dmg) {
-        if (invincibility > 0 || state == State::Dead) return;
-        health -= dmg;
-        invincibility = 1.5f;
-        state = State::Hurt;
-        hurtTimer = 0.3f;
-        velocity = {facingRight ? -200.f : 200.f, -150.f};
+    void reset() { scale = 1.f; hysteresis.reset(); }
 
-        ParticleConfig cfg;
-        cfg.startColor = sf::Color(255, 100, 100, 255);
-        cfg.endColor = sf::Color(100, 50, 50, 0);
-        cfg.minSpeed = 100.f; cfg.maxSpeed = 300.f;
-        cfg.spread = 3.14159f;
-        trail.emit(position, cfg, 30);
+    float getScale() const { return scale; }
+    float getSmoothedMs() const { return hysteresis.getSmoothedMs(); }
+    size_t getChangeCount() const { return changes; }
 
-        if (health <= 0) {
-            state = State::Dead;
-            cfg.startColor = sf::Color(180, 220, 255, 255);
-            cfg.endColor = sf::Color(50, 100, 150, 0);
-            cfg.minSpeed = 200.f; cfg.maxSpeed = 500.f;
-            cfg.minLife = 1.f; cfg.maxLife = 2.f;
-            trail.emit(position, cfg, 200);
-        }
-    }
+private:
+    BudgetHysteresis hysteresis{Config::RENDER_BUDGET_MS, 0.6f};
+    float scale = 1.f;
+    size_t changes = 0;
+};
 
-    void heal(int amount) { health = std::min(health + amount, stats.maxHealth); }
+// ============================================================================
+// SUIVI DES ALLOCATIONS
+// ============================================================================
 
-    void createJumpParticles() {
-        ParticleConfig cfg;
-        cfg.startColor = sf::Color(200, 220, 255, 200);
-        cfg.endColor = sf::Color(150, 180, 220, 0);
-        cfg.direction = 1.57f; cfg.spread = 0.8f;
-        cfg.minSpeed = 50.f; cfg.maxSpeed = 150.f;
-        cfg.minLife = 0.2f; cfg.maxLife = 0.4f;
-        trail.emit(position + sf::Vector2f{0, 15.f}, cfg, 15);
-    }
+// Compilé avec SOUL_WORLD_TRACK_ALLOCS, operator new/delete sont remplacés :
+// chaque allocation du thread de jeu est comptée (nombre, octets) pour la
+// frame en cours et pour la portée AllocScope active ; la mémoire vivante et
+// son pic couvrent tous les threads. Sans la macro, les portées sont vides et
+// rien n'est compté.
+namespace AllocTracking {
+
+#if defined(SOUL_WORLD_TRACK_ALLOCS)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Sous-systèmes auxquels on attribue les allocations (portée la plus interne).
+enum class Scope : uint8_t { Other, Input, Simulation, Projectiles, Enemies, Particles, Hud, Render, Menus, Count };
+constexpr size_t SCOPE_COUNT = size_t(Scope::Count);
+inline constexpr const char* NAMES[SCOPE_COUNT] = {
+    "other", "input", "simulation", "projectiles", "enemies", "particles", "hud", "render", "menus"};
+
+struct Counters {
+    size_t allocs = 0;
+    size_t bytes = 0;
+};
 
-    void updateState() {
-        if (state == State::Dead || state == State::Dashing ||
-            state == State::Flying || state == State::Hurt) return;
+struct FrameStats {
+    Counters total;
+    Counters scopes[SCOPE_COUNT];
+    size_t peakLiveBytes = 0;
+};
 
-        if (attackTimer > 0) state = State::Attacking;
-        else if (!isGrounded) state = velocity.y < 0 ? State::Jumping : State::Falling;
-        else if (std::abs(velocity.x) > 20.f) state = State::Running;
-        else state = State::Idle;
+// Cumul depuis le dernier resetSummary(), par portée.
+struct ScopeSummary {
+    size_t allocs = 0, bytes = 0;
+    size_t framesHit = 0;     // frames où la portée a alloué au moins une fois
+    size_t worstFrame = 0;    // allocations de la pire frame
+};
 
-        isAttacking = attackTimer > 0;
-    }
+struct Summary {
+    size_t frames = 0, framesWithAllocs = 0;
+    size_t peakLiveBytes = 0;
+    ScopeSummary scopes[SCOPE_COUNT];
+};
 
-    void draw(sf::RenderTarget& target) const {
-        trail.draw(target);
-        dragonFx.draw(target);
+namespace detail {
+// Constantes à l'initialisation : utilisables avant main() et depuis operator new.
+inline thread_local Scope current = Scope::Other;
+inline thread_local bool frameThread = false;
+inline FrameStats frame;
+inline Summary summary;
+inline std::atomic<size_t> liveBytes{0}, peakLiveBytes{0};
+
+inline void noteAlloc(size_t bytes) {
+    size_t live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    if (!frameThread) return;
+    Counters& scope = frame.scopes[size_t(current)];
+    ++scope.allocs;
+    scope.bytes += bytes;
+    ++frame.total.allocs;
+    frame.total.bytes += bytes;
+    frame.peakLiveBytes = std::max(frame.peakLiveBytes, live);
+}
 
-        if (invincibility > 0 && int(invincibility * 10) % 2 == 0) return;
+inline void noteFree(size_t bytes) { liveBytes.fetch_sub(bytes, std::memory_order_relaxed); }
+} // namespace detail
 
-        target.draw(glow, sf::RenderStates(sf::BlendAdd));
-        target.draw(body);
-        target.draw(eye);
+// Attribue les allocations du bloc à un sous-système ; les portées s'emboîtent.
+class AllocScope {
+public:
+#if defined(SOUL_WORLD_TRACK_ALLOCS)
+    explicit AllocScope(Scope scope) : previous(detail::current) { detail::current = scope; }
+    ~AllocScope() { detail::current = previous; }
+#else
+    explicit AllocScope(Scope) {}
+#endif
 
-        if (isAttacking) {
-            sf::RectangleShape slash{{stats.attackRange, 4.f}};
-            slash.setOrigin({0.f, 2.f});
-            slash.setPosition(position + sf::Vector2f{facingRight ? 18.f : -18.f, 0});
-            slash.setRotation(sf::degrees(facingRight ? -20.f : 200.f));
-            slash.setFillColor(sf::Color(255, 255, 255, 200));
-            target.draw(slash);
-        }
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+#if defined(SOUL_WORLD_TRACK_ALLOCS)
+    Scope previous;
+#endif
+};
+
+// Début de frame ; le thread appelant devient celui dont on compte les allocations.
+inline void beginFrame() {
+    detail::frameThread = true;
+    detail::frame = FrameStats{};
+    detail::frame.peakLiveBytes = detail::liveBytes.load(std::memory_order_relaxed);
+}
 
-        if (!invocationSeq.empty()) {
-            float progress = float(invocationSeq.length()) / 3.f;
-            sf::CircleShape ind(5.f + 5.f * progress);
-            ind.setOrigin({ind.getRadius(), ind.getRadius()});
-            ind.setPosition(position + sf::Vector2f{0, -40.f});
-            ind.setFillColor(sf::Color(uint8_t(100 + 155 * progress), 200, 255, 200));
-            target.draw(ind);
+// Fin de frame : renvoie ses compteurs et les ajoute au cumul.
+inline FrameStats endFrame() {
+    const FrameStats& f = detail::frame;
+    Summary& s = detail::summary;
+    ++s.frames;
+    if (f.total.allocs) ++s.framesWithAllocs;
+    s.peakLiveBytes = std::max(s.peakLiveBytes, f.peakLiveBytes);
+    for (size_t i = 0; i < SCOPE_COUNT; ++i) {
+        ScopeSummary& scope = s.scopes[i];
+        scope.allocs += f.scopes[i].allocs;
+        scope.bytes += f.scopes[i].bytes;
+        if (f.scopes[i].allocs) ++scope.framesHit;
+        scope.worstFrame = std::max(scope.worstFrame, f.scopes[i].allocs);
+    }
+    return f;
+}
+
+inline const Summary& summary() { return detail::summary; }
+inline void resetSummary() { detail::summary = Summary{}; }
+inline size_t getLiveBytes() { return detail::liveBytes.load(std::memory_order_relaxed); }
+inline size_t getPeakLiveBytes() { return detail::peakLiveBytes.load(std::memory_order_relaxed); }
+
+// Bilan lisible : les portées qui allouent à chaque frame d'abord.
+inline void report(std::ostream& out) {
+    const Summary& s = detail::summary;
+    out << "Allocations : " << s.framesWithAllocs << "/" << s.frames << " frames allouent, pic vivant "
+        << s.peakLiveBytes / 1024 << " Ko" << std::endl;
+    for (bool everyFrame : {true, false}) {
+        for (size_t i = 0; i < SCOPE_COUNT; ++i) {
+            const ScopeSummary& scope = s.scopes[i];
+            if (!scope.allocs || (scope.framesHit == s.frames) != everyFrame) continue;
+            out << "  " << NAMES[i] << (everyFrame ? " [chaque frame]" : "") << " : " << scope.allocs
+                << " allocs, " << scope.bytes << " octets, " << scope.framesHit << " frames, pire frame "
+                << scope.worstFrame << std::endl;
         }
     }
+}
 
-    void reset(sf::Vector2f pos) {
-        position = pos;
-        velocity = {0, 0};
-        health = stats.maxHealth;
-        soulEnergy = 0;
-        state = State::Idle;
-        flightTimer = 0;
-        invincibility = 0;
-        body.setFillColor(sf::Color(180, 220, 255, 230));
-        glow.setRadius(25.f);
-        glow.setOrigin({25.f, 25.f});
+} // namespace AllocTracking
+
+using AllocTracking::AllocScope;
+
+#if defined(SOUL_WORLD_TRACK_ALLOCS)
+// Un en-tête devant chaque bloc garde sa taille (les delete non dimensionnés
+// ne la donnent pas) ; il préserve l'alignement de malloc. Les versions
+// alignées (align_val_t) ne sont pas remplacées et ne sont pas comptées.
+// allocate/release restent hors ligne : inlinés jusque dans les conteneurs,
+// GCC voit le décalage d'en-tête et le malloc/free sous new/delete, et le
+// signale à tort (-Warray-bounds, -Wmismatched-new-delete).
+#if defined(_MSC_VER)
+#define SOUL_WORLD_NOINLINE __declspec(noinline)
+#else
+#define SOUL_WORLD_NOINLINE __attribute__((noinline))
+#endif
+
+namespace AllocTracking::detail {
+constexpr size_t HEADER = alignof(std::max_align_t);
+
+SOUL_WORLD_NOINLINE void* allocate(size_t bytes) noexcept {
+    void* raw = std::malloc(bytes + HEADER);
+    if (!raw) return nullptr;
+    *static_cast<size_t*>(raw) = bytes;
+    noteAlloc(bytes);
+    return static_cast<std::byte*>(raw) + HEADER;
+}
+
+SOUL_WORLD_NOINLINE void release(void* p) noexcept {
+    if (!p) return;
+    void* raw = static_cast<std::byte*>(p) - HEADER;
+    noteFree(*static_cast<size_t*>(raw));
+    std::free(raw);
+}
+} // namespace AllocTracking::detail
+
+void* operator new(size_t bytes) {
+    if (void* p = AllocTracking::detail::allocate(bytes)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t bytes) {
+    if (void* p = AllocTracking::detail::allocate(bytes)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return AllocTracking::detail::allocate(bytes); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return AllocTracking::detail::allocate(bytes); }
+void operator delete(void* p) noexcept { AllocTracking::detail::release(p); }
+void operator delete[](void* p) noexcept { AllocTracking::detail::release(p); }
+void operator delete(void* p, size_t) noexcept { AllocTracking::detail::release(p); }
+void operator delete[](void* p, size_t) noexcept { AllocTracking::detail::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { AllocTracking::detail::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { AllocTracking::detail::release(p); }
+#endif
+
+// ============================================================================
+// ATLAS DE SPRITES
+// ============================================================================
+
+// Disques, halos à décroissance radiale et ailes rasterisés une fois dans une
+// texture : les entités les dessinent en quads texturés au lieu de disques
+// de 30 segments. Le coin de la cellule 0 est blanc et opaque, et les sommets
+// sans coordonnées de texture (0, 0) y tombent : les formes unies d'un
+// ShapeBatch passent dans le même draw que les sprites. Le reste de l'image
+// est transparent au bord des cellules (pas de fuite au filtrage).
+//
+// L'image est cuite sur un thread de ressources et mise en cache sur disque
+// (.swa : en-tête puis pixels RGBA bruts), nommée par l'empreinte des
+// paramètres de cuisson : un démarrage suivant la relit sans rien refaire, et
+// changer un paramètre invalide le cache de lui-même.
+class SpriteAtlas {
+public:
+    enum class Sprite : uint8_t { Solid, Disc, Glow, Wing, Count };
+
+    static constexpr unsigned int CELL = 128;
+    static constexpr float PAD = 2.f; // marge de chaque cellule pour le filtrage bilinéaire
+    static constexpr unsigned int SOLID_SIZE = 8;
+    static constexpr float GLOW_SPREAD = 1.25f; // le halo dégradé déborde du disque plat qu'il remplace
+    static constexpr uint32_t MAGIC = 0x41575753; // "SWWA" en little-endian
+    static constexpr uint32_t VERSION = 1;
+    // Formules de bake() et wingCoverage() (lissage des bords, décroissance
+    // smoothstep du halo) : à incrémenter quand l'une d'elles change.
+    static constexpr uint32_t BAKE_REVISION = 1;
+
+    // Triangle de l'aile dans sa cellule (pixels) : attache, pointe, bord de fuite.
+    static constexpr float WING[3][2] = {{6.f, 64.f}, {122.f, 6.f}, {96.f, 122.f}};
+    // Nervures (niveau de base, profondeur, nombre par tour) et fondu vers la pointe.
+    static constexpr float WING_VEIN_BASE = 0.85f, WING_VEIN_DEPTH = 0.15f, WING_VEIN_COUNT = 24.f;
+    static constexpr float WING_TIP_FADE = 0.55f;
+
+    // Empreinte de tout ce qui détermine les pixels : constantes ci-dessus et
+    // révision des formules.
+    static uint64_t contentHash() {
+        uint64_t h = 1469598103934665603ull;
+        auto mix = [&h](const void* data, size_t n) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < n; ++i) { h ^= bytes[i]; h *= 1099511628211ull; }
+        };
+        const uint32_t params[] = {VERSION, BAKE_REVISION, CELL, SOLID_SIZE, uint32_t(Sprite::Count)};
+        const float shape[] = {PAD, WING[0][0], WING[0][1], WING[1][0], WING[1][1], WING[2][0], WING[2][1],
+                               WING_VEIN_BASE, WING_VEIN_DEPTH, WING_VEIN_COUNT, WING_TIP_FADE};
+        mix(params, sizeof(params));
+        mix(shape, sizeof(shape));
+        return h;
     }
 
-    void fullReset(sf::Vector2f pos) {
-        reset(pos);
-        stats.reset();
+    static std::string cachePath(const std::string& directory) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "atlas_%016llx.swa", static_cast<unsigned long long>(contentHash()));
+        return directory.empty() ? name : directory + "/" + name;
     }
 
-    sf::Vector2f getPosition() const { return position; }
-    int getHealth() const { return health; }
-    int getSoulEnergy() const { return soulEnergy; }
-    State getState() const { return state; }
-    sf::FloatRect getAttackBounds() const { return attackBounds; }
-    bool getIsAttacking() const { return isAttacking; }
-    float getFlightTimer() const { return flightTimer; }
-    PlayerStats& getStats() { return stats; }
-    const PlayerStats& getStats() const { return stats; }
+    // Dossier de cache de l'utilisateur ($XDG_CACHE_HOME ou ~/.cache,
+    // %LOCALAPPDATA% sous Windows), créé au besoin ; à défaut, celui du paquet
+    // de ressources. Jamais le dossier courant par principe.
+    static std::string cacheDirectory(const std::string& packPath) {
+        namespace fs = std::filesystem;
+        fs::path base;
+#if defined(_WIN32)
+        if (const char* local = std::getenv("LOCALAPPDATA"); local && *local) base = local;
+#else
+        if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) base = xdg;
+        else if (const char* home = std::getenv("HOME"); home && *home) base = fs::path(home) / ".cache";
+#endif
+        if (!base.empty()) {
+            std::error_code ec;
+            fs::path dir = base / Config::ATLAS_CACHE_SUBDIR;
+            fs::create_directories(dir, ec);
+            if (!ec) return dir.string();
+        }
+        fs::path pack = fs::path(packPath).parent_path();
+        return pack.empty() ? "." : pack.string();
+    }
 
-    void addSoul(int amt) { soulEnergy = std::min(soulEnergy + amt, Config::MAX_SOUL_ENERGY); }
-    int getAttackDamage() const { return stats.attackDamage; }
+    // Thread de ressources : relit le cache, ou cuit l'image et l'y écrit.
+    static sf::Image loadOrBake(const std::string& directory) {
+        std::string path = cachePath(directory);
+        if (std::optional<sf::Image> cached = readCache(path)) return std::move(*cached);
+        sf::Image image = bake();
+        if (writeCache(path, image)) removeStaleCaches(directory, path);
+        else std::cerr << "Cache de l'atlas non ecrit: " << path << std::endl;
+        return image;
+    }
 
-private:
-    sf::Vector2f position;
-    sf::Vector2f velocity{0, 0};
-    sf::Vector2f platformVelocity{0, 0};
+    static sf::Image bake() {
+        sf::Image image({CELL * unsigned(Sprite::Count), CELL}, sf::Color::Transparent);
+        const float center = CELL / 2.f, radius = CELL / 2.f - PAD;
+        for (unsigned int y = 0; y < CELL; ++y) {
+            for (unsigned int x = 0; x < CELL; ++x) {
+                float px = float(x) + 0.5f, py = float(y) + 0.5f;
+                float d = std::hypot(px - center, py - center);
+                // Bord du disque lissé sur un pixel.
+                float disc = std::clamp(radius - d + 0.5f, 0.f, 1.f);
+                float t = std::clamp(d / radius, 0.f, 1.f);
+                float glow = 1.f - t * t * (3.f - 2.f * t);
+                if (x < SOLID_SIZE && y < SOLID_SIZE) image.setPixel({x, y}, sf::Color::White);
+                image.setPixel({CELL + x, y}, sf::Color(255, 255, 255, alpha(disc)));
+                image.setPixel({2 * CELL + x, y}, sf::Color(255, 255, 255, alpha(glow)));
+                image.setPixel({3 * CELL + x, y}, sf::Color(255, 255, 255, alpha(wingCoverage(px, py))));
+            }
+        }
+        return image;
+    }
 
-    sf::CircleShape body, glow, eye;
+    // Thread de jeu : envoie l'image cuite au GPU.
+    bool upload(const sf::Image& image) {
+        if (!texture.loadFromImage(image)) {
+            std::cerr << "Atlas de sprites non charge, formes tessellees" << std::endl;
+            return false;
+        }
+        texture.setSmooth(true);
+        ready = true;
+        return true;
+    }
 
-    State state = State::Idle;
-    bool facingRight = true;
-    bool isGrounded = false;
-    bool isAttacking = false;
+    bool isReady() const { return ready; }
+    const sf::Texture& getTexture() const { return texture; }
 
-    int health = Config::MAX_HEALTH;
-    int soulEnergy = 0;
+    // Coordonnées de texture (pixels) d'un point de la cellule.
+    static sf::Vector2f texel(Sprite sprite, float x, float y) {
+        return {float(unsigned(sprite) * CELL) + x, y};
+    }
 
-    float dashTimer = 0, dashCooldown = 0;
-    float attackTimer = 0, attackCooldown = 0;
-    float invincibility = 0, hurtTimer = 0;
-    float coyoteTimer = 0, jumpBufferTimer = 0;
-    float flightTimer = 0, invocationTimer = 0;
-    float animTimer = 0;
+private:
+    static uint8_t alpha(float v) { return uint8_t(std::lround(std::clamp(v, 0.f, 1.f) * 255.f)); }
+
+    // Aile : opaque à l'attache, plus transparente vers la pointe, avec des
+    // nervures qui partent de l'attache ; bords lissés sur un pixel.
+    static float wingCoverage(float x, float y) {
+        float edge = 1e9f;
+        for (int i = 0; i < 3; ++i) {
+            const float* a = WING[i];
+            const float* b = WING[(i + 1) % 3];
+            const float* c = WING[(i + 2) % 3];
+            float ex = b[0] - a[0], ey = b[1] - a[1];
+            float len = std::hypot(ex, ey);
+            // Distance signée à l'arête, positive du côté du troisième sommet.
+            float side = ((c[0] - a[0]) * ey - (c[1] - a[1]) * ex) > 0 ? 1.f : -1.f;
+            edge = std::min(edge, side * ((x - a[0]) * ey - (y - a[1]) * ex) / len);
+        }
+        float coverage = std::clamp(edge + 0.5f, 0.f, 1.f);
+        float reach = std::hypot(x - WING[0][0], y - WING[0][1]) / std::hypot(WING[1][0] - WING[0][0], WING[1][1] - WING[0][1]);
+        float veins = WING_VEIN_BASE + WING_VEIN_DEPTH * std::cos(std::atan2(y - WING[0][1], x - WING[0][0]) * WING_VEIN_COUNT);
+        return coverage * (1.f - WING_TIP_FADE * std::clamp(reach, 0.f, 1.f)) * veins;
+    }
 
-    std::string invocationSeq;
-    sf::FloatRect attackBounds;
-    PlayerStats stats;
+    static std::optional<sf::Image> readCache(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return std::nullopt;
+        uint32_t header[4];
+        uint64_t hash = 0;
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || !in.read(reinterpret_cast<char*>(&hash), sizeof(hash)) ||
+            header[0] != MAGIC || header[1] != VERSION || header[2] != CELL * unsigned(Sprite::Count) || header[3] != CELL ||
+            hash != contentHash())
+            return std::nullopt;
+        std::vector<uint8_t> pixels(size_t(header[2]) * header[3] * 4);
+        if (!in.read(reinterpret_cast<char*>(pixels.data()), std::streamsize(pixels.size()))) return std::nullopt;
+        return sf::Image({header[2], header[3]}, pixels.data());
+    }
+
+    // Écrit un fichier temporaire propre à cet appel, puis le renomme sur le
+    // cache : un démarrage concurrent (ou un arrêt en cours d'écriture) ne
+    // laisse jamais de cache tronqué sous le nom final.
+    static bool writeCache(const std::string& path, const sf::Image& image) {
+        std::string temp = path + ".tmp" + std::to_string(std::random_device{}());
+        std::ofstream out(temp, std::ios::binary);
+        uint32_t header[4] = {MAGIC, VERSION, image.getSize().x, image.getSize().y};
+        uint64_t hash = contentHash();
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        out.write(reinterpret_cast<const char*>(image.getPixelsPtr()), std::streamsize(size_t(image.getSize().x) * image.getSize().y * 4));
+        out.close();
+#if defined(_WIN32)
+        bool written = out && MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        bool written = out && std::rename(temp.c_str(), path.c_str()) == 0;
+#endif
+        if (!written) std::remove(temp.c_str());
+        return written;
+    }
+
+    // Caches d'empreintes précédentes (un par changement de paramètres,
+    // jamais relus) : supprimés une fois le cache courant écrit.
+    static void removeStaleCaches(const std::string& directory, const std::string& current) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::path keep = fs::path(current).filename();
+        for (fs::directory_iterator it(directory.empty() ? "." : directory, ec), end; !ec && it != end; it.increment(ec)) {
+            fs::path name = it->path().filename();
+            std::string file = name.string();
+            if (name != keep && file.starts_with("atlas_") && name.extension() == ".swa") {
+                std::error_code removeError;
+                fs::remove(it->path(), removeError);
+            }
+        }
+    }
 
-    mutable ParticleSystem trail{1000};
-    mutable ParticleSystem dragonFx{500};
+    sf::Texture texture;
+    bool ready = false;
 };
 
 // ============================================================================
-// ENNEMI (VOL LIMITÉ + MARCHE AU SOL)
+// MÉMOIRE DE FRAME
 // ============================================================================
 
-class Enemy {
+// Arène linéaire remise à zéro une fois par frame : le stockage temporaire du
+// rendu y est pris par simple incrément de pointeur. Si elle déborde, on passe
+// par le tas et on le compte, pour ajuster FRAME_ARENA_BYTES.
+class FrameArena : public std::pmr::memory_resource {
 public:
-    enum class Type { Red, Blue, Yellow };
-    enum class MovementState { Walking, Flying, Falling };
-
-    Enemy(sf::Vector2f pos, Type type, int waveNumber)
-    : position(pos), startPos(pos), type(type) {
+    explicit FrameArena(size_t capacity = Config::FRAME_ARENA_BYTES)
+    : buffer(std::make_unique<std::byte[]>(capacity)), capacity(capacity) {}
 
-        float waveMult = 1.f + waveNumber * 0.15f;
-        baseHealth = int(3 * waveMult);
-        health = baseHealth;
-        damage = 1 + waveNumber / 5;
-        speed = 80.f + waveNumber * 5.f;
-        flyCooldown = Random::instance().range(2.f, 6.f);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
 
-        setupVisuals();
+    // Début de frame : plus rien de la frame précédente ne doit être vivant.
+    void reset() {
+        peak = std::max(peak, offset);
+        offset = 0;
     }
 
-    void setupVisuals() {
-        float radius = 20.f;
-        sf::Color color;
+    size_t used() const { return offset; }
+    size_t getPeak() const { return std::max(peak, offset); }
+    size_t getOverflowCount() const { return overflowCount; }
 
-        switch (type) {
-            case Type::Red: color = sf::Color(200, 80, 80, 230); break;
-            case Type::Blue: color = sf::Color(80, 120, 200, 230); radius = 22.f; break;
-            case Type::Yellow: color = sf::Color(220, 200, 80, 230); radius = 18.f; break;
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        size_t start = (offset + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > capacity) {
+            ++overflowCount;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
         }
+        offset = start + bytes;
+        return buffer.get() + start;
+    }
 
-        body.setRadius(radius);
-        body.setOrigin({radius, radius});
-        body.setFillColor(color);
-        body.setOutlineThickness(2.f);
-        body.setOutlineColor(sf::Color(color.r / 2, color.g / 2, color.b / 2, 200));
+    // Dans l'arène : rien à faire, tout est rendu par reset().
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::byte* b = static_cast<std::byte*>(p);
+        if (b < buffer.get() || b >= buffer.get() + capacity)
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
 
-        eye.setRadius(5.f);
-        eye.setOrigin({5.f, 5.f});
-        eye.setFillColor(type == Type::Yellow ? sf::Color(50, 50, 50) : sf::Color(255, 200, 50));
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
 
-        baseColor = color;
-    }
+    std::unique_ptr<std::byte[]> buffer;
+    size_t capacity;
+    size_t offset = 0;
+    size_t peak = 0;
+    size_t overflowCount = 0;
+};
 
-    void update(float dt, const sf::Vector2f& playerPos,
-                std::vector<Projectile>& projectiles,
-                const std::vector<Platform>& platforms) {
-        if (!alive) return;
+// Formes temporaires (rectangles, disques, triangles) écrites en triangles
+// dans l'arène de frame et envoyées en un seul draw, à la place des
+// sf::Shape construites à chaque frame. flush() garde la capacité.
+// Avec un atlas prêt, disques, halos et ailes sont des sprites texturés du
+// même draw ; sans atlas, ils retombent sur des formes tessellées.
+class ShapeBatch {
+public:
+    explicit ShapeBatch(FrameArena& arena, size_t reserve = 4096, const SpriteAtlas* atlas = nullptr)
+    : vertices(&arena), atlas(atlas && atlas->isReady() ? atlas : nullptr) { vertices.reserve(reserve); }
 
-        updateFlightState(dt, playerPos);
+    void triangle(sf::Vector2f a, sf::Vector2f b, sf::Vector2f c, sf::Color color) {
+        vertices.push_back({a, color});
+        vertices.push_back({b, color});
+        vertices.push_back({c, color});
+    }
 
-        if (moveState != MovementState::Flying) {
-            velocity.y += Config::GRAVITY * dt;
-            velocity.y = std::min(velocity.y, 600.f);
-        }
+    void quad(sf::Vector2f a, sf::Vector2f b, sf::Vector2f c, sf::Vector2f d, sf::Color color) {
+        triangle(a, b, c, color);
+        triangle(a, c, d, color);
+    }
 
-        switch (moveState) {
-            case MovementState::Walking: updateWalking(dt, playerPos, projectiles); break;
-            case MovementState::Flying: updateFlying(dt, playerPos, projectiles); break;
-            case MovementState::Falling: velocity.x *= 0.98f; break;
-        }
+    void rect(sf::Vector2f pos, sf::Vector2f size, sf::Color color) {
+        quad(pos, {pos.x + size.x, pos.y}, pos + size, {pos.x, pos.y + size.y}, color);
+    }
 
-        position += velocity * dt;
+    // Contour à l'extérieur du rectangle, comme setOutlineThickness.
+    void outline(sf::Vector2f pos, sf::Vector2f size, float t, sf::Color color) {
+        rect({pos.x - t, pos.y - t}, {size.x + 2 * t, t}, color);
+        rect({pos.x - t, pos.y + size.y}, {size.x + 2 * t, t}, color);
+        rect({pos.x - t, pos.y}, {t, size.y}, color);
+        rect({pos.x + size.x, pos.y}, {t, size.y}, color);
+    }
 
-        isGrounded = false;
-        for (const auto& plat : platforms) resolveCollision(plat);
+    void panel(sf::Vector2f pos, sf::Vector2f size, sf::Color fill, float t, sf::Color border) {
+        rect(pos, size, fill);
+        outline(pos, size, t, border);
+    }
 
-        if (position.y > 1030.f) {
-            position.y = 1030.f;
-            velocity.y = 0;
-            isGrounded = true;
-            if (moveState == MovementState::Falling) moveState = MovementState::Walking;
+    // Rectangle tourné autour de pivot ; offset : coin haut-gauche relatif au pivot.
+    void rotatedRect(sf::Vector2f pivot, sf::Vector2f offset, sf::Vector2f size, float degrees, sf::Color color) {
+        float a = degrees * 3.14159265f / 180.f, c = std::cos(a), s = std::sin(a);
+        auto at = [&](float x, float y) { return pivot + sf::Vector2f{x * c - y * s, x * s + y * c}; };
+        quad(at(offset.x, offset.y), at(offset.x + size.x, offset.y),
+             at(offset.x + size.x, offset.y + size.y), at(offset.x, offset.y + size.y), color);
+    }
+
+    void circle(sf::Vector2f center, float radius, sf::Color color, int points = 30) {
+        sf::Vector2f prev = center + sf::Vector2f{radius, 0};
+        for (int i = 1; i <= points; ++i) {
+            float a = 6.2831853f * float(i) / float(points);
+            sf::Vector2f next = center + sf::Vector2f{std::cos(a) * radius, std::sin(a) * radius};
+            triangle(center, prev, next, color);
+            prev = next;
         }
+    }
 
-        position.x = std::clamp(position.x, 120.f, 2880.f);
+    // Disque plein ; points : segments de la forme de repli, sans atlas.
+    void disc(sf::Vector2f center, float radius, sf::Color color, int points = 30) {
+        if (!atlas) {
+            circle(center, radius, color, points);
+            return;
+        }
+        // Le disque cuit a pour rayon CELL / 2 - PAD : le quad couvre toute la cellule.
+        float half = radius * SpriteAtlas::CELL / (SpriteAtlas::CELL - 2.f * SpriteAtlas::PAD);
+        sprite(SpriteAtlas::Sprite::Disc, center, half, color);
+    }
 
-        float visualY = position.y;
-        if (isGrounded && moveState == MovementState::Walking) {
-            visualY += std::sin(animTimer * 3.f) * 2.f;
+    // Anneau de inner à outer, en quads pleins (sans lissage, comme les
+    // contours de sf::Shape).
+    void ring(sf::Vector2f center, float inner, float outer, sf::Color color, int points = 30) {
+        sf::Vector2f prevIn = center + sf::Vector2f{inner, 0}, prevOut = center + sf::Vector2f{outer, 0};
+        for (int i = 1; i <= points; ++i) {
+            float a = 6.2831853f * float(i) / float(points);
+            sf::Vector2f dir{std::cos(a), std::sin(a)};
+            sf::Vector2f in = center + dir * inner, out = center + dir * outer;
+            quad(prevIn, prevOut, out, in, color);
+            prevIn = in;
+            prevOut = out;
         }
+    }
 
-        body.setPosition({position.x, visualY});
-        eye.setPosition({position.x + (facingRight ? 6.f : -6.f), visualY - 5.f});
-        animTimer += dt;
+    // Disque cerclé d'un contour extérieur (comme setOutlineThickness). Le
+    // contour est un anneau et non un disque sous le remplissage : un
+    // remplissage translucide laisse voir le fond, pas le contour.
+    void outlinedDisc(sf::Vector2f center, float radius, sf::Color fill, float thickness, sf::Color border) {
+        disc(center, radius, fill);
+        ring(center, radius, radius + thickness, border, 16);
+    }
 
-        if (hitFlash > 0) {
-            hitFlash -= dt;
-            body.setFillColor(sf::Color::White);
-        } else {
-            body.setFillColor(baseColor);
+    // Halo additif. Sans atlas : disque plat du rayon donné. Avec : dégradé
+    // radial un peu plus large, pour une énergie lumineuse comparable.
+    void glow(sf::Vector2f center, float radius, sf::Color color, int points = 30) {
+        if (!atlas) {
+            circle(center, radius, color, points);
+            return;
         }
+        float half = radius * SpriteAtlas::GLOW_SPREAD * SpriteAtlas::CELL / (SpriteAtlas::CELL - 2.f * SpriteAtlas::PAD);
+        sprite(SpriteAtlas::Sprite::Glow, center, half, color);
+    }
 
-        particles.update(dt);
-                }
+    // Aile : attache, pointe, bord de fuite.
+    void wing(sf::Vector2f root, sf::Vector2f tip, sf::Vector2f trailing, sf::Color color) {
+        if (!atlas) {
+            triangle(root, tip, trailing, color);
+            return;
+        }
+        const auto& w = SpriteAtlas::WING;
+        vertices.push_back({root, color, SpriteAtlas::texel(SpriteAtlas::Sprite::Wing, w[0][0], w[0][1])});
+        vertices.push_back({tip, color, SpriteAtlas::texel(SpriteAtlas::Sprite::Wing, w[1][0], w[1][1])});
+        vertices.push_back({trailing, color, SpriteAtlas::texel(SpriteAtlas::Sprite::Wing, w[2][0], w[2][1])});
+    }
 
-                void updateFlightState(float dt, const sf::Vector2f& playerPos) {
-                    switch (moveState) {
-                        case MovementState::Walking:
-                            flyCooldown -= dt;
-                            if (flyCooldown <= 0 && isGrounded) {
-                                float dist = Math::distance(position, playerPos);
-                                if (dist < 500.f && Random::instance().range(0, 100) < 30) {
-                                    moveState = MovementState::Flying;
-                                    flyTimer = Config::ENEMY_FLY_DURATION;
-                                    velocity.y = -200.f;
+    void flush(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default) {
+        if (vertices.empty()) return;
+        sf::RenderStates textured = states;
+        if (atlas) textured.texture = &atlas->getTexture();
+        target.draw(vertices.data(), vertices.size(), sf::PrimitiveType::Triangles, textured);
+        vertices.clear();
+    }
 
-                                    ParticleConfig cfg;
-                                    cfg.startColor = baseColor;
-                                    cfg.endColor = sf::Color(baseColor.r/2, baseColor.g/2, baseColor.b/2, 0);
-                                    cfg.direction = 1.57f; cfg.spread = 0.8f;
-                                    cfg.minSpeed = 50.f; cfg.maxSpeed = 150.f;
-                                    cfg.minLife = 0.3f; cfg.maxLife = 0.5f;
-                                    particles.emit(position + sf::Vector2f{0, 15.f}, cfg, 15);
-                                } else {
-                                    flyCooldown = Random::instance().range(3.f, 8.f);
-                                }
-                            }
-                            break;
-                        case MovementState::Flying:
-                            flyTimer -= dt;
-                            if (flyTimer <= 0) {
-                                moveState = MovementState::Falling;
-                                flyCooldown = Config::ENEMY_FLY_COOLDOWN;
-                            }
-                            break;
-                        case MovementState::Falling: break;
-                    }
-                }
+    size_t size() const { return vertices.size(); }
 
-                void updateWalking(float dt, const sf::Vector2f& playerPos, std::vector<Projectile>& projectiles) {
-                    float dist = Math::distance(position, playerPos);
+private:
+    // Quad texturé couvrant une cellule, de demi-côté half.
+    void sprite(SpriteAtlas::Sprite s, sf::Vector2f center, float half, sf::Color color) {
+        const float c = float(SpriteAtlas::CELL);
+        sf::Vector2f a = center - sf::Vector2f{half, half}, b = center + sf::Vector2f{half, half};
+        sf::Vertex tl{a, color, SpriteAtlas::texel(s, 0.f, 0.f)};
+        sf::Vertex tr{{b.x, a.y}, color, SpriteAtlas::texel(s, c, 0.f)};
+        sf::Vertex br{b, color, SpriteAtlas::texel(s, c, c)};
+        sf::Vertex bl{{a.x, b.y}, color, SpriteAtlas::texel(s, 0.f, c)};
+        vertices.insert(vertices.end(), {tl, tr, br, tl, br, bl});
+    }
 
-                    if (dist < 400.f) {
-                        float dir = playerPos.x > position.x ? 1.f : -1.f;
-                        velocity.x = dir * speed;
-                        facingRight = dir > 0;
-                    } else {
-                        velocity.x = speed * patrolDir * 0.5f;
-                        if (position.x > startPos.x + patrolRange) patrolDir = -1;
-                        else if (position.x < startPos.x - patrolRange) patrolDir = 1;
-                        facingRight = patrolDir > 0;
-                    }
+    std::pmr::vector<sf::Vertex> vertices;
+    const SpriteAtlas* atlas;
+};
 
-                    if (type == Type::Blue) {
-                        shootCooldown -= dt;
-                        if (shootCooldown <= 0 && dist < 500.f) {
-                            shootCooldown = 2.5f;
-                            sf::Vector2f dir = Math::normalize(playerPos - position);
-                            projectiles.emplace_back(position, dir, 200.f, sf::Color(100, 150, 255));
-
-                            ParticleConfig cfg;
-                            cfg.startColor = sf::Color(100, 150, 255, 255);
-                            cfg.endColor = sf::Color(50, 100, 200, 0);
-                            cfg.direction = std::atan2(dir.y, dir.x);
-                            cfg.spread = 0.3f;
-                            cfg.minSpeed = 100.f; cfg.maxSpeed = 200.f;
-                            cfg.minLife = 0.2f; cfg.maxLife = 0.4f;
-                            particles.emit(position, cfg, 15);
-                        }
-                    }
+// Lot de la frame pour le monde : les formes sous les entités (effets
+// additifs), et celles dessinées par-dessus (barres de vie, attaques),
+// avec le palier de qualité en vigueur pour cette frame.
+struct FrameBatches {
+    explicit FrameBatches(FrameArena& arena, const QualityLevel& quality = QualityLevels::get(0),
+                          const SpriteAtlas* atlas = nullptr)
+    : arena(arena), scratch(arena, 4096, atlas), glow(arena, 4096, atlas), overlay(arena, 4096, atlas), quality(quality) {}
+
+    FrameArena& arena;
+    ShapeBatch scratch;
+    ShapeBatch glow;
+    ShapeBatch overlay;
+    const QualityLevel& quality;
+};
 
-                    if (type == Type::Yellow && isGrounded) {
-                        jumpCooldown -= dt;
-                        if (jumpCooldown <= 0 && dist < 300.f) {
-                            jumpCooldown = 1.5f;
-                            velocity.y = -400.f;
-                            isGrounded = false;
+// ============================================================================
+// PARTICULES
+// ============================================================================
 
-                            ParticleConfig cfg;
-                            cfg.startColor = sf::Color(255, 220, 100, 255);
-                            cfg.endColor = sf::Color(200, 150, 50, 0);
-                            cfg.direction = 1.57f; cfg.spread = 0.8f;
-                            cfg.minSpeed = 80.f; cfg.maxSpeed = 150.f;
-                            cfg.minLife = 0.2f; cfg.maxLife = 0.4f;
-                            particles.emit(position + sf::Vector2f{0, 15.f}, cfg, 15);
-                        }
-                    }
-                }
+// Couleur et taille au fil de la vie d'une particule : quelques arrêts
+// (âge normalisé 0..1, croissant), interpolés linéairement entre eux. La
+// taille est un facteur appliqué à la taille tirée à l'émission.
+struct ParticleGradient {
+    static constexpr size_t MAX_STOPS = 4;
 
-                void updateFlying(float dt, const sf::Vector2f& playerPos, std::vector<Projectile>& projectiles) {
-                    sf::Vector2f dir = Math::normalize(playerPos - position);
-                    velocity.x = Math::lerp(velocity.x, dir.x * speed * 1.5f, dt * 3.f);
-                    velocity.y = Math::lerp(velocity.y, dir.y * speed * 0.8f, dt * 2.f);
+    struct ColorStop {
+        float at = 0;
+        sf::Color color;
+        bool operator==(const ColorStop&) const = default;
+    };
+    struct SizeStop {
+        float at = 0;
+        float scale = 1.f;
+        bool operator==(const SizeStop&) const = default;
+    };
 
-                    if (position.y < 200.f) velocity.y = std::max(velocity.y, 0.f);
+    std::array<ColorStop, MAX_STOPS> colors{};
+    std::array<SizeStop, MAX_STOPS> sizes{};
+    uint8_t colorCount = 0, sizeCount = 0;
+
+    // Arrêts au-delà de MAX_STOPS ignorés.
+    static constexpr ParticleGradient make(std::initializer_list<ColorStop> colorStops, std::initializer_list<SizeStop> sizeStops) {
+        ParticleGradient g;
+        for (const ColorStop& stop : colorStops)
+            if (g.colorCount < MAX_STOPS) g.colors[g.colorCount++] = stop;
+        for (const SizeStop& stop : sizeStops)
+            if (g.sizeCount < MAX_STOPS) g.sizes[g.sizeCount++] = stop;
+        return g;
+    }
 
-                    facingRight = velocity.x > 0;
+    // Fondu de start à end, taille de 100 % à 0.
+    static constexpr ParticleGradient fade(sf::Color start, sf::Color end) {
+        return make({{0.f, start}, {1.f, end}}, {{0.f, 1.f}, {1.f, 0.f}});
+    }
 
-                    ParticleConfig cfg;
-                    cfg.startColor = sf::Color(baseColor.r, baseColor.g, baseColor.b, 150);
-                    cfg.endColor = sf::Color(baseColor.r/2, baseColor.g/2, baseColor.b/2, 0);
-                    cfg.direction = 1.57f; cfg.spread = 0.5f;
-                    cfg.minSpeed = 30.f; cfg.maxSpeed = 60.f;
-                    cfg.minLife = 0.2f; cfg.maxLife = 0.4f;
-                    cfg.minSize = 4.f; cfg.maxSize = 8.f;
+    constexpr sf::Color colorAt(float t) const {
+        if (colorCount == 0) return sf::Color::White;
+        size_t i = 1;
+        while (i < colorCount && colors[i].at < t) ++i;
+        if (i == colorCount) return colors[colorCount - 1].color;
+        const ColorStop& a = colors[i - 1];
+        const ColorStop& b = colors[i];
+        float u = b.at > a.at ? std::clamp((t - a.at) / (b.at - a.at), 0.f, 1.f) : 1.f;
+        auto mix = [u](uint8_t x, uint8_t y) { return uint8_t(Math::lerp(float(x), float(y), u) + 0.5f); };
+        return {mix(a.color.r, b.color.r), mix(a.color.g, b.color.g), mix(a.color.b, b.color.b), mix(a.color.a, b.color.a)};
+    }
 
-                    if (int(animTimer * 10) % 3 == 0) {
-                        particles.emit(position + sf::Vector2f{0, 10.f}, cfg, 1);
-                    }
+    constexpr float sizeAt(float t) const {
+        if (sizeCount == 0) return 1.f;
+        size_t i = 1;
+        while (i < sizeCount && sizes[i].at < t) ++i;
+        if (i == sizeCount) return sizes[sizeCount - 1].scale;
+        const SizeStop& a = sizes[i - 1];
+        const SizeStop& b = sizes[i];
+        float u = b.at > a.at ? std::clamp((t - a.at) / (b.at - a.at), 0.f, 1.f) : 1.f;
+        return Math::lerp(a.scale, b.scale, u);
+    }
 
-                    if (type == Type::Blue) {
-                        shootCooldown -= dt;
-                        float dist = Math::distance(position, playerPos);
-                        if (shootCooldown <= 0 && dist < 600.f) {
-                            shootCooldown = 1.5f;
-                            sf::Vector2f shootDir = Math::normalize(playerPos - position);
-                            projectiles.emplace_back(position, shootDir, 250.f, sf::Color(100, 150, 255));
-                        }
-                    }
-                }
+    bool operator==(const ParticleGradient&) const = default;
+};
 
-                void resolveCollision(const Platform& plat) {
-                    sf::FloatRect bounds = {{position.x - 15.f, position.y - 15.f}, {30.f, 30.f}};
-                    sf::FloatRect platBounds = plat.getBounds();
+// Dégradé cuit en tables à virgule fixe, lues par âge : couleurs RGBA prêtes
+// pour les sommets, tailles en 8.8. La mise à jour d'une particule ne fait
+// plus qu'un accès par table. Cuisson constexpr : les courbes des
+// préréglages sont cuites à la compilation.
+struct ParticleCurve {
+    static constexpr size_t SIZE = 64;
+    static constexpr float SIZE_ONE = 256.f; // 1.0 en 8.8
+
+    std::array<sf::Color, SIZE> colors{};
+    std::array<uint16_t, SIZE> sizes{};
+
+    constexpr void bake(const ParticleGradient& g) {
+        for (size_t i = 0; i < SIZE; ++i) {
+            float t = float(i) / float(SIZE - 1);
+            colors[i] = g.colorAt(t);
+            sizes[i] = uint16_t(std::clamp(g.sizeAt(t) * SIZE_ONE + 0.5f, 0.f, 65535.f));
+        }
+    }
+};
 
-                    if (!bounds.findIntersection(platBounds)) return;
+struct ParticleConfig {
+    ParticleGradient gradient = ParticleGradient::fade({255, 255, 255, 255}, {255, 255, 255, 0});
+    float minSpeed = 50.f, maxSpeed = 150.f;
+    float minLife = 0.5f, maxLife = 1.5f;
+    float minSize = 3.f, maxSize = 8.f;
+    float direction = -1.57f;
+    float spread = 0.5f;
+    float spawnRadius = 5.f;
+    float rotationSpeed = 2.f;
+    // Courbe du dégradé déjà cuite et partagée (préréglages), sinon nulle :
+    // le système la cuit alors dans l'une de ses entrées.
+    const ParticleCurve* curve = nullptr;
+
+    // Couleurs dérivées d'une teinte de base (ennemis) : alphas du préréglage,
+    // teinte pleine à la naissance, à demi-intensité en fin de vie.
+    constexpr ParticleConfig tinted(sf::Color base) const {
+        ParticleConfig c = *this;
+        for (size_t i = 0; i < c.gradient.colorCount; ++i) {
+            ParticleGradient::ColorStop& stop = c.gradient.colors[i];
+            float k = 1.f - 0.5f * stop.at;
+            stop.color = sf::Color(uint8_t(base.r * k), uint8_t(base.g * k), uint8_t(base.b * k), stop.color.a);
+        }
+        c.curve = nullptr; // ne correspond plus au dégradé
+        return c;
+    }
 
-                    float oT = (bounds.position.y + bounds.size.y) - platBounds.position.y;
+    constexpr ParticleConfig aimed(float angle) const {
+        ParticleConfig c = *this;
+        c.direction = angle;
+        return c;
+    }
+};
 
-                    if (velocity.y > 0 && oT < 20.f) {
-                        position.y = platBounds.position.y - 15.f;
-                        velocity.y = 0;
-                        isGrounded = true;
-                        if (moveState == MovementState::Falling) moveState = MovementState::Walking;
-                    }
-                }
+// Préréglages d'émetteurs, construits à la compilation : émettre revient à
+// lire une entrée de la table (plus de ParticleConfig rempli à chaque tick).
+enum class ParticlePreset : uint8_t {
+    DragonBurst, FlightTrail, DashTrail, AttackSlash, PlayerHurt, PlayerDeath, PlayerJump,
+    EnemyTakeoff, EnemyFlightTrail, EnemyShot, EnemyHop, EnemyDeath,
+    BackgroundMote, MenuMote,
+    Count
+};
 
-                void takeDamage(int dmg) {
-                    if (!alive) return;
-                    health -= dmg;
-                    hitFlash = 0.15f;
+namespace ParticlePresets {
+    constexpr float UP = -1.57f, DOWN = 1.57f, ALL = 3.14159f;
+
+    constexpr ParticleConfig make(sf::Color start, sf::Color end, float minSpeed, float maxSpeed,
+                                  float minLife, float maxLife, float direction, float spread,
+                                  float minSize = 3.f, float maxSize = 8.f) {
+        ParticleConfig c;
+        c.gradient = ParticleGradient::fade(start, end);
+        c.minSpeed = minSpeed; c.maxSpeed = maxSpeed;
+        c.minLife = minLife; c.maxLife = maxLife;
+        c.direction = direction; c.spread = spread;
+        c.minSize = minSize; c.maxSize = maxSize;
+        return c;
+    }
 
-                    if (health <= 0) {
-                        alive = false;
-                        ParticleConfig cfg;
-                        cfg.startColor = baseColor;
-                        cfg.endColor = sf::Color(baseColor.r/2, baseColor.g/2, baseColor.b/2, 0);
-                        cfg.minSpeed = 150.f; cfg.maxSpeed = 300.f;
-                        cfg.spread = 3.14159f;
-                        cfg.minLife = 0.5f; cfg.maxLife = 1.f;
-                        particles.emit(position, cfg, 50);
-                    }
-                }
+    // Les préréglages teintés (Enemy*) n'utilisent que les alphas : voir tinted().
+    constexpr std::array<ParticleConfig, size_t(ParticlePreset::Count)> build() {
+        std::array<ParticleConfig, size_t(ParticlePreset::Count)> t{};
+        auto at = [&t](ParticlePreset p) -> ParticleConfig& { return t[size_t(p)]; };
+        at(ParticlePreset::DragonBurst) = make({100, 200, 255, 255}, {50, 100, 200, 0}, 200.f, 400.f, 0.5f, 1.5f, UP, ALL);
+        at(ParticlePreset::FlightTrail) = make({100, 200, 255, 200}, {50, 100, 200, 0}, 50.f, 100.f, 0.3f, 0.6f, DOWN, 0.5f);
+        at(ParticlePreset::DashTrail) = make({200, 230, 255, 200}, {100, 150, 200, 0}, 20.f, 50.f, 0.15f, 0.3f, UP, 0.5f, 8.f, 15.f);
+        at(ParticlePreset::AttackSlash) = make({255, 255, 255, 200}, {200, 220, 255, 0}, 300.f, 500.f, 0.1f, 0.2f, 0.f, 0.5f);
+        at(ParticlePreset::PlayerHurt) = make({255, 100, 100, 255}, {100, 50, 50, 0}, 100.f, 300.f, 0.5f, 1.5f, UP, ALL);
+        at(ParticlePreset::PlayerDeath) = make({180, 220, 255, 255}, {50, 100, 150, 0}, 200.f, 500.f, 1.f, 2.f, UP, ALL);
+        at(ParticlePreset::PlayerJump) = make({200, 220, 255, 200}, {150, 180, 220, 0}, 50.f, 150.f, 0.2f, 0.4f, DOWN, 0.8f);
+        at(ParticlePreset::EnemyTakeoff) = make({255, 255, 255, 230}, {0, 0, 0, 0}, 50.f, 150.f, 0.3f, 0.5f, DOWN, 0.8f);
+        at(ParticlePreset::EnemyFlightTrail) = make({255, 255, 255, 150}, {0, 0, 0, 0}, 30.f, 60.f, 0.2f, 0.4f, DOWN, 0.5f, 4.f, 8.f);
+        at(ParticlePreset::EnemyShot) = make({100, 150, 255, 255}, {50, 100, 200, 0}, 100.f, 200.f, 0.2f, 0.4f, 0.f, 0.3f);
+        at(ParticlePreset::EnemyHop) = make({255, 220, 100, 255}, {200, 150, 50, 0}, 80.f, 150.f, 0.2f, 0.4f, DOWN, 0.8f);
+        at(ParticlePreset::EnemyDeath) = make({255, 255, 255, 230}, {0, 0, 0, 0}, 150.f, 300.f, 0.5f, 1.f, UP, ALL);
+        at(ParticlePreset::BackgroundMote) = make({100, 120, 180, 100}, {80, 100, 150, 0}, 10.f, 30.f, 3.f, 6.f, UP, 0.5f, 2.f, 4.f);
+        at(ParticlePreset::MenuMote) = make({80, 130, 200, 120}, {50, 80, 150, 0}, 15.f, 40.f, 4.f, 7.f, UP, 0.4f);
+
+        // Dégradés à plusieurs arrêts : flash blanc puis teinte, grossissement
+        // bref avant de fondre.
+        at(ParticlePreset::DragonBurst).gradient = ParticleGradient::make(
+            {{0.f, {230, 245, 255, 255}}, {0.2f, {100, 200, 255, 255}}, {1.f, {50, 100, 200, 0}}},
+            {{0.f, 0.6f}, {0.15f, 1.2f}, {1.f, 0.f}});
+        at(ParticlePreset::PlayerHurt).gradient = ParticleGradient::make(
+            {{0.f, {255, 235, 235, 255}}, {0.15f, {255, 100, 100, 255}}, {1.f, {100, 50, 50, 0}}},
+            {{0.f, 1.f}, {1.f, 0.f}});
+        at(ParticlePreset::EnemyDeath).gradient = ParticleGradient::make(
+            {{0.f, {255, 255, 255, 230}}, {0.5f, {255, 255, 255, 160}}, {1.f, {0, 0, 0, 0}}},
+            {{0.f, 0.6f}, {0.2f, 1.3f}, {1.f, 0.f}});
+        return t;
+    }
 
-                void draw(sf::RenderTarget& target) const {
-                    particles.draw(target);
-                    if (!alive) return;
+    // Cuisson d'une table de préréglages, puis rattachement de chaque entrée
+    // à sa courbe : celle-ci doit vivre dans une table statique (voir CURVES).
+    template <size_t N>
+    constexpr std::array<ParticleCurve, N> bake(const std::array<ParticleConfig, N>& configs) {
+        std::array<ParticleCurve, N> curves{};
+        for (size_t i = 0; i < N; ++i) curves[i].bake(configs[i].gradient);
+        return curves;
+    }
 
-                    if (type == Type::Blue) {
-                        sf::CircleShape glowShape(body.getRadius() * 1.5f);
-                        glowShape.setOrigin({glowShape.getRadius(), glowShape.getRadius()});
-                        glowShape.setPosition(body.getPosition());
-                        glowShape.setFillColor(sf::Color(80, 120, 200, 40));
-                        target.draw(glowShape, sf::RenderStates(sf::BlendAdd));
-                    }
+    template <size_t N>
+    constexpr std::array<ParticleConfig, N> attach(std::array<ParticleConfig, N> configs,
+                                                   const std::array<ParticleCurve, N>& curves) {
+        for (size_t i = 0; i < N; ++i) configs[i].curve = &curves[i];
+        return configs;
+    }
 
-                    if (moveState == MovementState::Flying) {
-                        float wingAnim = std::sin(animTimer * 15.f) * 10.f;
+    inline constexpr auto GRADIENTS = build();
+    // Cuites une fois pour tout le programme, partagées par tous les systèmes.
+    inline constexpr auto CURVES = bake(GRADIENTS);
+    inline constexpr auto TABLE = attach(GRADIENTS, CURVES);
 
-                        sf::ConvexShape wing1, wing2;
-                        wing1.setPointCount(3);
-                        wing2.setPointCount(3);
+    constexpr const ParticleConfig& get(ParticlePreset p) { return TABLE[size_t(p)]; }
+}
 
-                        wing1.setPoint(0, {0, 0});
-                        wing1.setPoint(1, {-20.f, -10.f + wingAnim});
-                        wing1.setPoint(2, {-15.f, 5.f});
+struct Particle {
+    sf::Vector2f position;
+    sf::Vector2f velocity;
+    float life;
+    float lifeToIndex; // (ParticleCurve::SIZE - 1) / durée de vie
+    float size;
+    float rotation, rotationSpeed;
+    const ParticleCurve* curve = nullptr;
+    uint8_t slot = SHARED; // entrée du système qui a cuit la courbe, le cas échéant
+    bool active = false;
 
-                        wing2.setPoint(0, {0, 0});
-                        wing2.setPoint(1, {20.f, -10.f + wingAnim});
-                        wing2.setPoint(2, {15.f, 5.f});
+    static constexpr uint8_t SHARED = 0xFF; // courbe partagée (préréglage)
+};
 
-                        wing1.setPosition(body.getPosition());
-                        wing2.setPosition(body.getPosition());
+class ParticleSystem {
+public:
+    static constexpr size_t MAX_CURVE_SLOTS = Particle::SHARED;
 
-                        wing1.setFillColor(sf::Color(baseColor.r, baseColor.g, baseColor.b, 150));
-                        wing2.setFillColor(sf::Color(baseColor.r, baseColor.g, baseColor.b, 150));
+    // curveSlots : dégradés ad hoc (sans courbe cuite d'avance) vivants à la
+    // fois ; au-delà, la courbe la moins utilisée est recuite (seule l'apparence
+    // de ses particules change). Sans entrée, ces dégradés ne sont pas émis.
+    explicit ParticleSystem(size_t maxParticles = 2000, unsigned int seed = 1, size_t curveSlots = 0)
+        : particles(maxParticles), curves(std::min(curveSlots, MAX_CURVE_SLOTS)), random(seed) {
+        vertices.setPrimitiveType(sf::PrimitiveType::Triangles);
+        vertices.resize(maxParticles * 6);
+    }
 
-                        target.draw(wing1);
-                        target.draw(wing2);
+    // Un seul passage sur le pool pour les count particules (et non un par particule).
+    void emit(sf::Vector2f pos, const ParticleConfig& cfg, int count = 1) {
+        if (emissionScale < 1.f) {
+            // Partie fractionnaire tirée au sort : une traînée à 1 par tick reste visible.
+            float wanted = float(count) * emissionScale;
+            count = int(wanted);
+            if (random.range(0.f, 1.f) < wanted - float(count)) ++count;
+        }
+        if (count <= 0) return;
+        const ParticleCurve* curve = cfg.curve;
+        uint8_t slot = Particle::SHARED;
+        if (!curve) {
+            if (curves.empty()) return;
+            slot = curveFor(cfg.gradient);
+            curve = &curves[slot].curve;
+        }
+        for (size_t i = 0; i < particles.size() && count > 0; ++i) {
+            Particle& p = particles[i];
+            if (!p.active) {
+                --count;
+                liveEnd = std::max(liveEnd, i + 1);
+                p.active = true;
+                p.position = pos + random.insideCircle(cfg.spawnRadius);
+                float angle = cfg.direction + random.range(-cfg.spread, cfg.spread);
+                float speed = random.range(cfg.minSpeed, cfg.maxSpeed);
+                p.velocity = {std::cos(angle) * speed, std::sin(angle) * speed};
+                p.life = random.range(cfg.minLife, cfg.maxLife);
+                p.lifeToIndex = float(ParticleCurve::SIZE - 1) / p.life;
+                p.size = random.range(cfg.minSize, cfg.maxSize) * (1.f / ParticleCurve::SIZE_ONE);
+                p.curve = curve;
+                p.slot = slot;
+                if (slot != Particle::SHARED) ++curves[slot].live;
+                p.rotation = random.range(0.f, 6.28f);
+                p.rotationSpeed = random.range(-cfg.rotationSpeed, cfg.rotationSpeed);
+            }
+        }
+    }
 
-                        float flyRatio = flyTimer / Config::ENEMY_FLY_DURATION;
-                        sf::RectangleShape flyBar{{30.f * flyRatio, 3.f}};
-                        flyBar.setPosition({position.x - 15.f, position.y - 35.f});
-                        flyBar.setFillColor(sf::Color(100, 200, 255, 200));
-                        target.draw(flyBar);
-                    }
+    void emit(sf::Vector2f pos, ParticlePreset preset, int count = 1) { emit(pos, ParticlePresets::get(preset), count); }
 
-                    target.draw(body);
-                    target.draw(eye);
+    void seed(unsigned int s) { random.seed(s); }
 
-                    if (health < baseHealth) {
-                        float healthRatio = float(health) / baseHealth;
-                        sf::RectangleShape hpBg{{40.f, 5.f}};
-                        hpBg.setPosition({position.x - 20.f, position.y - 40.f});
-                        hpBg.setFillColor(sf::Color(50, 50, 50, 200));
-                        target.draw(hpBg);
-
-                        sf::RectangleShape hpFill{{40.f * healthRatio, 5.f}};
-                        hpFill.setPosition({position.x - 20.f, position.y - 40.f});
-                        hpFill.setFillColor(sf::Color(220, 80, 80, 220));
-                        target.draw(hpFill);
-                    }
-                }
+    void update(float dt) {
+        size_t idx = 0, end = 0;
+        for (size_t i = 0; i < liveEnd; ++i) {
+            Particle& p = particles[i];
+            if (!p.active) continue;
+            p.life -= dt;
+            if (p.life <= 0) {
+                p.active = false;
+                if (p.slot != Particle::SHARED) --curves[p.slot].live;
+                continue;
+            }
+            end = i + 1;
 
-                sf::FloatRect getBounds() const {
-                    float r = body.getRadius();
-                    return {{position.x - r, position.y - r}, {r * 2, r * 2}};
-                }
+            p.velocity.y += gravity * dt;
+            p.velocity *= 1.f - drag * dt;
+            p.position += p.velocity * dt;
+            p.rotation += p.rotationSpeed * dt;
 
-                bool isAlive() const { return alive; }
-                int getDamage() const { return damage; }
+            // Âge en index de table : vie restante dans ]0, durée], donc k dans [0, SIZE - 1].
+            size_t k = ParticleCurve::SIZE - 1 - size_t(p.life * p.lifeToIndex);
+            const ParticleCurve& curve = *p.curve;
+            sf::Color col = curve.colors[k];
+            float sz = p.size * float(curve.sizes[k]);
+            float c = std::cos(p.rotation) * sz, s = std::sin(p.rotation) * sz;
 
-private:
-    sf::Vector2f position, startPos;
-    sf::Vector2f velocity{0, 0};
-    sf::CircleShape body, eye;
-    sf::Color baseColor;
-    Type type;
-    MovementState moveState = MovementState::Walking;
+            sf::Vector2f corners[4] = {{-c+s,-s-c}, {c+s,s-c}, {c-s,s+c}, {-c-s,-s+c}};
+            vertices[idx++] = {p.position + corners[0], col};
+            vertices[idx++] = {p.position + corners[1], col};
+            vertices[idx++] = {p.position + corners[2], col};
+            vertices[idx++] = {p.position + corners[0], col};
+            vertices[idx++] = {p.position + corners[2], col};
+            vertices[idx++] = {p.position + corners[3], col};
+        }
+        activeVerts = idx;
+        liveEnd = end;
+    }
 
-    float patrolRange = 150.f, speed = 80.f;
-    int patrolDir = 1;
-    bool facingRight = true, isGrounded = true;
-    float animTimer = 0, hitFlash = 0;
-    float shootCooldown = 2.f, jumpCooldown = 1.f;
-    float flyTimer = 0, flyCooldown = 3.f;
+    // Directement depuis le tampon : seuls les activeVerts premiers sommets sont valides.
+    void draw(sf::RenderTarget& target) const {
+        if (activeVerts > 0)
+            target.draw(&vertices[0], activeVerts, sf::PrimitiveType::Triangles, sf::RenderStates(blendMode));
+    }
 
-    int health, baseHealth, damage = 1;
-    bool alive = true;
+    void clear() {
+        for (auto& p : particles) p.active = false;
+        for (auto& slot : curves) slot.live = 0;
+        activeVerts = 0;
+        liveEnd = 0;
+    }
+
+    float gravity = 200.f, drag = 0.5f;
+    float emissionScale = 1.f; // palier de qualité, appliqué à chaque emit()
+    sf::BlendMode blendMode = sf::BlendAdd;
+
+private:
+    struct CurveSlot {
+        ParticleGradient gradient;
+        ParticleCurve curve;
+        uint32_t live = 0; // particules actives qui lisent cette courbe
+        bool baked = false;
+    };
+
+    // Courbe d'un dégradé ad hoc : déjà cuite (cas courant, un même dégradé
+    // revient à chaque tick), sinon cuite dans une entrée libre ou la moins utilisée.
+    uint8_t curveFor(const ParticleGradient& gradient) {
+        size_t target = 0;
+        for (size_t i = 0; i < curves.size(); ++i) {
+            const CurveSlot& slot = curves[i];
+            if (slot.baked && slot.gradient == gradient) return uint8_t(i);
+            const CurveSlot& best = curves[target];
+            if ((best.baked && !slot.baked) || (best.baked == slot.baked && slot.live < best.live)) target = i;
+        }
+        CurveSlot& slot = curves[target];
+        slot.gradient = gradient;
+        slot.curve.bake(gradient);
+        slot.baked = true;
+        return uint8_t(target);
+    }
 
-    mutable ParticleSystem particles{200};
+    std::vector<Particle> particles;
+    std::vector<CurveSlot> curves;
+    sf::VertexArray vertices;
+    size_t activeVerts = 0;
+    // Aucune particule active au-delà : un pool au repos ne coûte rien à update().
+    size_t liveEnd = 0;
+    EffectsRandom random;
 };
 
 // ============================================================================
-// WAVE MANAGER
+// INPUT
 // ============================================================================
 
-class WaveManager {
+class InputManager {
 public:
-    void startWave(int wave) {
-        currentWave = wave;
-        enemiesRemaining = 0;
-        waveComplete = false;
-        spawnTimer = 0;
-        enemiesToSpawn.clear();
+    void update() {
+        beginFrame();
+        updateKey("left", sf::Keyboard::Key::Left, sf::Keyboard::Key::A);
+        updateKey("right", sf::Keyboard::Key::Right, sf::Keyboard::Key::D);
+        updateKey("up", sf::Keyboard::Key::Up, sf::Keyboard::Key::W);
+        updateKey("down", sf::Keyboard::Key::Down, sf::Keyboard::Key::S);
+        updateKey("jump", sf::Keyboard::Key::Space, sf::Keyboard::Key::Space);
+        updateKey("dash", sf::Keyboard::Key::LShift, sf::Keyboard::Key::K);
+        updateKey("attack", sf::Keyboard::Key::V, sf::Keyboard::Key::V);
+        updateKey("y", sf::Keyboard::Key::Y, sf::Keyboard::Key::Y);
+        updateKey("h", sf::Keyboard::Key::H, sf::Keyboard::Key::H);
+        updateKey("p", sf::Keyboard::Key::P, sf::Keyboard::Key::P);
+        updateKey("pause", sf::Keyboard::Key::Escape, sf::Keyboard::Key::Escape);
+        updateKey("confirm", sf::Keyboard::Key::Enter, sf::Keyboard::Key::Enter);
+        updateKey("retry", sf::Keyboard::Key::R, sf::Keyboard::Key::R);
+        updateKey("quicksave", sf::Keyboard::Key::F5, sf::Keyboard::Key::F5);
+        updateKey("quickload", sf::Keyboard::Key::F9, sf::Keyboard::Key::F9);
+        updateKey("back", sf::Keyboard::Key::Escape, sf::Keyboard::Key::Backspace);
+        updateKey("num1", sf::Keyboard::Key::Num1, sf::Keyboard::Key::Numpad1);
+        updateKey("num2", sf::Keyboard::Key::Num2, sf::Keyboard::Key::Numpad2);
+        updateKey("num3", sf::Keyboard::Key::Num3, sf::Keyboard::Key::Numpad3);
+    }
 
-        int baseEnemies = 3 + wave * 2;
-        int maxEnemies = std::min(baseEnemies, 20);
+    bool isPressed(const std::string& a) const {
+        auto it = currState.find(a);
+        return it != currState.end() && it->second;
+    }
 
-        for (int i = 0; i < maxEnemies; ++i) {
-            Enemy::Type type;
-            int roll = Random::instance().range(0, 100);
+    bool justPressed(const std::string& a) const {
+        auto c = currState.find(a), p = prevState.find(a);
+        return (c != currState.end() && c->second) &&
+        (p == prevState.end() || !p->second);
+    }
 
-            if (wave < 3) type = Enemy::Type::Red;
-            else if (wave < 5) type = roll < 70 ? Enemy::Type::Red : Enemy::Type::Blue;
-            else if (wave < 8) {
-                if (roll < 50) type = Enemy::Type::Red;
-                else if (roll < 80) type = Enemy::Type::Blue;
-                else type = Enemy::Type::Yellow;
-            } else {
-                if (roll < 35) type = Enemy::Type::Red;
-                else if (roll < 65) type = Enemy::Type::Blue;
-                else type = Enemy::Type::Yellow;
-            }
+    bool justReleased(const std::string& a) const {
+        auto c = currState.find(a), p = prevState.find(a);
+        return (c == currState.end() || !c->second) &&
+        (p != prevState.end() && p->second);
+    }
 
-            enemiesToSpawn.push_back(type);
-        }
+    float getAxis(const std::string& neg, const std::string& pos) const {
+        float v = 0;
+        if (isPressed(neg)) v -= 1.f;
+        if (isPressed(pos)) v += 1.f;
+        return v;
+    }
 
-        enemiesRemaining = static_cast<int>(enemiesToSpawn.size());
+    // Entrée scriptée (benchmarks, replays) sans passer par le clavier.
+    void beginFrame() { prevState = currState; }
+    void setPressed(const std::string& a, bool down) { currState[a] = down; }
+
+private:
+    void updateKey(const std::string& a, sf::Keyboard::Key k1, sf::Keyboard::Key k2) {
+        currState[a] = sf::Keyboard::isKeyPressed(k1) || sf::Keyboard::isKeyPressed(k2);
     }
+    std::unordered_map<std::string, bool> currState, prevState;
+};
 
-    void update(float dt, std::vector<std::unique_ptr<Enemy>>& enemies, const sf::Vector2f& playerPos) {
-        if (enemiesToSpawn.empty()) {
-            bool allDead = true;
-            for (const auto& e : enemies) if (e->isAlive()) { allDead = false; break; }
-            if (allDead && enemiesRemaining == 0) waveComplete = true;
-            return;
-        }
+// Entrées d'un joueur pour un tick de simulation, en bits : compactes,
+// comparables et envoyables telles quelles (netcode rollback).
+struct PlayerInput {
+    enum Action : uint16_t {
+        Left = 1u << 0, Right = 1u << 1, Up = 1u << 2, Down = 1u << 3,
+        Jump = 1u << 4, Dash = 1u << 5, Attack = 1u << 6,
+        InvokeY = 1u << 7, InvokeH = 1u << 8, InvokeP = 1u << 9,
+    };
 
-        spawnTimer += dt;
-        if (spawnTimer >= spawnInterval) {
-            spawnTimer = 0;
+    uint16_t held = 0, previous = 0;
 
-            Enemy::Type type = enemiesToSpawn.back();
-            enemiesToSpawn.pop_back();
+    bool isPressed(Action a) const { return (held & a) != 0; }
+    bool justPressed(Action a) const { return (held & a) && !(previous & a); }
+    bool justReleased(Action a) const { return !(held & a) && (previous & a); }
 
-            float spawnX = playerPos.x < 1500.f ?
-            Random::instance().range(2000.f, 2800.f) :
-            Random::instance().range(200.f, 1000.f);
+    float getAxis(Action neg, Action pos) const {
+        float v = 0;
+        if (isPressed(neg)) v -= 1.f;
+        if (isPressed(pos)) v += 1.f;
+        return v;
+    }
 
-            enemies.push_back(std::make_unique<Enemy>(
-                sf::Vector2f{spawnX, 1000.f}, type, currentWave));
+    static uint16_t heldBits(const InputManager& input) {
+        uint16_t bits = 0;
+        for (const auto& [name, action] : bindings()) if (input.isPressed(name)) bits |= action;
+        return bits;
+    }
 
-            spawnInterval = std::max(0.3f, 1.5f - currentWave * 0.1f);
+    static PlayerInput from(const InputManager& input) {
+        PlayerInput in;
+        for (const auto& [name, action] : bindings()) {
+            if (input.isPressed(name)) in.held |= action;
+            if ((input.isPressed(name) && !input.justPressed(name)) || input.justReleased(name)) in.previous |= action;
         }
+        return in;
     }
 
-    int getCurrentWave() const { return currentWave; }
-    int getEnemiesRemaining() const { return enemiesRemaining; }
-    bool isWaveComplete() const { return waveComplete; }
-    void enemyKilled() { if (enemiesRemaining > 0) enemiesRemaining--; }
-
 private:
-    int currentWave = 0, enemiesRemaining = 0;
-    bool waveComplete = false;
-    float spawnTimer = 0, spawnInterval = 1.f;
-    std::vector<Enemy::Type> enemiesToSpawn;
+    static const std::array<std::pair<const char*, Action>, 10>& bindings() {
+        static const std::array<std::pair<const char*, Action>, 10> table = {{
+            {"left", Left}, {"right", Right}, {"up", Up}, {"down", Down}, {"jump", Jump},
+            {"dash", Dash}, {"attack", Attack}, {"y", InvokeY}, {"h", InvokeH}, {"p", InvokeP},
+        }};
+        return table;
+    }
 };
 
+using PlayerInputs = std::array<PlayerInput, Config::MAX_PLAYERS>;
+
 // ============================================================================
-// UPGRADE SYSTEM
+// PROJECTILE
 // ============================================================================
 
-class UpgradeSystem {
+class Projectile {
 public:
-    struct Upgrade {
-        std::string name, description;
-        sf::Color color;
-        int upgradeType;
+    static constexpr size_t MAX_TRAIL = 10;
+
+    // État de simulation, copiable tel quel (instantanés du monde).
+    struct Snapshot {
+        sf::Vector2f position, velocity;
+        sf::Color baseColor;
+        float currentRadius, lifetime, rotation;
+        bool active;
+        uint8_t trailCount;
+        sf::Vector2f trail[MAX_TRAIL];
     };
 
-    void generateChoices() {
-        choices.clear();
-
-        std::vector<Upgrade> allUpgrades = {
-            {"Vitesse+", "Deplacement +20%", sf::Color(100, 200, 100), 0},
-            {"Saut+", "Hauteur +15%", sf::Color(100, 150, 255), 1},
-            {"Attaque+", "Degats +1", sf::Color(255, 100, 100), 2},
-            {"Portee+", "Portee +30%", sf::Color(255, 150, 50), 3},
-            {"Dash+", "Cooldown -25%", sf::Color(200, 100, 255), 4},
-            {"Vol+", "Duree +2s", sf::Color(100, 220, 255), 5},
-            {"Vie+", "PV max +1", sf::Color(255, 100, 150), 6},
-            {"Vitesse ATK+", "Attaque +25%", sf::Color(255, 200, 100), 7},
-        };
-
-        std::vector<int> indices;
-        for (size_t i = 0; i < allUpgrades.size(); ++i) indices.push_back(static_cast<int>(i));
+    Projectile(sf::Vector2f pos, sf::Vector2f dir, float speed, sf::Color color) { reset(pos, dir, speed, color); }
 
-        for (int i = 0; i < 3 && !indices.empty(); ++i) {
-            int idx = Random::instance().range(0, int(indices.size()) - 1);
-            choices.push_back(allUpgrades[indices[idx]]);
-            indices.erase(indices.begin() + idx);
-        }
+    // Projectile inactif, préchauffé (forme déjà allouée).
+    Projectile() {
+        reset({0, 0}, {1.f, 0.f}, 0.f, sf::Color::White);
+        active = false;
+    }
 
-        selectedIndex = 0;
-        isActive = true;
+    // Remet à neuf un projectile recyclé, comme à la construction.
+    void reset(sf::Vector2f pos, sf::Vector2f dir, float speed, sf::Color color) {
+        position = pos;
+        velocity = Math::normalize(dir) * speed;
+        baseColor = color;
+        currentRadius = initialRadius;
+        lifetime = rotation = 0;
+        active = true;
+        trailCount = 0;
     }
 
-    int update(const InputManager& input) {
-        if (!isActive) return -1;
+    void update(float dt, const LevelBounds& bounds) {
+        if (!active) return;
 
-        if (input.justPressed("left")) selectedIndex = (selectedIndex + choices.size() - 1) % choices.size();
-        if (input.justPressed("right")) selectedIndex = (selectedIndex + 1) % choices.size();
+        lifetime += dt;
+        position += velocity * dt;
 
-        if (input.justPressed("num1") && choices.size() > 0) return 0;
-        if (input.justPressed("num2") && choices.size() > 1) return 1;
-        if (input.justPressed("num3") && choices.size() > 2) return 2;
+        float growthFactor = 1.f + lifetime * growthRate;
+        currentRadius = std::min(initialRadius * growthFactor, maxRadius);
+        rotation += velocity.x * dt * 0.1f;
 
-        if (input.justPressed("confirm")) return static_cast<int>(selectedIndex);
+        if (int(lifetime * 20) % 2 == 0) {
+            if (trailCount == MAX_TRAIL) std::copy(trail + 1, trail + MAX_TRAIL, trail);
+            else ++trailCount;
+            trail[trailCount - 1] = position;
+        }
 
-        return -1;
+        if (position.x < -100 || position.x > bounds.width + 200.f || position.y > bounds.height) {
+            active = false;
+        }
     }
 
-    void applyUpgrade(int index, PlayerStats& stats) {
-        if (index >= 0 && index < int(choices.size())) {
-            switch (choices[index].upgradeType) {
+    // Traînée, dessinée sous l'ensemble des projectiles.
+    void drawTrail(ShapeBatch& batch) const {
+        if (!active) return;
+        for (size_t i = 0; i < trailCount; ++i) {
+            float alpha = float(i) / trailCount * 100.f;
+            float radius = currentRadius * 0.3f * (float(i) / trailCount);
+            batch.disc(trail[i], radius, sf::Color(baseColor.r, baseColor.g, baseColor.b, uint8_t(alpha)), 8);
+        }
+    }
+
+    void draw(ShapeBatch& batch) const {
+        if (active) batch.outlinedDisc(position, currentRadius, baseColor, 2.f, sf::Color(baseColor.r, baseColor.g, baseColor.b, 150));
+    }
+
+    // Lot additif, envoyé après tous les projectiles.
+    void drawGlow(ShapeBatch& glow) const {
+        if (active) glow.glow(position, currentRadius * 1.3f, sf::Color(baseColor.r, baseColor.g, baseColor.b, 30), 24);
+    }
+
+    sf::FloatRect getBounds() const {
+        return {{position.x - currentRadius, position.y - currentRadius},
+        {currentRadius * 2, currentRadius * 2}};
+    }
+
+    bool isActive() const { return active; }
+    void deactivate() { active = false; }
+    float getDamage() const { return 1.f + (currentRadius / maxRadius); }
+
+    Snapshot snapshot() const {
+        Snapshot snap{position, velocity, baseColor, currentRadius, lifetime, rotation, active, trailCount, {}};
+        std::copy(trail, trail + trailCount, snap.trail);
+        return snap;
+    }
+
+    void restore(const Snapshot& snap) {
+        position = snap.position;
+        velocity = snap.velocity;
+        baseColor = snap.baseColor;
+        currentRadius = snap.currentRadius;
+        lifetime = snap.lifetime;
+        rotation = snap.rotation;
+        active = snap.active;
+        trailCount = snap.trailCount;
+        std::copy(snap.trail, snap.trail + trailCount, trail);
+    }
+
+private:
+    sf::Vector2f position;
+    sf::Vector2f velocity;
+    sf::Color baseColor;
+
+    float initialRadius = 12.f;
+    float currentRadius = 12.f;
+    float maxRadius = 50.f;
+    float growthRate = 0.8f;
+    float lifetime = 0;
+    float rotation = 0;
+    bool active = true;
+
+    // Positions récentes, la plus ancienne en tête ; tableau fixe, pas de tas.
+    uint8_t trailCount = 0;
+    sf::Vector2f trail[MAX_TRAIL];
+};
+
+// ============================================================================
+// PLATEFORME
+// ============================================================================
+
+class Platform {
+public:
+    // Contour, fond puis liseré : six quads en triangles.
+    static constexpr size_t VERTEX_COUNT = 36;
+    static constexpr float OUTLINE = 2.f;
+
+    Platform(sf::Vector2f size, sf::Vector2f pos, bool oneWay = false)
+    : size(size), isOneWay(oneWay), originalPos(pos) {
+        placeAt(pos);
+    }
+
+    // La position dépend uniquement du temps du monde : une plateforme
+    // rechargée par le streaming reprend exactement là où elle serait.
+    // La vitesse aussi : rejouer un tick (rollback) donne exactement le même résultat.
+    void update(float dt, float worldTime) {
+        if (!isMoving) return;
+        velocity = (positionAt(worldTime) - positionAt(worldTime - dt)) / dt;
+        placeAt(positionAt(worldTime));
+    }
+
+    void syncTime(float worldTime) {
+        if (isMoving) placeAt(positionAt(worldTime));
+    }
+
+    // Écrit VERTEX_COUNT sommets à la position courante ; le tracé passe par
+    // le maillage du niveau (PlatformMesh), pas par des formes SFML.
+    void writeVertices(sf::Vertex* out) const {
+        const sf::Color fill = isOneWay ? sf::Color(55, 45, 65, 200) : sf::Color(35, 30, 45, 255);
+        const sf::Color outline(90, 80, 110, 150), highlight(140, 130, 170, 100);
+        auto quad = [&out](sf::Vector2f a, sf::Vector2f b, sf::Color c) {
+            *out++ = {a, c};
+            *out++ = {{b.x, a.y}, c};
+            *out++ = {b, c};
+            *out++ = {a, c};
+            *out++ = {b, c};
+            *out++ = {{a.x, b.y}, c};
+        };
+        sf::Vector2f lo = position, hi = position + size;
+        quad(lo, hi, fill);
+        quad({lo.x - OUTLINE, lo.y - OUTLINE}, {hi.x + OUTLINE, lo.y}, outline);
+        quad({lo.x - OUTLINE, hi.y}, {hi.x + OUTLINE, hi.y + OUTLINE}, outline);
+        quad({lo.x - OUTLINE, lo.y}, {lo.x, hi.y}, outline);
+        quad({hi.x, lo.y}, {hi.x + OUTLINE, hi.y}, outline);
+        quad(lo, {hi.x, lo.y + 3.f}, highlight);
+    }
+
+    sf::FloatRect getBounds() const { return bounds; }
+    bool getIsOneWay() const { return isOneWay; }
+    bool getIsMoving() const { return isMoving; }
+    sf::Vector2f getVelocity() const { return velocity; }
+
+    void setMoving(bool horizontal, float range, float speed) {
+        isMoving = true;
+        moveHorizontal = horizontal;
+        moveRange = range;
+        moveSpeed = speed;
+    }
+
+private:
+    sf::Vector2f positionAt(float worldTime) const {
+        float offset = std::sin(worldTime * moveSpeed) * moveRange;
+        sf::Vector2f pos = originalPos;
+        if (moveHorizontal) pos.x += offset;
+        else pos.y += offset;
+        return pos;
+    }
+
+    // Collisions sur le bord extérieur du contour, comme le faisait la forme.
+    void placeAt(sf::Vector2f pos) {
+        position = pos;
+        bounds = {pos - sf::Vector2f{OUTLINE, OUTLINE}, size + sf::Vector2f{2 * OUTLINE, 2 * OUTLINE}};
+    }
+
+    sf::Vector2f position, size;
+    sf::FloatRect bounds;
+    bool isOneWay;
+    sf::Vector2f originalPos;
+    sf::Vector2f velocity{0, 0};
+    bool isMoving = false;
+    bool moveHorizontal = true;
+    float moveRange = 0, moveSpeed = 1.f;
+};
+
+// Plateformes visibles par les collisions (celles des chunks actifs).
+using PlatformList = std::vector<const Platform*>;
+
+// Toutes les plateformes actives en deux draws : les fixes dans un tampon GPU
+// statique, refait seulement quand les chunks actifs changent ; les mobiles
+// dans un petit tampon réécrit à chaque frame. Construit au premier tracé :
+// une simulation sans rendu ne touche jamais à OpenGL.
+class PlatformMesh {
+public:
+    void draw(sf::RenderTarget& target, const PlatformList& platforms, uint64_t version) {
+        // Interrogé ici et non à la construction : isAvailable() ouvre un contexte GL.
+        if (!useBuffers) useBuffers = sf::VertexBuffer::isAvailable();
+        if (version != builtVersion) rebuild(platforms, version);
+
+        movingVerts.resize(moving.size() * Platform::VERTEX_COUNT);
+        for (size_t i = 0; i < moving.size(); ++i)
+            moving[i]->writeVertices(&movingVerts[i * Platform::VERTEX_COUNT]);
+
+        if (!*useBuffers) {
+            if (!staticVerts.empty())
+                target.draw(staticVerts.data(), staticVerts.size(), sf::PrimitiveType::Triangles);
+            if (!movingVerts.empty())
+                target.draw(movingVerts.data(), movingVerts.size(), sf::PrimitiveType::Triangles);
+            return;
+        }
+        if (staticCount > 0) target.draw(staticBuffer, 0, staticCount);
+        if (!movingVerts.empty()) {
+            if (movingBuffer.getVertexCount() < movingVerts.size() && !movingBuffer.create(movingVerts.size() * 2)) {
+                useBuffers = false;
+                builtVersion = ~0ull; // les fixes repassent côté CPU à la frame suivante
+                return;
+            }
+            movingBuffer.update(movingVerts.data(), movingVerts.size(), 0);
+            target.draw(movingBuffer, 0, movingVerts.size());
+        }
+    }
+
+    // Capacité pour toutes les plateformes du niveau : un nouvel ensemble de
+    // chunks actifs ne réalloue jamais en cours de partie.
+    void reserve(size_t staticPlatforms, size_t movingPlatforms) {
+        staticVerts.reserve(staticPlatforms * Platform::VERTEX_COUNT);
+        movingVerts.reserve(movingPlatforms * Platform::VERTEX_COUNT);
+        moving.reserve(movingPlatforms);
+    }
+
+    size_t getStaticCount() const { return staticCount / Platform::VERTEX_COUNT; }
+    size_t getMovingCount() const { return moving.size(); }
+
+private:
+    void rebuild(const PlatformList& platforms, uint64_t version) {
+        builtVersion = version;
+        moving.clear();
+        staticVerts.clear();
+        for (const Platform* plat : platforms) {
+            if (plat->getIsMoving()) {
+                moving.push_back(plat);
+                continue;
+            }
+            staticVerts.resize(staticVerts.size() + Platform::VERTEX_COUNT);
+            plat->writeVertices(&staticVerts[staticVerts.size() - Platform::VERTEX_COUNT]);
+        }
+        staticCount = staticVerts.size();
+        // Sans tampons GPU (contexte trop ancien), les sommets restent côté CPU.
+        if (!*useBuffers || staticVerts.empty()) return;
+        if (staticBuffer.getVertexCount() < staticCount && !staticBuffer.create(staticCount)) {
+            std::cerr << "Tampon de sommets indisponible, trace des plateformes sans VBO" << std::endl;
+            useBuffers = false;
+            return;
+        }
+        staticBuffer.update(staticVerts.data(), staticCount, 0);
+        staticVerts.clear();
+    }
+
+    sf::VertexBuffer staticBuffer{sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Static};
+    sf::VertexBuffer movingBuffer{sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Stream};
+    std::vector<sf::Vertex> staticVerts, movingVerts;
+    std::vector<const Platform*> moving;
+    size_t staticCount = 0;
+    uint64_t builtVersion = ~0ull;
+    std::optional<bool> useBuffers; // inconnu jusqu'au premier tracé
+};
+
+// ============================================================================
+// STATS DU JOUEUR
+// ============================================================================
+
+struct PlayerStats {
+    float speedMultiplier = 1.f;
+    float jumpMultiplier = 1.f;
+    float dashCooldownMultiplier = 1.f;
+    float flightDurationMultiplier = 1.f;
+    int maxHealth = Config::MAX_HEALTH;
+    float attackRange = 40.f;
+    float attackSpeed = 1.f;
+    int attackDamage = 1;
+
+    void reset() {
+        speedMultiplier = jumpMultiplier = 1.f;
+        dashCooldownMultiplier = flightDurationMultiplier = attackSpeed = 1.f;
+        maxHealth = Config::MAX_HEALTH;
+        attackRange = 40.f;
+        attackDamage = 1;
+    }
+};
+
+// ============================================================================
+// JOUEUR
+// ============================================================================
+
+class Player {
+public:
+    enum class State { Idle, Running, Jumping, Falling, Dashing, Attacking, Hurt, Dead, Flying };
+    static constexpr size_t STATE_COUNT = size_t(State::Flying) + 1;
+
+    // État de simulation, copiable tel quel (instantanés du monde).
+    struct Snapshot {
+        sf::Vector2f position, velocity, platformVelocity;
+        State state;
+        bool facingRight, isGrounded, isAttacking;
+        int health, soulEnergy, invocationStep;
+        float dashTimer, dashCooldown, attackTimer, attackCooldown;
+        float invincibility, hurtTimer, coyoteTimer, jumpBufferTimer;
+        float flightTimer, invocationTimer, animTimer;
+        sf::FloatRect attackBounds;
+        PlayerStats stats;
+    };
+
+    Player(sf::Vector2f startPos) : position(startPos) {
+        trail.gravity = 50.f;
+        trail.drag = 2.f;
+    }
+
+    void handleInput(const PlayerInput& input, float dt) {
+        if (state == State::Dead || state == State::Hurt) return;
+
+        float moveInput = input.getAxis(PlayerInput::Left, PlayerInput::Right);
+
+        if (state != State::Dashing) {
+            if (std::abs(moveInput) > 0.1f) facingRight = moveInput > 0;
+
+            if (state != State::Flying) {
+                float targetSpeed = moveInput * Config::PLAYER_SPEED * stats.speedMultiplier;
+                velocity.x = Math::lerp(velocity.x, targetSpeed, isGrounded ? 15.f * dt : 8.f * dt);
+            }
+        }
+
+        coyoteTimer = isGrounded ? Config::COYOTE_TIME : coyoteTimer - dt;
+        jumpBufferTimer = input.justPressed(PlayerInput::Jump) ? Config::JUMP_BUFFER_TIME : jumpBufferTimer - dt;
+
+        if (jumpBufferTimer > 0 && coyoteTimer > 0 && state != State::Flying) {
+            velocity.y = -Config::JUMP_FORCE * stats.jumpMultiplier;
+            isGrounded = false;
+            coyoteTimer = jumpBufferTimer = 0;
+            createJumpParticles();
+        }
+
+        if (input.justReleased(PlayerInput::Jump) && velocity.y < 0) velocity.y *= 0.5f;
+        if (input.justPressed(PlayerInput::Dash) && dashCooldown <= 0 && state != State::Flying) startDash();
+        if (input.justPressed(PlayerInput::Attack) && state != State::Dashing && attackCooldown <= 0) startAttack();
+
+        handleInvocation(input);
+    }
+
+    void handleInvocation(const PlayerInput& input) {
+        invocationTimer -= 1.f/60.f;
+
+        if (input.justPressed(PlayerInput::InvokeY)) { invocationStep = 1; invocationTimer = 2.f; }
+        else if (input.justPressed(PlayerInput::InvokeH) && invocationStep == 1 && invocationTimer > 0) invocationStep = 2;
+        else if (input.justPressed(PlayerInput::InvokeP) && invocationStep == 2 && invocationTimer > 0) activateFlight();
+
+        if (invocationTimer <= 0) invocationStep = 0;
+    }
+
+    void activateFlight() {
+        state = State::Flying;
+        flightTimer = Config::FLIGHT_DURATION * stats.flightDurationMultiplier;
+        invocationStep = 0;
+
+        dragonFx.emit(position, ParticlePreset::DragonBurst, 100);
+
+        setFlightLook(true);
+    }
+
+    void update(float dt, const PlatformList& platforms, const LevelBounds& bounds) {
+        if (dashCooldown > 0) dashCooldown -= dt;
+        if (invincibility > 0) invincibility -= dt;
+        if (attackTimer > 0) attackTimer -= dt;
+        if (attackCooldown > 0) attackCooldown -= dt;
+        if (hurtTimer > 0) {
+            hurtTimer -= dt;
+            if (hurtTimer <= 0 && state == State::Hurt) state = State::Idle;
+        }
+
+        if (state == State::Flying) {
+            flightTimer -= dt;
+            velocity.y = -150.f;
+            velocity.x *= 0.95f;
+
+            trail.emit(position + sf::Vector2f{0, 15.f}, ParticlePreset::FlightTrail, 2);
+
+            if (flightTimer <= 0) {
+                state = State::Falling;
+                setFlightLook(false);
+            }
+        }
+
+        if (state == State::Dashing) {
+            dashTimer -= dt;
+            if (dashTimer <= 0) {
+                state = isGrounded ? State::Idle : State::Falling;
+                velocity.x = facingRight ? 150.f : -150.f;
+            }
+
+            trail.emit(position, ParticlePreset::DashTrail, 3);
+        }
+
+        if (state != State::Dashing && state != State::Flying) {
+            velocity.y = std::min(velocity.y + Config::GRAVITY * dt, 800.f);
+        }
+
+        position += velocity * dt;
+
+        isGrounded = false;
+        platformVelocity = {0, 0};
+
+        for (const Platform* plat : platforms) {
+            if (resolveCollision(*plat)) {
+                if (isGrounded && (plat->getVelocity().x != 0 || plat->getVelocity().y != 0)) {
+                    platformVelocity = plat->getVelocity();
+                }
+            }
+        }
+
+        if (isGrounded) position += platformVelocity * dt;
+
+        position.x = std::clamp(position.x, 20.f, bounds.width);
+
+        updateState();
+        trail.update(dt);
+        dragonFx.update(dt);
+
+        breathe = 1.f + std::sin(animTimer * 3.f) * 0.05f;
+        animTimer += dt;
+    }
+
+    bool resolveCollision(const Platform& plat) {
+        sf::FloatRect pBounds = getCollisionBounds();
+        sf::FloatRect tBounds = plat.getBounds();
+
+        if (!pBounds.findIntersection(tBounds)) return false;
+
+        float oL = (pBounds.position.x + pBounds.size.x) - tBounds.position.x;
+        float oR = (tBounds.position.x + tBounds.size.x) - pBounds.position.x;
+        float oT = (pBounds.position.y + pBounds.size.y) - tBounds.position.y;
+        float oB = (tBounds.position.y + tBounds.size.y) - pBounds.position.y;
+
+        float minX = oL < oR ? -oL : oR;
+        float minY = oT < oB ? -oT : oB;
+
+        if (plat.getIsOneWay()) {
+            if (velocity.y > 0 && oT < 15.f) {
+                position.y = tBounds.position.y - 18.f;
+                velocity.y = 0;
+                isGrounded = true;
+                return true;
+            }
+            return false;
+        }
+
+        if (std::abs(minX) < std::abs(minY)) {
+            position.x += minX;
+            velocity.x = 0;
+        } else {
+            position.y += minY;
+            if (minY < 0) isGrounded = true;
+            velocity.y = 0;
+        }
+        return true;
+    }
+
+    sf::FloatRect getCollisionBounds() const {
+        return {{position.x - 15.f, position.y - 15.f}, {30.f, 33.f}};
+    }
+
+    void startDash() {
+        state = State::Dashing;
+        dashTimer = Config::DASH_DURATION;
+        dashCooldown = Config::DASH_COOLDOWN * stats.dashCooldownMultiplier;
+        velocity = {facingRight ? Config::DASH_SPEED : -Config::DASH_SPEED, 0};
+        invincibility = Config::DASH_DURATION;
+    }
+
+    void startAttack() {
+        state = State::Attacking;
+        attackTimer = 0.25f / stats.attackSpeed;
+        attackCooldown = 0.4f / stats.attackSpeed;
+        isAttacking = true;
+
+        float range = stats.attackRange;
+        attackBounds = {{position.x + (facingRight ? 15.f : -15.f - range), position.y - 20.f}, {range, 40.f}};
+
+        trail.emit(position + sf::Vector2f{facingRight ? 20.f : -20.f, 0},
+                   ParticlePresets::get(ParticlePreset::AttackSlash).aimed(facingRight ? 0.f : 3.14159f), 20);
+    }
+
+    void takeDamage(int dmg) {
+        if (invincibility > 0 || state == State::Dead || godMode) return;
+        health -= dmg;
+        invincibility = 1.5f;
+        state = State::Hurt;
+        hurtTimer = 0.3f;
+        velocity = {facingRight ? -200.f : 200.f, -150.f};
+
+        trail.emit(position, ParticlePreset::PlayerHurt, 30);
+        if (telemetry) telemetry->record(TelemetryLog::EventType::DamageTaken, telemetryId, int16_t(dmg), health, position);
+
+        if (health <= 0) {
+            state = State::Dead;
+            trail.emit(position, ParticlePreset::PlayerDeath, 200);
+        }
+    }
+
+    void heal(int amount) { health = std::min(health + amount, stats.maxHealth); }
+
+    void createJumpParticles() {
+        trail.emit(position + sf::Vector2f{0, 15.f}, ParticlePreset::PlayerJump, 15);
+    }
+
+    void updateState() {
+        if (state == State::Dead || state == State::Dashing ||
+            state == State::Flying || state == State::Hurt) return;
+
+        if (attackTimer > 0) state = State::Attacking;
+        else if (!isGrounded) state = velocity.y < 0 ? State::Jumping : State::Falling;
+        else if (std::abs(velocity.x) > 20.f) state = State::Running;
+        else state = State::Idle;
+
+        isAttacking = attackTimer > 0;
+    }
+
+    // Halo puis corps, chacun en un draw ; overlay : attaque et indicateur
+    // d'invocation, envoyés après les joueurs.
+    void draw(sf::RenderTarget& target, FrameBatches& batches) const {
+        trail.draw(target);
+        dragonFx.draw(target);
+
+        if (invincibility > 0 && int(invincibility * 10) % 2 == 0) return;
+
+        batches.glow.glow(position, glowRadius, glowColor);
+        batches.glow.flush(target, sf::RenderStates(sf::BlendAdd));
+        batches.scratch.outlinedDisc(position, BODY_RADIUS * breathe, bodyColor, 2.f, sf::Color(100, 150, 200, 200));
+        batches.scratch.disc(position + sf::Vector2f{facingRight ? 6.f : -6.f, -5.f}, 4.f, sf::Color(50, 50, 80));
+        batches.scratch.flush(target);
+
+        ShapeBatch& overlay = batches.overlay;
+        if (isAttacking) {
+            overlay.rotatedRect(position + sf::Vector2f{facingRight ? 18.f : -18.f, 0}, {0.f, -2.f},
+                                {stats.attackRange, 4.f}, facingRight ? -20.f : 200.f, sf::Color(255, 255, 255, 200));
+        }
+
+        if (invocationStep > 0) {
+            float progress = float(invocationStep) / 3.f;
+            overlay.circle(position + sf::Vector2f{0, -40.f}, 5.f + 5.f * progress,
+                           sf::Color(uint8_t(100 + 155 * progress), 200, 255, 200));
+        }
+    }
+
+    void reset(sf::Vector2f pos) {
+        position = pos;
+        velocity = {0, 0};
+        health = stats.maxHealth;
+        soulEnergy = 0;
+        state = State::Idle;
+        flightTimer = 0;
+        invincibility = 0;
+        bodyColor = tint;
+        glowRadius = 25.f;
+    }
+
+    void fullReset(sf::Vector2f pos) {
+        reset(pos);
+        stats.reset();
+    }
+
+    sf::Vector2f getPosition() const { return position; }
+    int getHealth() const { return health; }
+    int getSoulEnergy() const { return soulEnergy; }
+    State getState() const { return state; }
+    sf::FloatRect getAttackBounds() const { return attackBounds; }
+    bool getIsAttacking() const { return isAttacking; }
+    float getFlightTimer() const { return flightTimer; }
+    PlayerStats& getStats() { return stats; }
+    const PlayerStats& getStats() const { return stats; }
+
+    void addSoul(int amt) { soulEnergy = std::min(soulEnergy + amt, Config::MAX_SOUL_ENERGY); }
+    int getAttackDamage() const { return stats.attackDamage; }
+    void setGodMode(bool enabled) { godMode = enabled; }
+    void setTelemetry(TelemetryLog* log, uint8_t id) { telemetry = log; telemetryId = id; }
+    void setEffectScale(float scale) { trail.emissionScale = dragonFx.emissionScale = scale; }
+
+    // Couleur du corps hors vol (distingue le second joueur en coopération).
+    void setTint(sf::Color color) {
+        tint = color;
+        setFlightLook(state == State::Flying);
+    }
+
+    Snapshot snapshot() const {
+        return {position, velocity, platformVelocity, state, facingRight, isGrounded, isAttacking,
+                health, soulEnergy, invocationStep, dashTimer, dashCooldown, attackTimer, attackCooldown,
+                invincibility, hurtTimer, coyoteTimer, jumpBufferTimer, flightTimer, invocationTimer, animTimer,
+                attackBounds, stats};
+    }
+
+    // Les particules (trail, dragonFx) sont cosmétiques : vidées, pas restaurées.
+    void restore(const Snapshot& snap) {
+        position = snap.position;
+        velocity = snap.velocity;
+        platformVelocity = snap.platformVelocity;
+        state = snap.state;
+        facingRight = snap.facingRight;
+        isGrounded = snap.isGrounded;
+        isAttacking = snap.isAttacking;
+        health = snap.health;
+        soulEnergy = snap.soulEnergy;
+        invocationStep = snap.invocationStep;
+        dashTimer = snap.dashTimer;
+        dashCooldown = snap.dashCooldown;
+        attackTimer = snap.attackTimer;
+        attackCooldown = snap.attackCooldown;
+        invincibility = snap.invincibility;
+        hurtTimer = snap.hurtTimer;
+        coyoteTimer = snap.coyoteTimer;
+        jumpBufferTimer = snap.jumpBufferTimer;
+        flightTimer = snap.flightTimer;
+        invocationTimer = snap.invocationTimer;
+        animTimer = snap.animTimer;
+        attackBounds = snap.attackBounds;
+        stats = snap.stats;
+
+        trail.clear();
+        dragonFx.clear();
+        setFlightLook(state == State::Flying);
+    }
+
+private:
+    void setFlightLook(bool flying) {
+        bodyColor = flying ? sf::Color(100, 200, 255, 255) : tint;
+        glowRadius = flying ? 40.f : 25.f;
+        glowColor = flying ? sf::Color(50, 150, 255, 100) : sf::Color(150, 200, 255, 50);
+    }
+
+    static constexpr float BODY_RADIUS = 18.f;
+
+    sf::Vector2f position;
+    sf::Vector2f velocity{0, 0};
+    sf::Vector2f platformVelocity{0, 0};
+
+    // Apparence, sans formes SFML : tracée par les lots de la frame.
+    sf::Color bodyColor{180, 220, 255, 230}, glowColor{150, 200, 255, 50};
+    float glowRadius = 25.f, breathe = 1.f;
+    sf::Color tint{180, 220, 255, 230};
+
+    State state = State::Idle;
+    bool facingRight = true;
+    bool isGrounded = false;
+    bool isAttacking = false;
+    bool godMode = false;
+    TelemetryLog* telemetry = nullptr;
+    uint8_t telemetryId = 0;
+
+    int health = Config::MAX_HEALTH;
+    int soulEnergy = 0;
+
+    float dashTimer = 0, dashCooldown = 0;
+    float attackTimer = 0, attackCooldown = 0;
+    float invincibility = 0, hurtTimer = 0;
+    float coyoteTimer = 0, jumpBufferTimer = 0;
+    float flightTimer = 0, invocationTimer = 0;
+    float animTimer = 0;
+
+    int invocationStep = 0; // combinaison Y, H, P en cours : 0, 1 (Y) ou 2 (YH)
+    sf::FloatRect attackBounds;
+    PlayerStats stats;
+
+    mutable ParticleSystem trail{1000, 11};
+    mutable ParticleSystem dragonFx{500, 12};
+};
+
+// ============================================================================
+// NAVIGATION (CHAMP DE FLUX)
+// ============================================================================
+
+// Grille grossière sur le niveau : un parcours en largeur depuis les cellules
+// des joueurs donne à chaque cellule la direction du prochain pas. Partagé par
+// toute la horde, lu en O(1) par ennemi, recalculé seulement quand un joueur
+// change de cellule. Seules les plateformes fixes bloquent : la grille ne
+// dépend que du niveau, jamais du temps ni du streaming (rollback déterministe).
+class FlowField {
+public:
+    static constexpr float CELL = 64.f;
+    static constexpr int REACH = 48; // en cellules ; au-delà, l'ennemi vise directement
+
+    void build(const Level& level) {
+        const LevelBounds b = level.bounds();
+        cols = std::max(1, int(std::ceil(b.width / CELL)));
+        rows = std::max(1, int(std::ceil(b.floorY / CELL)));
+        blocked.assign(size_t(cols) * rows, 0);
+        dist.assign(blocked.size(), UNREACHED);
+        step.assign(blocked.size(), NONE);
+        reached.clear();
+        sourceCount = 0;
+
+        for (uint32_t i = 0; i < level.platformCount(); ++i) {
+            const LevelFormat::PlatformRecord& p = level.platforms()[i];
+            if (p.flags & LevelFormat::Moving) continue;
+            for (int y = rowOf(p.y); y <= rowOf(p.y + p.h); ++y)
+                for (int x = colOf(p.x); x <= colOf(p.x + p.w); ++x) blocked[index(x, y)] = 1;
+        }
+    }
+
+    // Positions des joueurs visés ; rien n'est recalculé si leurs cellules n'ont pas bougé.
+    void update(const sf::Vector2f* targets, size_t count) {
+        std::array<int, Config::MAX_PLAYERS> cells{};
+        count = std::min(count, cells.size());
+        for (size_t i = 0; i < count; ++i) cells[i] = index(colOf(targets[i].x), rowOf(targets[i].y));
+        std::sort(cells.begin(), cells.begin() + count);
+        if (count == sourceCount && std::equal(cells.begin(), cells.begin() + count, sources.begin())) return;
+
+        sources = cells;
+        sourceCount = count;
+        propagate();
+        ++rebuilds;
+    }
+
+    // Direction du prochain pas depuis pos ; nulle dans la cellule d'un
+    // joueur ou hors de portée (l'appelant vise alors directement).
+    sf::Vector2f direction(sf::Vector2f pos) const {
+        if (blocked.empty()) return {0, 0};
+        return STEPS[step[index(colOf(pos.x), rowOf(pos.y))]];
+    }
+
+    size_t getRebuildCount() const { return rebuilds; }
+
+private:
+    static constexpr uint16_t UNREACHED = 0xFFFF;
+    static constexpr uint8_t NONE = 8;
+    static constexpr int DX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    static constexpr int DY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+    static constexpr uint8_t REVERSE[8] = {1, 0, 3, 2, 7, 6, 5, 4};
+    static constexpr float D = 0.70710678f;
+    static constexpr sf::Vector2f STEPS[9] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {D, D}, {D, -D}, {-D, D}, {-D, -D}, {0, 0}};
+
+    int colOf(float x) const { return std::clamp(int(x / CELL), 0, cols - 1); }
+    int rowOf(float y) const { return std::clamp(int(y / CELL), 0, rows - 1); }
+    size_t index(int x, int y) const { return size_t(y) * cols + x; }
+
+    // Parcours multi-sources. Une cellule bloquée peut être atteinte (un
+    // ennemi posé sur une plateforme y trouve sa sortie) mais n'est jamais
+    // traversée, et les diagonales ne coupent pas les coins.
+    void propagate() {
+        for (size_t i : reached) { dist[i] = UNREACHED; step[i] = NONE; }
+        reached.clear();
+
+        for (size_t s = 0; s < sourceCount; ++s) {
+            size_t i = size_t(sources[s]);
+            if (dist[i] == 0) continue;
+            dist[i] = 0;
+            reached.push_back(i);
+        }
+
+        for (size_t head = 0; head < reached.size(); ++head) {
+            size_t cur = reached[head];
+            if (dist[cur] >= REACH || (dist[cur] > 0 && blocked[cur])) continue;
+            int cx = int(cur % cols), cy = int(cur / cols);
+            for (int d = 0; d < 8; ++d) {
+                int nx = cx + DX[d], ny = cy + DY[d];
+                if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+                if (d >= 4 && (blocked[index(nx, cy)] || blocked[index(cx, ny)])) continue;
+                size_t n = index(nx, ny);
+                if (dist[n] != UNREACHED) continue;
+                dist[n] = uint16_t(dist[cur] + 1);
+                step[n] = REVERSE[d]; // le pas qui ramène vers cur
+                reached.push_back(n);
+            }
+        }
+    }
+
+    int cols = 0, rows = 0;
+    std::vector<uint8_t> blocked, step;
+    std::vector<uint16_t> dist;
+    std::vector<size_t> reached; // file du parcours, aussi la liste à effacer au suivant
+    std::array<int, Config::MAX_PLAYERS> sources{};
+    size_t sourceCount = 0, rebuilds = 0;
+};
+
+// ============================================================================
+// ENNEMI (VOL LIMITÉ + MARCHE AU SOL)
+// ============================================================================
+
+// Teinte de chaque type d'ennemi (ordre de Enemy::Type) et ses effets teintés,
+// cuits à la compilation comme les préréglages : tous les ennemis d'un type
+// partagent les mêmes courbes au lieu d'en recuire chacun une copie.
+namespace EnemyTints {
+    inline constexpr std::array<sf::Color, 3> COLORS = {
+        sf::Color(200, 80, 80, 230), sf::Color(80, 120, 200, 230), sf::Color(220, 200, 80, 230)};
+    inline constexpr std::array<ParticlePreset, 3> EFFECTS = {
+        ParticlePreset::EnemyTakeoff, ParticlePreset::EnemyFlightTrail, ParticlePreset::EnemyDeath};
+
+    constexpr size_t index(size_t type, ParticlePreset effect) {
+        size_t e = 0;
+        while (e + 1 < EFFECTS.size() && EFFECTS[e] != effect) ++e;
+        return type * EFFECTS.size() + e;
+    }
+
+    constexpr std::array<ParticleConfig, COLORS.size() * EFFECTS.size()> build() {
+        std::array<ParticleConfig, COLORS.size() * EFFECTS.size()> t{};
+        for (size_t type = 0; type < COLORS.size(); ++type)
+            for (ParticlePreset effect : EFFECTS) t[index(type, effect)] = ParticlePresets::get(effect).tinted(COLORS[type]);
+        return t;
+    }
+
+    inline constexpr auto GRADIENTS = build();
+    inline constexpr auto CURVES = ParticlePresets::bake(GRADIENTS);
+    inline constexpr auto TABLE = ParticlePresets::attach(GRADIENTS, CURVES);
+
+    constexpr const ParticleConfig& get(size_t type, ParticlePreset effect) { return TABLE[index(type, effect)]; }
+}
+
+class Enemy {
+public:
+    enum class Type { Red, Blue, Yellow };
+    enum class MovementState { Walking, Flying, Falling };
+
+    static constexpr size_t TYPE_COUNT = 3, STATE_COUNT = 3;
+    static constexpr size_t BUCKET_COUNT = TYPE_COUNT * STATE_COUNT;
+    static_assert(EnemyTints::COLORS.size() == TYPE_COUNT);
+
+    // État de simulation, copiable tel quel (instantanés du monde).
+    struct Snapshot {
+        sf::Vector2f position, startPos, velocity;
+        Type type;
+        MovementState moveState;
+        float patrolRange, speed;
+        int patrolDir;
+        bool facingRight, isGrounded, alive;
+        float animTimer, hitFlash, shootCooldown, jumpCooldown, flyTimer, flyCooldown;
+        int health, baseHealth, damage;
+        float aiDebt;
+    };
+
+    Enemy(sf::Vector2f pos, Type type, int waveNumber, Random& rng) { reset(pos, type, waveNumber, rng); }
+
+    // Ennemi dormant (mort), préchauffé pour une vague à venir : formes et
+    // pool de particules déjà alloués, aucun tirage aléatoire.
+    Enemy() {
+        alive = false;
+        setupVisuals();
+    }
+
+    // Remet à neuf un ennemi recyclé : même état et mêmes tirages qu'à la
+    // construction, sans réallouer ses tampons.
+    void reset(sf::Vector2f pos, Type newType, int waveNumber, Random& rng) {
+        position = startPos = pos;
+        velocity = target = heading = {0, 0};
+        type = newType;
+        moveState = MovementState::Walking;
+        patrolRange = 150.f;
+        patrolDir = 1;
+        facingRight = isGrounded = true;
+        animTimer = hitFlash = 0;
+        shootCooldown = 2.f;
+        jumpCooldown = 1.f;
+        flyTimer = 0;
+        alive = thinking = true;
+        aiDt = aiDebt = 0;
+
+        float waveMult = 1.f + waveNumber * 0.15f;
+        baseHealth = int(3 * waveMult);
+        health = baseHealth;
+        damage = 1 + waveNumber / 5;
+        speed = 80.f + waveNumber * 5.f;
+        flyCooldown = rng.range(2.f, 6.f);
+
+        setupVisuals();
+        visualPos = {0, 0};
+        particles.clear();
+        // Effets propres à l'ennemi, sans tirage dans la simulation.
+        particles.seed(std::bit_cast<uint32_t>(pos.x) * 2654435761u ^ std::bit_cast<uint32_t>(pos.y) ^ uint32_t(newType));
+        particles.emissionScale = 1.f;
+    }
+
+    void setupVisuals() {
+        float radius = 20.f;
+
+        switch (type) {
+            case Type::Red: break;
+            case Type::Blue: radius = 22.f; break;
+            case Type::Yellow: radius = 18.f; break;
+        }
+
+        bodyRadius = radius;
+        baseColor = EnemyTints::COLORS[size_t(type)];
+        flashing = false;
+    }
+
+    // Ennemi isolé. Le monde passe par les trois étapes ci-dessous, seau par seau.
+    void update(float dt, const sf::Vector2f& playerPos,
+                SlotMap<Projectile>& projectiles,
+                const PlatformList& platforms,
+                const LevelBounds& bounds,
+                Random& rng) {
+        if (!alive) return;
+        plan(playerPos, Math::normalize(playerPos - position), true);
+        beginUpdate(dt, rng);
+        switch (type) {
+            case Type::Red: moveAs<Type::Red>(projectiles); break;
+            case Type::Blue: moveAs<Type::Blue>(projectiles); break;
+            case Type::Yellow: moveAs<Type::Yellow>(projectiles); break;
+        }
+        finishUpdate(dt, platforms, bounds);
+    }
+
+    // Seau (type, état) de l'ennemi, valable après beginUpdate().
+    size_t bucket() const { return size_t(type) * STATE_COUNT + size_t(moveState); }
+
+    // Cible du tick, cap à suivre pour l'atteindre (champ de flux), et si
+    // l'ennemi réfléchit (décisions de vol, de tir, de saut, de poursuite) ou
+    // se contente de suivre sa dernière décision.
+    void plan(sf::Vector2f targetPos, sf::Vector2f headingDir, bool think) {
+        target = targetPos;
+        heading = headingDir;
+        thinking = think;
+    }
+
+    // Sans réflexion, seule la physique tourne : marcher ou voler garde la
+    // vitesse décidée, la chute continue de freiner.
+    bool needsMove() const { return thinking || moveState == MovementState::Falling; }
+
+    // Commun à tous : transitions de vol et gravité. Fixe l'état pour le tick.
+    // Le temps passé sans réfléchir est rendu à la réflexion suivante, pour
+    // que les délais (vol, tir, saut) s'écoulent au même rythme.
+    void beginUpdate(float dt, Random& rng) {
+        if (thinking) {
+            aiDt = aiDebt + dt;
+            aiDebt = 0;
+            updateFlightState(aiDt, target, rng);
+        } else {
+            aiDt = 0;
+            aiDebt += dt;
+        }
+
+        if (moveState != MovementState::Flying) {
+            velocity.y += Config::GRAVITY * dt;
+            velocity.y = std::min(velocity.y, 600.f);
+        }
+    }
+
+    // Noyau d'un seau : type et état sont des paramètres de template, la
+    // boucle ne contient plus aucun test de type ni d'état par ennemi.
+    template <Type T, MovementState S>
+    static void moveBucket(const std::vector<Enemy*>& bucket, SlotMap<Projectile>& projectiles) {
+        for (Enemy* e : bucket) {
+            if constexpr (S == MovementState::Walking) e->walk<T>(e->aiDt, projectiles);
+            else if constexpr (S == MovementState::Flying) e->fly<T>(e->aiDt, projectiles);
+            else e->velocity.x *= 0.98f;
+        }
+    }
+
+    // Commun à tous : intégration, collisions et visuels.
+    void finishUpdate(float dt, const PlatformList& platforms, const LevelBounds& bounds) {
+        position += velocity * dt;
+
+        isGrounded = false;
+        for (const Platform* plat : platforms) resolveCollision(*plat);
+
+        if (position.y > bounds.floorY) {
+            position.y = bounds.floorY;
+            velocity.y = 0;
+            isGrounded = true;
+            if (moveState == MovementState::Falling) moveState = MovementState::Walking;
+        }
+
+        position.x = std::clamp(position.x, 120.f, bounds.width - 120.f);
+
+        float visualY = position.y;
+        if (isGrounded && moveState == MovementState::Walking) {
+            visualY += std::sin(animTimer * 3.f) * 2.f;
+        }
+
+        visualPos = {position.x, visualY};
+        animTimer += dt;
+
+        flashing = hitFlash > 0;
+        if (flashing) hitFlash -= dt;
+
+        particles.update(dt);
+                }
+
+                void updateFlightState(float dt, const sf::Vector2f& playerPos, Random& rng) {
+                    switch (moveState) {
+                        case MovementState::Walking:
+                            flyCooldown -= dt;
+                            if (flyCooldown <= 0 && isGrounded) {
+                                float dist = Math::distance(position, playerPos);
+                                if (dist < 500.f && rng.range(0, 100) < 30) {
+                                    moveState = MovementState::Flying;
+                                    flyTimer = Config::ENEMY_FLY_DURATION;
+                                    velocity.y = -200.f;
+
+                                    particles.emit(position + sf::Vector2f{0, 15.f},
+                                                   EnemyTints::get(size_t(type), ParticlePreset::EnemyTakeoff), 15);
+                                } else {
+                                    flyCooldown = rng.range(3.f, 8.f);
+                                }
+                            }
+                            break;
+                        case MovementState::Flying:
+                            flyTimer -= dt;
+                            if (flyTimer <= 0) {
+                                moveState = MovementState::Falling;
+                                flyCooldown = Config::ENEMY_FLY_COOLDOWN;
+                            }
+                            break;
+                        case MovementState::Falling: break;
+                    }
+                }
+
+                template <Type T>
+                void moveAs(SlotMap<Projectile>& projectiles) {
+                    switch (moveState) {
+                        case MovementState::Walking: walk<T>(aiDt, projectiles); break;
+                        case MovementState::Flying: fly<T>(aiDt, projectiles); break;
+                        case MovementState::Falling: velocity.x *= 0.98f; break;
+                    }
+                }
+
+                template <Type T>
+                void walk(float dt, SlotMap<Projectile>& projectiles) {
+                    const sf::Vector2f playerPos = target;
+                    float dist = Math::distance(position, playerPos);
+
+                    if (dist < 400.f) {
+                        // Le cap contourne les plateformes ; à la verticale du joueur il
+                        // ne dit plus rien sur x, on revient à la comparaison directe.
+                        float dir = std::abs(heading.x) > 0.2f ? (heading.x > 0 ? 1.f : -1.f)
+                                                               : (playerPos.x > position.x ? 1.f : -1.f);
+                        velocity.x = dir * speed;
+                        facingRight = dir > 0;
+                    } else {
+                        velocity.x = speed * patrolDir * 0.5f;
+                        if (position.x > startPos.x + patrolRange) patrolDir = -1;
+                        else if (position.x < startPos.x - patrolRange) patrolDir = 1;
+                        facingRight = patrolDir > 0;
+                    }
+
+                    if constexpr (T == Type::Blue) {
+                        shootCooldown -= dt;
+                        if (shootCooldown <= 0 && dist < 500.f) {
+                            shootCooldown = 2.5f;
+                            sf::Vector2f dir = Math::normalize(playerPos - position);
+                            projectiles.respawn(position, dir, 200.f, sf::Color(100, 150, 255));
+
+                            particles.emit(position, ParticlePresets::get(ParticlePreset::EnemyShot).aimed(std::atan2(dir.y, dir.x)), 15);
+                        }
+                    }
+
+                    if constexpr (T == Type::Yellow) {
+                        if (isGrounded) jumpCooldown -= dt;
+                        if (isGrounded && jumpCooldown <= 0 && dist < 300.f) {
+                            jumpCooldown = 1.5f;
+                            velocity.y = -400.f;
+                            isGrounded = false;
+
+                            particles.emit(position + sf::Vector2f{0, 15.f}, ParticlePreset::EnemyHop, 15);
+                        }
+                    }
+                }
+
+                template <Type T>
+                void fly(float dt, SlotMap<Projectile>& projectiles) {
+                    const sf::Vector2f playerPos = target;
+                    sf::Vector2f dir = heading;
+                    velocity.x = Math::lerp(velocity.x, dir.x * speed * 1.5f, std::min(dt * 3.f, 1.f));
+                    velocity.y = Math::lerp(velocity.y, dir.y * speed * 0.8f, std::min(dt * 2.f, 1.f));
+
+                    if (position.y < 200.f) velocity.y = std::max(velocity.y, 0.f);
+
+                    facingRight = velocity.x > 0;
+
+                    if (int(animTimer * 10) % 3 == 0) {
+                        particles.emit(position + sf::Vector2f{0, 10.f},
+                                       EnemyTints::get(size_t(type), ParticlePreset::EnemyFlightTrail), 1);
+                    }
+
+                    if constexpr (T == Type::Blue) {
+                        shootCooldown -= dt;
+                        float dist = Math::distance(position, playerPos);
+                        if (shootCooldown <= 0 && dist < 600.f) {
+                            shootCooldown = 1.5f;
+                            sf::Vector2f shootDir = Math::normalize(playerPos - position);
+                            projectiles.respawn(position, shootDir, 250.f, sf::Color(100, 150, 255));
+                        }
+                    }
+                }
+
+                void resolveCollision(const Platform& plat) {
+                    sf::FloatRect bounds = {{position.x - 15.f, position.y - 15.f}, {30.f, 30.f}};
+                    sf::FloatRect platBounds = plat.getBounds();
+
+                    if (!bounds.findIntersection(platBounds)) return;
+
+                    float oT = (bounds.position.y + bounds.size.y) - platBounds.position.y;
+
+                    if (velocity.y > 0 && oT < 20.f) {
+                        position.y = platBounds.position.y - 15.f;
+                        velocity.y = 0;
+                        isGrounded = true;
+                        if (moveState == MovementState::Falling) moveState = MovementState::Walking;
+                    }
+                }
+
+                void takeDamage(int dmg) {
+                    if (!alive) return;
+                    health -= dmg;
+                    hitFlash = 0.15f;
+
+                    if (health <= 0) {
+                        alive = false;
+                        particles.emit(position, EnemyTints::get(size_t(type), ParticlePreset::EnemyDeath), 50);
+                    }
+                }
+
+                // Halo des bleus, dessiné sous l'ensemble des ennemis.
+                void drawGlow(ShapeBatch& glow) const {
+                    if (alive && type == Type::Blue)
+                        glow.glow(visualPos, bodyRadius * 1.5f, sf::Color(80, 120, 200, 40));
+                }
+
+                void draw(sf::RenderTarget& target, FrameBatches& batches) const {
+                    particles.draw(target);
+                    if (!alive) return;
+
+                    bool detailed = Math::distance(position, target.getView().getCenter()) < batches.quality.enemyDetailRadius;
+
+                    if (detailed && moveState == MovementState::Flying) {
+                        float wingAnim = std::sin(animTimer * 15.f) * 10.f;
+                        sf::Vector2f c = visualPos;
+                        sf::Color wingColor(baseColor.r, baseColor.g, baseColor.b, 150);
+                        batches.scratch.wing(c, c + sf::Vector2f{-20.f, -10.f + wingAnim}, c + sf::Vector2f{-15.f, 5.f}, wingColor);
+                        batches.scratch.wing(c, c + sf::Vector2f{20.f, -10.f + wingAnim}, c + sf::Vector2f{15.f, 5.f}, wingColor);
+
+                        float flyRatio = flyTimer / Config::ENEMY_FLY_DURATION;
+                        batches.scratch.rect({position.x - 15.f, position.y - 35.f}, {30.f * flyRatio, 3.f}, sf::Color(100, 200, 255, 200));
+                    }
+
+                    // Ailes (sous le corps), corps et œil : un seul draw.
+                    batches.scratch.outlinedDisc(visualPos, bodyRadius, flashing ? sf::Color::White : baseColor, 2.f,
+                                                 sf::Color(baseColor.r / 2, baseColor.g / 2, baseColor.b / 2, 200));
+                    batches.scratch.disc(visualPos + sf::Vector2f{facingRight ? 6.f : -6.f, -5.f}, 5.f,
+                                         type == Type::Yellow ? sf::Color(50, 50, 50) : sf::Color(255, 200, 50));
+                    batches.scratch.flush(target);
+
+                    if (detailed && health < baseHealth) {
+                        float healthRatio = float(health) / baseHealth;
+                        batches.overlay.rect({position.x - 20.f, position.y - 40.f}, {40.f, 5.f}, sf::Color(50, 50, 50, 200));
+                        batches.overlay.rect({position.x - 20.f, position.y - 40.f}, {40.f * healthRatio, 5.f}, sf::Color(220, 80, 80, 220));
+                    }
+                }
+
+                sf::FloatRect getBounds() const {
+                    float r = bodyRadius;
+                    return {{position.x - r, position.y - r}, {r * 2, r * 2}};
+                }
+
+                bool isAlive() const { return alive; }
+                Type getType() const { return type; }
+                void setEffectScale(float scale) { particles.emissionScale = scale; }
+                int getDamage() const { return damage; }
+                sf::Vector2f getPosition() const { return position; }
+
+                Snapshot snapshot() const {
+                    return {position, startPos, velocity, type, moveState, patrolRange, speed, patrolDir,
+                            facingRight, isGrounded, alive, animTimer, hitFlash, shootCooldown, jumpCooldown,
+                            flyTimer, flyCooldown, health, baseHealth, damage, aiDebt};
+                }
+
+                void restore(const Snapshot& snap) {
+                    position = snap.position;
+                    startPos = snap.startPos;
+                    velocity = snap.velocity;
+                    type = snap.type;
+                    moveState = snap.moveState;
+                    patrolRange = snap.patrolRange;
+                    speed = snap.speed;
+                    patrolDir = snap.patrolDir;
+                    facingRight = snap.facingRight;
+                    isGrounded = snap.isGrounded;
+                    alive = snap.alive;
+                    animTimer = snap.animTimer;
+                    hitFlash = snap.hitFlash;
+                    shootCooldown = snap.shootCooldown;
+                    jumpCooldown = snap.jumpCooldown;
+                    flyTimer = snap.flyTimer;
+                    flyCooldown = snap.flyCooldown;
+                    health = snap.health;
+                    baseHealth = snap.baseHealth;
+                    damage = snap.damage;
+                    aiDebt = snap.aiDebt;
+
+                    setupVisuals();
+                    particles.clear();
+                    visualPos = position;
+                }
+
+private:
+    sf::Vector2f position, startPos;
+    sf::Vector2f velocity{0, 0};
+    sf::Vector2f target, heading;
+    sf::Vector2f visualPos; // position tracée (balancement de la marche)
+    float bodyRadius = 20.f;
+    bool flashing = false; // touché : corps blanc
+    sf::Color baseColor;
+    Type type = Type::Red;
+    MovementState moveState = MovementState::Walking;
+
+    float patrolRange = 150.f, speed = 80.f;
+    int patrolDir = 1;
+    bool facingRight = true, isGrounded = true;
+    float animTimer = 0, hitFlash = 0;
+    float shootCooldown = 2.f, jumpCooldown = 1.f;
+    float flyTimer = 0, flyCooldown = 3.f;
+
+    int health = 0, baseHealth = 1, damage = 1;
+    bool alive = true;
+
+    bool thinking = true;
+    float aiDt = 0, aiDebt = 0; // temps rendu à cette réflexion / accumulé depuis la dernière
+
+    mutable ParticleSystem particles{200}; // préréglages seulement : aucune entrée ad hoc
+};
+
+// ============================================================================
+// WAVE MANAGER
+// ============================================================================
+
+class WaveManager;
+
+// Script de vague : une coroutine qui attend (co_await) une durée ou une
+// condition et fait apparaître les ennemis par le WaveManager ; celui-ci ne
+// la reprend que quand l'attente est échue. Son cadre est pris dans un
+// tampon du WaveManager : lancer une vague n'alloue rien.
+class WaveScript {
+public:
+    struct promise_type {
+        WaveScript get_return_object() { return WaveScript(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        static void* operator new(size_t size, WaveManager& waves, int wave);
+        static void operator delete(void* frame, size_t size);
+    };
+
+    WaveScript() = default;
+    WaveScript(WaveScript&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    WaveScript& operator=(WaveScript&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    ~WaveScript() { destroy(); }
+
+    void resume() { if (!done()) handle.resume(); }
+    bool done() const { return !handle || handle.done(); }
+
+private:
+    explicit WaveScript(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    void destroy() {
+        if (handle) handle.destroy();
+        handle = {};
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Déroulé des vagues. Une coroutine ne se copie pas : l'instantané retient le
+// nombre d'attentes franchies par le script, et restore() le rejoue sans
+// effets jusqu'à cette attente. Un script ne dépend donc que de sa vague et
+// de sa taille : pas de tirage ni de test sur le monde hors des co_await.
+class WaveManager {
+public:
+    static constexpr int MAX_QUEUED = 20;
+    static constexpr size_t SCRIPT_FRAME_BYTES = 256;
+
+    enum class Wait : uint8_t { None, Time, FieldClear };
+    static constexpr size_t WAIT_COUNT = size_t(Wait::FieldClear) + 1;
+
+    struct Snapshot {
+        int currentWave, enemiesRemaining;
+        bool waveComplete;
+        float spawnTimer, spawnInterval;
+        uint8_t queuedCount;
+        Enemy::Type queued[MAX_QUEUED];
+        // Script : taille de la vague, attentes franchies et attente en cours.
+        uint8_t waveSize;
+        bool scriptDone;
+        Wait waiting;
+        uint16_t awaitCount;
+        float waitDuration;
+    };
+
+    // rng : générateur de la simulation du monde propriétaire.
+    explicit WaveManager(Random& rng) : rng(rng) { enemiesToSpawn.reserve(MAX_QUEUED); }
+
+    // Le cadre du script pointe sur ce WaveManager.
+    WaveManager(const WaveManager&) = delete;
+    WaveManager& operator=(const WaveManager&) = delete;
+
+    static int waveSizeFor(int wave) { return std::min(3 + wave * 2, MAX_QUEUED); }
+
+    void startWave(int wave) {
+        currentWave = wave;
+        enemiesRemaining = 0;
+        waveComplete = false;
+        spawnTimer = 0;
+        enemiesToSpawn.clear();
+
+        int maxEnemies = waveSizeFor(wave);
+
+        for (int i = 0; i < maxEnemies; ++i) {
+            Enemy::Type type;
+            int roll = rng.range(0, 100);
+
+            if (wave < 3) type = Enemy::Type::Red;
+            else if (wave < 5) type = roll < 70 ? Enemy::Type::Red : Enemy::Type::Blue;
+            else if (wave < 8) {
+                if (roll < 50) type = Enemy::Type::Red;
+                else if (roll < 80) type = Enemy::Type::Blue;
+                else type = Enemy::Type::Yellow;
+            } else {
+                if (roll < 35) type = Enemy::Type::Red;
+                else if (roll < 65) type = Enemy::Type::Blue;
+                else type = Enemy::Type::Yellow;
+            }
+
+            enemiesToSpawn.push_back(type);
+        }
+
+        waveSize = uint8_t(maxEnemies);
+        enemiesRemaining = static_cast<int>(enemiesToSpawn.size());
+        if (telemetry) telemetry->record(TelemetryLog::EventType::WaveStart, 0, int16_t(wave), enemiesRemaining);
+
+        launchScript(0);
+    }
+
+    // Reprend le script si son attente est échue.
+    void update(float dt, SlotMap<Enemy>& enemies, const sf::Vector2f& playerPos) {
+        if (script.done()) return;
+        switch (waiting) {
+            case Wait::Time:
+                spawnTimer += dt;
+                if (spawnTimer < waitDuration) return;
+                break;
+            case Wait::FieldClear:
+                if (enemiesRemaining != 0) return;
+                for (const auto& e : enemies) if (e.isAlive()) return;
+                break;
+            case Wait::None: break;
+        }
+        spawnTarget = &enemies;
+        spawnFocus = playerPos;
+        script.resume();
+        spawnTarget = nullptr;
+    }
+
+    int getCurrentWave() const { return currentWave; }
+    int getEnemiesRemaining() const { return enemiesRemaining; }
+    bool isWaveComplete() const { return waveComplete; }
+    void enemyKilled() { if (enemiesRemaining > 0) enemiesRemaining--; }
+
+    void setSpawnZones(const LevelFormat::SpawnZone* zones, size_t count) {
+        if (count > 0) spawnZones.assign(zones, zones + count);
+    }
+
+    void setTelemetry(TelemetryLog* log) { telemetry = log; }
+
+    Snapshot snapshot() const {
+        Snapshot snap{currentWave, enemiesRemaining, waveComplete, spawnTimer, spawnInterval,
+                      uint8_t(enemiesToSpawn.size()), {}, waveSize, script.done(), waiting, uint16_t(awaitCount), waitDuration};
+        std::copy(enemiesToSpawn.begin(), enemiesToSpawn.end(), snap.queued);
+        return snap;
+    }
+
+    // Les zones d'apparition viennent du niveau et du streaming, pas de l'instantané.
+    void restore(const Snapshot& snap) {
+        currentWave = snap.currentWave;
+        enemiesRemaining = snap.enemiesRemaining;
+        waveComplete = snap.waveComplete;
+        spawnInterval = snap.spawnInterval;
+        enemiesToSpawn.assign(snap.queued, snap.queued + snap.queuedCount);
+        waveSize = snap.waveSize;
+
+        script = WaveScript{};
+        if (currentWave > 0) launchScript(snap.scriptDone ? UINT32_MAX : snap.awaitCount);
+        waiting = snap.waiting;
+        awaitCount = snap.awaitCount;
+        waitDuration = snap.waitDuration;
+        spawnTimer = snap.spawnTimer;
+    }
+
+private:
+    friend struct WaveScript::promise_type;
+
+    struct Awaiter {
+        WaveManager& waves;
+        Wait kind;
+        float duration;
+
+        bool await_ready() { return waves.enterWait(kind, duration); }
+        void await_suspend(std::coroutine_handle<>) {}
+        void await_resume() {}
+    };
+
+    Awaiter delay(float seconds) { return {*this, Wait::Time, seconds}; }
+    Awaiter fieldClear() { return {*this, Wait::FieldClear, 0}; }
+
+    // Vague standard : une apparition par intervalle, puis attendre que le
+    // terrain soit nettoyé.
+    static WaveScript standardWave(WaveManager& waves, int wave) {
+        for (int i = 0; i < waves.waveSize; ++i) {
+            co_await waves.delay(waves.spawnInterval);
+            waves.spawnNext();
+            waves.setSpawnInterval(std::max(0.3f, 1.5f - wave * 0.1f));
+        }
+        co_await waves.fieldClear();
+        waves.completeWave();
+    }
+
+    // Crée le script de la vague et l'amène à sa première attente ; en
+    // rejeu, jusqu'à l'attente replayUntil (toutes : UINT32_MAX).
+    void launchScript(uint32_t replayUntil) {
+        script = WaveScript{}; // libère le tampon avant le nouveau cadre
+        awaitCount = 0;
+        waiting = Wait::None;
+        replayTo = replayUntil;
+        script = standardWave(*this, currentWave);
+        script.resume();
+        replayTo = 0;
+    }
+
+    // true : attente déjà franchie avant l'instantané, le rejeu continue.
+    bool enterWait(Wait kind, float duration) {
+        ++awaitCount;
+        if (replayTo > awaitCount) return true;
+        replayTo = 0;
+        waiting = kind;
+        waitDuration = duration;
+        spawnTimer = 0;
+        return false;
+    }
+
+    // Effets du script, ignorés pendant le rejeu (l'instantané les contient déjà).
+    void spawnNext() {
+        if (replayTo || enemiesToSpawn.empty() || !spawnTarget) return;
+        Enemy::Type type = enemiesToSpawn.back();
+        enemiesToSpawn.pop_back();
+
+        // Zone d'apparition la plus éloignée du joueur.
+        const LevelFormat::SpawnZone* zone = &spawnZones.front();
+        for (const auto& z : spawnZones) {
+            if (std::abs((z.minX + z.maxX) / 2.f - spawnFocus.x) > std::abs((zone->minX + zone->maxX) / 2.f - spawnFocus.x))
+                zone = &z;
+        }
+        float spawnX = rng.range(zone->minX, zone->maxX);
+
+        SlotHandle handle = spawnTarget->respawn(sf::Vector2f{spawnX, zone->y}, type, currentWave, rng);
+        if (telemetry)
+            telemetry->record(TelemetryLog::EventType::EnemySpawn, uint8_t(type), 0, currentWave, {spawnX, zone->y}, handle.generation);
+    }
+
+    void setSpawnInterval(float seconds) {
+        if (!replayTo) spawnInterval = seconds;
+    }
+
+    void completeWave() {
+        if (replayTo) return;
+        waveComplete = true;
+        if (telemetry) telemetry->record(TelemetryLog::EventType::WaveEnd, 0, int16_t(currentWave));
+    }
+
+    // Cadre du script : dans frameBuffer s'il y tient (un seul à la fois),
+    // sinon sur le tas. L'en-tête retient le propriétaire pour la libération.
+    static constexpr size_t FRAME_HEADER = alignof(std::max_align_t);
+
+    void* allocateFrame(size_t size) {
+        void* raw;
+        WaveManager* owner = nullptr;
+        if (!frameInUse && size + FRAME_HEADER <= SCRIPT_FRAME_BYTES) {
+            frameInUse = true;
+            owner = this;
+            raw = frameBuffer;
+        } else {
+            raw = ::operator new(size + FRAME_HEADER);
+        }
+        *static_cast<WaveManager**>(raw) = owner;
+        return static_cast<std::byte*>(raw) + FRAME_HEADER;
+    }
+
+    static void releaseFrame(void* frame) {
+        void* raw = static_cast<std::byte*>(frame) - FRAME_HEADER;
+        if (WaveManager* owner = *static_cast<WaveManager**>(raw)) owner->frameInUse = false;
+        else ::operator delete(raw);
+    }
+
+    Random& rng;
+    int currentWave = 0, enemiesRemaining = 0;
+    bool waveComplete = false;
+    float spawnTimer = 0, spawnInterval = 1.f;
+    std::vector<Enemy::Type> enemiesToSpawn;
+    std::vector<LevelFormat::SpawnZone> spawnZones{{200.f, 1000.f, 1000.f}, {2000.f, 2800.f, 1000.f}};
+    TelemetryLog* telemetry = nullptr;
+
+    uint8_t waveSize = 0;
+    Wait waiting = Wait::None;
+    uint32_t awaitCount = 0, replayTo = 0;
+    float waitDuration = 0;
+    SlotMap<Enemy>* spawnTarget = nullptr; // le temps d'une reprise du script
+    sf::Vector2f spawnFocus;
+    alignas(std::max_align_t) std::byte frameBuffer[SCRIPT_FRAME_BYTES];
+    bool frameInUse = false;
+    WaveScript script; // dernier membre : détruit en premier, avant le tampon
+};
+
+inline void* WaveScript::promise_type::operator new(size_t size, WaveManager& waves, int) {
+    return waves.allocateFrame(size);
+}
+
+inline void WaveScript::promise_type::operator delete(void* frame, size_t) { WaveManager::releaseFrame(frame); }
+
+// ============================================================================
+// UPGRADE SYSTEM
+// ============================================================================
+
+class UpgradeSystem {
+public:
+    struct Upgrade {
+        std::string name, description;
+        sf::Color color;
+        int upgradeType;
+    };
+
+    explicit UpgradeSystem(const FontManager& fonts) : fonts(fonts) {}
+
+    void generateChoices() {
+        choices.clear();
+
+        std::vector<Upgrade> allUpgrades = {
+            {"Vitesse+", "Deplacement +20%", sf::Color(100, 200, 100), 0},
+            {"Saut+", "Hauteur +15%", sf::Color(100, 150, 255), 1},
+            {"Attaque+", "Degats +1", sf::Color(255, 100, 100), 2},
+            {"Portee+", "Portee +30%", sf::Color(255, 150, 50), 3},
+            {"Dash+", "Cooldown -25%", sf::Color(200, 100, 255), 4},
+            {"Vol+", "Duree +2s", sf::Color(100, 220, 255), 5},
+            {"Vie+", "PV max +1", sf::Color(255, 100, 150), 6},
+            {"Vitesse ATK+", "Attaque +25%", sf::Color(255, 200, 100), 7},
+        };
+
+        std::vector<int> indices;
+        for (size_t i = 0; i < allUpgrades.size(); ++i) indices.push_back(static_cast<int>(i));
+
+        for (int i = 0; i < 3 && !indices.empty(); ++i) {
+            int idx = rng.range(0, int(indices.size()) - 1);
+            choices.push_back(allUpgrades[indices[idx]]);
+            indices.erase(indices.begin() + idx);
+        }
+
+        selectedIndex = 0;
+        isActive = true;
+    }
+
+    int update(const InputManager& input) {
+        if (!isActive) return -1;
+
+        if (input.justPressed("left")) selectedIndex = (selectedIndex + choices.size() - 1) % choices.size();
+        if (input.justPressed("right")) selectedIndex = (selectedIndex + 1) % choices.size();
+
+        if (input.justPressed("num1") && choices.size() > 0) return 0;
+        if (input.justPressed("num2") && choices.size() > 1) return 1;
+        if (input.justPressed("num3") && choices.size() > 2) return 2;
+
+        if (input.justPressed("confirm")) return static_cast<int>(selectedIndex);
+
+        return -1;
+    }
+
+    void applyUpgrade(int index, PlayerStats& stats) {
+        if (index >= 0 && index < int(choices.size())) {
+            switch (choices[index].upgradeType) {
                 case 0: stats.speedMultiplier += 0.2f; break;
                 case 1: stats.jumpMultiplier += 0.15f; break;
                 case 2: stats.attackDamage += 1; break;
@@ -1333,701 +4322,1953 @@ public:
                 case 6: stats.maxHealth += 1; break;
                 case 7: stats.attackSpeed += 0.25f; break;
             }
+            if (telemetry) telemetry->record(TelemetryLog::EventType::UpgradeChosen, uint8_t(choices[index].upgradeType));
+        }
+        isActive = false;
+    }
+
+    void setTelemetry(TelemetryLog* log) { telemetry = log; }
+
+    void draw(sf::RenderTarget& target) const {
+        if (!isActive) return;
+
+        sf::Vector2f size = target.getView().getSize();
+        sf::Vector2f center = target.getView().getCenter();
+        float left = center.x - size.x / 2.f;
+        float top = center.y - size.y / 2.f;
+
+        sf::RectangleShape overlay;
+        overlay.setSize(size);
+        overlay.setPosition({left, top});
+        overlay.setFillColor(sf::Color(0, 0, 0, 200));
+        target.draw(overlay);
+
+        const sf::Font& font = fonts.getFont();
+        bool hasFont = fonts.isLoaded();
+
+        if (hasFont) {
+            sf::Text title(font, "AMELIORATION", 48);
+            title.setFillColor(sf::Color(150, 200, 255));
+            sf::FloatRect tb = title.getGlobalBounds();
+            title.setPosition({center.x - tb.size.x / 2.f, top + 80.f});
+            target.draw(title);
+
+            sf::Text sub(font, "Choisissez (1, 2, 3 ou Fleches + Entree)", 20);
+            sub.setFillColor(sf::Color(150, 150, 150));
+            sf::FloatRect sb = sub.getGlobalBounds();
+            sub.setPosition({center.x - sb.size.x / 2.f, top + 140.f});
+            target.draw(sub);
+        }
+
+        float startX = center.x - (choices.size() * 220.f) / 2.f;
+
+        for (size_t i = 0; i < choices.size(); ++i) {
+            const auto& upgrade = choices[i];
+            float x = startX + i * 220.f;
+            float y = center.y - 100.f;
+            bool selected = (i == selectedIndex);
+
+            sf::RectangleShape card{{200.f, 280.f}};
+            card.setPosition({x, y + (selected ? -15.f : 0.f)});
+            card.setFillColor(selected ? sf::Color(50, 60, 80, 250) : sf::Color(30, 40, 55, 230));
+            card.setOutlineThickness(selected ? 4.f : 2.f);
+            card.setOutlineColor(selected ? upgrade.color : sf::Color(80, 90, 110, 200));
+            target.draw(card);
+
+            sf::CircleShape numBg(22.f);
+            numBg.setOrigin({22.f, 22.f});
+            numBg.setPosition({x + 100.f, y + (selected ? -15.f : 0.f) + 45.f});
+            numBg.setFillColor(upgrade.color);
+            target.draw(numBg);
+
+            if (hasFont) {
+                sf::Text num(font, std::to_string(i + 1), 28);
+                num.setFillColor(sf::Color::White);
+                num.setStyle(sf::Text::Bold);
+                sf::FloatRect nb = num.getGlobalBounds();
+                num.setPosition({x + 100.f - nb.size.x / 2.f, y + (selected ? -15.f : 0.f) + 28.f});
+                target.draw(num);
+            }
+
+            sf::CircleShape icon(35.f);
+            icon.setOrigin({35.f, 35.f});
+            icon.setPosition({x + 100.f, y + (selected ? -15.f : 0.f) + 120.f});
+            icon.setFillColor(upgrade.color);
+            target.draw(icon);
+
+            if (hasFont) {
+                sf::Text name(font, upgrade.name, 22);
+                name.setFillColor(sf::Color::White);
+                name.setStyle(sf::Text::Bold);
+                sf::FloatRect nameb = name.getGlobalBounds();
+                name.setPosition({x + 100.f - nameb.size.x / 2.f, y + (selected ? -15.f : 0.f) + 180.f});
+                target.draw(name);
+
+                sf::Text desc(font, upgrade.description, 16);
+                desc.setFillColor(sf::Color(180, 180, 180));
+                sf::FloatRect descb = desc.getGlobalBounds();
+                desc.setPosition({x + 100.f - descb.size.x / 2.f, y + (selected ? -15.f : 0.f) + 220.f});
+                target.draw(desc);
+            }
         }
-        isActive = false;
     }
 
-    void draw(sf::RenderTarget& target) const {
-        if (!isActive) return;
+    bool active() const { return isActive; }
+    size_t getSelected() const { return selectedIndex; }
+
+private:
+    const FontManager& fonts;
+    Random rng;
+    std::vector<Upgrade> choices;
+    size_t selectedIndex = 0;
+    bool isActive = false;
+    TelemetryLog* telemetry = nullptr;
+};
+
+// ============================================================================
+// HUD
+// ============================================================================
+
+// Texte d'interface construit une fois : la chaîne n'est refaite que quand sa
+// clé change (un sf::Text temporaire alloue sa géométrie à chaque frame).
+class CachedText {
+public:
+    CachedText(const FontManager& fonts, unsigned int size, sf::Color color, bool bold = false)
+    : fonts(fonts), size(size), color(color), bold(bold) {}
+
+    // nullptr tant que la police n'est pas chargée.
+    template <typename MakeString>
+    sf::Text* get(long key, MakeString make) {
+        if (!fonts.isLoaded()) return nullptr;
+        if (!text) {
+            text.emplace(fonts.getFont(), make(), size);
+            text->setFillColor(color);
+            if (bold) text->setStyle(sf::Text::Bold);
+        } else if (key != cachedKey) {
+            text->setString(make());
+        }
+        cachedKey = key;
+        return &*text;
+    }
+
+    sf::Text* get(const char* fixed) { return get(0, [fixed] { return std::string(fixed); }); }
+
+private:
+    const FontManager& fonts;
+    unsigned int size;
+    sf::Color color;
+    bool bold;
+    long cachedKey = 0;
+    std::optional<sf::Text> text;
+};
+
+class GameHUD {
+public:
+    explicit GameHUD(const FontManager& fonts) : fonts(fonts) {}
+
+    void update(int health, int maxHealth, int soul, float flight,
+                int wave, int enemiesLeft, const PlayerStats& stats) {
+        currentHealth = health;
+        currentMaxHealth = maxHealth;
+        currentSoul = soul;
+        flightTime = flight;
+        currentWave = wave;
+        currentEnemies = enemiesLeft;
+        playerStats = stats;
+        pulseTimer += 1.f/60.f;
+                }
+
+                // Formes dans batch (un seul draw), textes par-dessus.
+                void draw(sf::RenderTarget& target, ShapeBatch& batch) const {
+                    sf::Vector2f size = target.getView().getSize();
+                    sf::Vector2f center = target.getView().getCenter();
+                    float left = center.x - size.x / 2.f;
+                    float top = center.y - size.y / 2.f;
+
+                    // Conteneur santé
+                    batch.panel({left + 20.f, top + 20.f}, {260.f, 80.f}, sf::Color(10, 12, 20, 220), 2.f, sf::Color(60, 70, 90, 200));
+
+                    for (int i = 0; i < currentMaxHealth; ++i) {
+                        int col = i % 6;
+                        int row = i / 6;
+                        sf::Vector2f pos{left + 45.f + col * 32.f, top + 55.f + row * 22.f};
+
+                        if (i < currentHealth) {
+                            float pulse = 1.f + std::sin(pulseTimer * 2.f + i * 0.5f) * 0.1f;
+                            batch.circle(pos, 9.f * pulse, sf::Color(220, 60, 80, 255));
+                        } else {
+                            batch.circle(pos, 9.f, sf::Color(40, 30, 35, 200));
+                        }
+                    }
+
+                    // Barre de vol
+                    if (flightTime > 0) {
+                        batch.panel({center.x - 140.f, top + 20.f}, {280.f, 22.f}, sf::Color(15, 20, 30, 220), 2.f, sf::Color(80, 150, 220, 200));
+                        float progress = flightTime / (Config::FLIGHT_DURATION * playerStats.flightDurationMultiplier);
+                        batch.rect({center.x - 138.f, top + 22.f}, {276.f * progress, 18.f}, sf::Color(100, 200, 255, 230));
+                    }
+
+                    // Vague
+                    batch.panel({left + size.x - 200.f, top + 20.f}, {180.f, 60.f}, sf::Color(10, 12, 20, 220), 2.f, sf::Color(60, 70, 90, 200));
+                    batch.flush(target);
+
+                    if (sf::Text* vie = vieLabel.get("VIE")) {
+                        vie->setPosition({left + 30.f, top + 25.f});
+                        target.draw(*vie);
+                    }
+
+                    if (flightTime > 0) {
+                        if (sf::Text* flight = flightLabel.get("VOL DRAGON")) {
+                            flight->setPosition({center.x - flight->getGlobalBounds().size.x / 2.f, top + 23.f});
+                            target.draw(*flight);
+                        }
+                    }
+
+                    if (sf::Text* wave = waveLabel.get(currentWave, [this] { return "VAGUE " + std::to_string(currentWave); })) {
+                        wave->setPosition({left + size.x - 185.f, top + 28.f});
+                        target.draw(*wave);
+                    }
+
+                    if (sf::Text* count = enemyLabel.get(currentEnemies, [this] { return "Ennemis: " + std::to_string(currentEnemies); })) {
+                        count->setPosition({left + size.x - 185.f, top + 55.f});
+                        target.draw(*count);
+                    }
+                }
+
+private:
+    const FontManager& fonts;
+    int currentHealth = Config::MAX_HEALTH;
+    int currentMaxHealth = Config::MAX_HEALTH;
+    int currentSoul = 0;
+    float flightTime = 0;
+    int currentWave = 1;
+    int currentEnemies = 0;
+    PlayerStats playerStats;
+    mutable float pulseTimer = 0;
+
+    mutable CachedText vieLabel{fonts, 14, sf::Color(150, 150, 150)};
+    mutable CachedText flightLabel{fonts, 12, sf::Color::White};
+    mutable CachedText waveLabel{fonts, 22, sf::Color(255, 220, 100), true};
+    mutable CachedText enemyLabel{fonts, 14, sf::Color(255, 100, 100)};
+};
+
+// ============================================================================
+// CONTROLS HINT
+// ============================================================================
+
+class ControlsHint {
+public:
+    explicit ControlsHint(const FontManager& fonts) : text(fonts, 14, sf::Color(150, 150, 150)) {}
+
+    void draw(sf::RenderTarget& target, ShapeBatch& batch) const {
+        sf::Vector2f size = target.getView().getSize();
+        sf::Vector2f center = target.getView().getCenter();
+        float left = center.x - size.x / 2.f;
+        float bottom = center.y + size.y / 2.f;
+
+        batch.panel({left + 20.f, bottom - 55.f}, {size.x - 40.f, 40.f}, sf::Color(10, 12, 20, 180), 1.f, sf::Color(50, 60, 80, 150));
+        batch.flush(target);
+
+        if (sf::Text* controls = text.get("[Fleches/WASD] Deplacer   [Espace] Sauter   [V] Attaquer   [Shift] Dash   [Y-H-P] Dragon   [F5/F9] Sauver/Reprendre   [Echap] Pause")) {
+            controls->setPosition({center.x - controls->getGlobalBounds().size.x / 2.f, bottom - 48.f});
+            target.draw(*controls);
+        }
+    }
+
+private:
+    mutable CachedText text;
+};
+
+// ============================================================================
+// PAUSE MENU (CENTRÉ)
+// ============================================================================
+
+class PauseMenu {
+public:
+    enum class Result { None, Resume, MainMenu, Quit };
+
+    explicit PauseMenu(const FontManager& fonts) : fonts(fonts) {}
+
+    Result update(const InputManager& input) {
+        if (input.justPressed("down")) selected = (selected + 1) % 3;
+        if (input.justPressed("up")) selected = (selected + 2) % 3;
+
+        if (input.justPressed("pause")) return Result::Resume;
+
+        if (input.justPressed("confirm")) {
+            if (selected == 0) return Result::Resume;
+            if (selected == 1) return Result::MainMenu;
+            if (selected == 2) return Result::Quit;
+        }
+
+        return Result::None;
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        sf::Vector2f size = target.getView().getSize();
+        sf::Vector2f center = target.getView().getCenter();
+        float left = center.x - size.x / 2.f;
+        float top = center.y - size.y / 2.f;
+
+        sf::RectangleShape overlay;
+        overlay.setSize(size);
+        overlay.setPosition({left, top});
+        overlay.setFillColor(sf::Color(0, 0, 0, 180));
+        target.draw(overlay);
+
+        sf::RectangleShape panel{{380.f, 320.f}};
+        panel.setPosition({center.x - 190.f, center.y - 160.f});
+        panel.setFillColor(sf::Color(15, 20, 35, 250));
+        panel.setOutlineThickness(3.f);
+        panel.setOutlineColor(sf::Color(100, 150, 200, 200));
+        target.draw(panel);
+
+        const sf::Font& font = fonts.getFont();
+        bool hasFont = fonts.isLoaded();
+
+        if (hasFont) {
+            sf::Text title(font, "PAUSE", 42);
+            title.setFillColor(sf::Color(150, 200, 255));
+            title.setStyle(sf::Text::Bold);
+            sf::FloatRect tb = title.getGlobalBounds();
+            title.setPosition({center.x - tb.size.x / 2.f, center.y - 140.f});
+            target.draw(title);
+        }
+
+        std::vector<std::string> options = {"Reprendre", "Menu Principal", "Quitter"};
+
+        for (size_t i = 0; i < options.size(); ++i) {
+            float btnY = center.y - 50.f + i * 65.f;
+
+            sf::RectangleShape btn{{280.f, 50.f}};
+            btn.setPosition({center.x - 140.f, btnY});
+
+            if (i == selected) {
+                btn.setFillColor(sf::Color(60, 80, 120, 240));
+                btn.setOutlineThickness(2.f);
+                btn.setOutlineColor(sf::Color(150, 200, 255, 255));
+            } else {
+                btn.setFillColor(sf::Color(40, 50, 70, 200));
+                btn.setOutlineThickness(1.f);
+                btn.setOutlineColor(sf::Color(80, 100, 130, 150));
+            }
+            target.draw(btn);
+
+            if (hasFont) {
+                sf::Text opt(font, options[i], 22);
+                opt.setFillColor(sf::Color::White);
+                sf::FloatRect ob = opt.getGlobalBounds();
+                opt.setPosition({center.x - ob.size.x / 2.f, btnY + 12.f});
+                target.draw(opt);
+            }
+        }
+    }
+
+    void reset() { selected = 0; }
+    size_t getSelected() const { return selected; }
+
+private:
+    const FontManager& fonts;
+    size_t selected = 0;
+};
+
+// ============================================================================
+// MENU PRINCIPAL (CENTRÉ DYNAMIQUEMENT)
+// ============================================================================
+
+class MainMenu {
+public:
+    enum class Result { None, Play, Quit };
+
+    explicit MainMenu(const FontManager& fonts) : fonts(fonts) {
+        particles.gravity = -15.f;
+        particles.drag = 0.2f;
+    }
+
+    Result update(float dt, const InputManager& input) {
+        timer += dt;
+
+        if (input.justPressed("down") || input.justPressed("up")) {
+            selected = (selected + 1) % 2;
+        }
+
+        if (input.justPressed("confirm")) {
+            if (selected == 0) return Result::Play;
+            if (selected == 1) return Result::Quit;
+        }
+
+        return Result::None;
+    }
+
+    void draw(sf::RenderTarget& target) {
+        // Obtenir les dimensions réelles de l'écran
+        sf::Vector2f viewSize = target.getView().getSize();
+        sf::Vector2f viewCenter = target.getView().getCenter();
+
+        float left = viewCenter.x - viewSize.x / 2.f;
+        float top = viewCenter.y - viewSize.y / 2.f;
+        float centerX = viewCenter.x;
+        float centerY = viewCenter.y;
+        float width = viewSize.x;
+        float height = viewSize.y;
+
+        // Background plein écran
+        sf::RectangleShape bg;
+        bg.setSize(viewSize);
+        bg.setPosition({left, top});
+        bg.setFillColor(sf::Color(8, 10, 20));
+        target.draw(bg);
+
+        // Particules
+        if (random.range(0, 100) < 8) {
+            particles.emit({left + random.range(0.f, width), top + height + 20.f}, ParticlePreset::MenuMote, 1);
+        }
+        particles.update(1.f/60.f);
+        particles.draw(target);
+
+        // Logo centré
+        float pulse = std::sin(timer * 2.f) * 0.1f + 1.f;
 
-        sf::Vector2f size = target.getView().getSize();
-        sf::Vector2f center = target.getView().getCenter();
-        float left = center.x - size.x / 2.f;
-        float top = center.y - size.y / 2.f;
+        sf::CircleShape logoGlow(130.f);
+        logoGlow.setOrigin({130.f, 130.f});
+        logoGlow.setPosition({centerX, centerY - 150.f});
+        logoGlow.setFillColor(sf::Color(80, 150, 255, 40));
+        logoGlow.setScale({pulse, pulse});
+        target.draw(logoGlow, sf::RenderStates(sf::BlendAdd));
 
-        sf::RectangleShape overlay;
-        overlay.setSize(size);
-        overlay.setPosition({left, top});
-        overlay.setFillColor(sf::Color(0, 0, 0, 200));
-        target.draw(overlay);
+        sf::CircleShape logo(100.f);
+        logo.setOrigin({100.f, 100.f});
+        logo.setPosition({centerX, centerY - 150.f});
+        logo.setFillColor(sf::Color(100, 180, 255, 220));
+        logo.setOutlineThickness(5.f);
+        logo.setOutlineColor(sf::Color(150, 200, 255, 255));
+        target.draw(logo);
 
-        auto& font = FontManager::instance().getFont();
-        bool hasFont = FontManager::instance().isLoaded();
+        const sf::Font& font = fonts.getFont();
+        bool hasFont = fonts.isLoaded();
 
         if (hasFont) {
-            sf::Text title(font, "AMELIORATION", 48);
+            // Titre centré
+            sf::Text title(font, "SOUL WORLD", 72);
             title.setFillColor(sf::Color(150, 200, 255));
-            sf::FloatRect tb = title.getGlobalBounds();
-            title.setPosition({center.x - tb.size.x / 2.f, top + 80.f});
+            title.setStyle(sf::Text::Bold);
+            sf::FloatRect titleBounds = title.getGlobalBounds();
+            title.setPosition({centerX - titleBounds.size.x / 2.f, centerY - 20.f});
             target.draw(title);
 
-            sf::Text sub(font, "Choisissez (1, 2, 3 ou Fleches + Entree)", 20);
-            sub.setFillColor(sf::Color(150, 150, 150));
-            sf::FloatRect sb = sub.getGlobalBounds();
-            sub.setPosition({center.x - sb.size.x / 2.f, top + 140.f});
-            target.draw(sub);
+            // Sous-titre
+            sf::Text subtitle(font, "Infinite Waves", 28);
+            subtitle.setFillColor(sf::Color(200, 180, 100));
+            sf::FloatRect subBounds = subtitle.getGlobalBounds();
+            subtitle.setPosition({centerX - subBounds.size.x / 2.f, centerY + 60.f});
+            target.draw(subtitle);
         }
 
-        float startX = center.x - (choices.size() * 220.f) / 2.f;
+        // Boutons centrés
+        std::vector<std::string> options = {"JOUER", "QUITTER"};
+        float buttonY = centerY + 140.f;
 
-        for (size_t i = 0; i < choices.size(); ++i) {
-            const auto& upgrade = choices[i];
-            float x = startX + i * 220.f;
-            float y = center.y - 100.f;
-            bool selected = (i == selectedIndex);
+        for (size_t i = 0; i < options.size(); ++i) {
+            float btnX = centerX - 140.f;
+            float btnY = buttonY + i * 75.f;
 
-            sf::RectangleShape card{{200.f, 280.f}};
-            card.setPosition({x, y + (selected ? -15.f : 0.f)});
-            card.setFillColor(selected ? sf::Color(50, 60, 80, 250) : sf::Color(30, 40, 55, 230));
-            card.setOutlineThickness(selected ? 4.f : 2.f);
-            card.setOutlineColor(selected ? upgrade.color : sf::Color(80, 90, 110, 200));
-            target.draw(card);
+            sf::RectangleShape btn{{280.f, 55.f}};
+            btn.setPosition({btnX, btnY});
 
-            sf::CircleShape numBg(22.f);
-            numBg.setOrigin({22.f, 22.f});
-            numBg.setPosition({x + 100.f, y + (selected ? -15.f : 0.f) + 45.f});
-            numBg.setFillColor(upgrade.color);
-            target.draw(numBg);
+            if (i == selected) {
+                btn.setFillColor(sf::Color(60, 80, 120, 240));
+                btn.setOutlineThickness(3.f);
+                btn.setOutlineColor(sf::Color(150, 200, 255, 255));
+
+                sf::CircleShape arrow(12.f, 3);
+                arrow.setOrigin({12.f, 12.f});
+                arrow.setRotation(sf::degrees(90.f));
+                arrow.setPosition({btnX - 30.f, btnY + 27.f});
+                arrow.setFillColor(sf::Color(150, 200, 255, 255));
+                target.draw(arrow);
+            } else {
+                btn.setFillColor(sf::Color(40, 50, 70, 200));
+                btn.setOutlineThickness(2.f);
+                btn.setOutlineColor(sf::Color(80, 100, 130, 150));
+            }
+            target.draw(btn);
 
             if (hasFont) {
-                sf::Text num(font, std::to_string(i + 1), 28);
-                num.setFillColor(sf::Color::White);
-                num.setStyle(sf::Text::Bold);
-                sf::FloatRect nb = num.getGlobalBounds();
-                num.setPosition({x + 100.f - nb.size.x / 2.f, y + (selected ? -15.f : 0.f) + 28.f});
-                target.draw(num);
+                sf::Text opt(font, options[i], 28);
+                opt.setFillColor(sf::Color::White);
+                opt.setStyle(sf::Text::Bold);
+                sf::FloatRect optBounds = opt.getGlobalBounds();
+                opt.setPosition({centerX - optBounds.size.x / 2.f, btnY + 10.f});
+                target.draw(opt);
             }
+        }
 
-            sf::CircleShape icon(35.f);
-            icon.setOrigin({35.f, 35.f});
-            icon.setPosition({x + 100.f, y + (selected ? -15.f : 0.f) + 120.f});
-            icon.setFillColor(upgrade.color);
-            target.draw(icon);
+        // Instructions en bas
+        if (hasFont) {
+            sf::Text hint(font, "Fleches + Entree pour naviguer", 18);
+            hint.setFillColor(sf::Color(120, 120, 120));
+            sf::FloatRect hintBounds = hint.getGlobalBounds();
+            hint.setPosition({centerX - hintBounds.size.x / 2.f, top + height - 80.f});
+            target.draw(hint);
 
-            if (hasFont) {
-                sf::Text name(font, upgrade.name, 22);
-                name.setFillColor(sf::Color::White);
-                name.setStyle(sf::Text::Bold);
-                sf::FloatRect nameb = name.getGlobalBounds();
-                name.setPosition({x + 100.f - nameb.size.x / 2.f, y + (selected ? -15.f : 0.f) + 180.f});
-                target.draw(name);
+            sf::Text version(font, "v1.0 - F11 plein ecran", 14);
+            version.setFillColor(sf::Color(80, 80, 80));
+            sf::FloatRect verBounds = version.getGlobalBounds();
+            version.setPosition({centerX - verBounds.size.x / 2.f, top + height - 45.f});
+            target.draw(version);
+        }
+    }
 
-                sf::Text desc(font, upgrade.description, 16);
-                desc.setFillColor(sf::Color(180, 180, 180));
-                sf::FloatRect descb = desc.getGlobalBounds();
-                desc.setPosition({x + 100.f - descb.size.x / 2.f, y + (selected ? -15.f : 0.f) + 220.f});
-                target.draw(desc);
-            }
+private:
+    const FontManager& fonts;
+    size_t selected = 0;
+    float timer = 0;
+    mutable ParticleSystem particles{300, 21};
+    mutable EffectsRandom random{22};
+};
+
+// ============================================================================
+// WAVE COMPLETE POPUP
+// ============================================================================
+
+class WaveCompletePopup {
+public:
+    explicit WaveCompletePopup(const FontManager& fonts) : label(fonts, 36, sf::Color(100, 255, 100), true) {}
+
+    void show(int wave) { currentWave = wave; timer = 0; isActive = true; }
+
+    void update(float dt) {
+        if (!isActive) return;
+        timer += dt;
+        if (timer >= duration) isActive = false;
+    }
+
+    void draw(sf::RenderTarget& target, ShapeBatch& batch) const {
+        if (!isActive) return;
+
+        sf::Vector2f center = target.getView().getCenter();
+
+        float alpha = 1.f;
+        if (timer < 0.3f) alpha = timer / 0.3f;
+        else if (timer > duration - 0.5f) alpha = (duration - timer) / 0.5f;
+
+        batch.panel({center.x - 225.f, center.y - 45.f}, {450.f, 90.f}, sf::Color(20, 40, 60, uint8_t(230 * alpha)),
+                    3.f, sf::Color(100, 200, 100, uint8_t(255 * alpha)));
+        batch.flush(target);
+
+        if (sf::Text* text = label.get(currentWave, [this] { return "VAGUE " + std::to_string(currentWave) + " COMPLETE!"; })) {
+            text->setFillColor(sf::Color(100, 255, 100, uint8_t(255 * alpha)));
+            text->setPosition({center.x - text->getGlobalBounds().size.x / 2.f, center.y - 22.f});
+            target.draw(*text);
         }
     }
 
     bool active() const { return isActive; }
+    float getTimer() const { return timer; }
 
 private:
-    std::vector<Upgrade> choices;
-    size_t selectedIndex = 0;
+    int currentWave = 0;
+    float timer = 0, duration = 2.f;
     bool isActive = false;
+    mutable CachedText label;
 };
 
 // ============================================================================
-// HUD
+// STREAMING DES CHUNKS
 // ============================================================================
 
-class GameHUD {
+// Élément de décor, en coordonnées de sa couche de parallaxe.
+struct BackgroundElement {
+    sf::Vector2f position, size;
+    uint8_t layer;
+};
+
+// Tranche verticale du niveau : plateformes, zones d'apparition et décor.
+struct Chunk {
+    int index = 0;
+    std::vector<Platform> platforms;
+    std::vector<LevelFormat::SpawnZone> spawnZones;
+    std::vector<BackgroundElement> background;
+    uint64_t lastWanted = 0;
+
+    size_t memoryBytes() const {
+        return sizeof(Chunk) + platforms.capacity() * sizeof(Platform) +
+               spawnZones.capacity() * sizeof(LevelFormat::SpawnZone) +
+               background.capacity() * sizeof(BackgroundElement);
+    }
+};
+
+// Charge les chunks proches de la caméra sur un thread dédié, active ceux qui
+// touchent la vue et évince les plus anciens au-delà du budget mémoire.
+// Toutes les méthodes publiques sont appelées depuis le thread du jeu.
+class LevelStreamer {
 public:
-    void update(int health, int maxHealth, int soul, float flight,
-                int wave, int enemiesLeft, const PlayerStats& stats) {
-        currentHealth = health;
-        currentMaxHealth = maxHealth;
-        currentSoul = soul;
-        flightTime = flight;
-        currentWave = wave;
-        currentEnemies = enemiesLeft;
-        playerStats = stats;
-        pulseTimer += 1.f/60.f;
-                }
+    explicit LevelStreamer(size_t budgetBytes = Config::STREAMING_MEMORY_BUDGET) : budget(budgetBytes) {}
+    LevelStreamer(const LevelStreamer&) = delete;
+    LevelStreamer& operator=(const LevelStreamer&) = delete;
+    ~LevelStreamer() { close(); }
+
+    void open(const Level& lvl) {
+        close();
+        level = &lvl;
+        stopping = false;
+        worker = std::thread([this] { workerLoop(); });
+    }
 
-                void draw(sf::RenderTarget& target) const {
-                    sf::Vector2f size = target.getView().getSize();
-                    sf::Vector2f center = target.getView().getCenter();
-                    float left = center.x - size.x / 2.f;
-                    float top = center.y - size.y / 2.f;
+    void close() {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                requests.clear();
+            }
+            cv.notify_all();
+            worker.join();
+        }
+        ready.clear();
+        pending.clear();
+        resident.clear();
+        active.clear();
+        residentBytes = 0;
+        ++activeVersion;
+        level = nullptr;
+    }
 
-                    auto& font = FontManager::instance().getFont();
-                    bool hasFont = FontManager::instance().isLoaded();
+    // blocking = true : charge tout de suite ce qui manque (début de partie).
+    void update(sf::Vector2f center, sf::Vector2f viewSize, float worldTime, bool blocking = false) {
+        if (!level) return;
+        ++frame;
+        integrateReady();
 
-                    // Conteneur santé
-                    sf::RectangleShape healthBox{{260.f, 80.f}};
-                    healthBox.setPosition({left + 20.f, top + 20.f});
-                    healthBox.setFillColor(sf::Color(10, 12, 20, 220));
-                    healthBox.setOutlineThickness(2.f);
-                    healthBox.setOutlineColor(sf::Color(60, 70, 90, 200));
-                    target.draw(healthBox);
-
-                    if (hasFont) {
-                        sf::Text vieLabel(font, "VIE", 14);
-                        vieLabel.setFillColor(sf::Color(150, 150, 150));
-                        vieLabel.setPosition({left + 30.f, top + 25.f});
-                        target.draw(vieLabel);
-                    }
+        float cw = level->chunkWidth();
+        auto chunkAt = [cw](float x) { return int(std::floor(x / cw)); };
+        float left = center.x - viewSize.x / 2.f, right = center.x + viewSize.x / 2.f;
 
-                    for (int i = 0; i < currentMaxHealth; ++i) {
-                        int col = i % 6;
-                        int row = i / 6;
-                        sf::CircleShape heart(9.f);
-                        heart.setOrigin({9.f, 9.f});
-                        heart.setPosition({left + 45.f + col * 32.f, top + 55.f + row * 22.f});
+        int activeLo = std::max(0, chunkAt(left - Config::CHUNK_ACTIVE_MARGIN) - level->chunkReach());
+        int activeHi = std::min(int(level->chunkCount()) - 1, chunkAt(right + Config::CHUNK_ACTIVE_MARGIN));
 
-                        if (i < currentHealth) {
-                            float pulse = 1.f + std::sin(pulseTimer * 2.f + i * 0.5f) * 0.1f;
-                            heart.setScale({pulse, pulse});
-                            heart.setFillColor(sf::Color(220, 60, 80, 255));
-                        } else {
-                            heart.setFillColor(sf::Color(40, 30, 35, 200));
-                        }
-                        target.draw(heart);
-                    }
+        // Chunks voulus : zone active, préchargement, et décor de chaque couche de parallaxe.
+        wanted.clear();
+        for (int i = chunkAt(left - Config::CHUNK_PREFETCH_MARGIN) - level->chunkReach();
+             i <= chunkAt(right + Config::CHUNK_PREFETCH_MARGIN); ++i) {
+            if (i >= 0 && i < int(level->chunkCount())) wanted.push_back(i);
+        }
+        for (float parallax : Config::BACKGROUND_PARALLAX) {
+            float offset = left * parallax;
+            for (int i = chunkAt(offset - 400.f); i <= chunkAt(offset + viewSize.x); ++i) wanted.push_back(i);
+        }
+        std::sort(wanted.begin(), wanted.end());
+        wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
 
-                    // Barre de vol
-                    if (flightTime > 0) {
-                        sf::RectangleShape flightBg{{280.f, 22.f}};
-                        flightBg.setPosition({center.x - 140.f, top + 20.f});
-                        flightBg.setFillColor(sf::Color(15, 20, 30, 220));
-                        flightBg.setOutlineThickness(2.f);
-                        flightBg.setOutlineColor(sf::Color(80, 150, 220, 200));
-                        target.draw(flightBg);
+        for (int index : wanted) {
+            auto it = resident.find(index);
+            if (it != resident.end()) it->second->lastWanted = frame;
+            else request(index, center);
+        }
+
+        // Un chunk actif manquant est construit ici même : jamais de trou sous le joueur.
+        nextActive.clear();
+        for (int i = activeLo; i <= activeHi; ++i) {
+            auto it = resident.find(i);
+            if (it == resident.end()) it = insertResident(buildChunk(i));
+            nextActive.push_back(it->second.get());
+        }
+        if (blocking) {
+            for (int index : wanted)
+                if (!resident.count(index)) insertResident(buildChunk(index));
+        }
+
+        if (nextActive != active) {
+            for (Chunk* c : nextActive) {
+                if (std::find(active.begin(), active.end(), c) == active.end())
+                    for (auto& plat : c->platforms) plat.syncTime(worldTime);
+            }
+            active.swap(nextActive);
+            ++activeVersion;
+        }
+
+        evictOverBudget();
+    }
+
+    const std::vector<Chunk*>& getActiveChunks() const { return active; }
+    uint64_t getActiveVersion() const { return activeVersion; }
+    size_t getResidentBytes() const { return residentBytes; }
+    size_t getResidentCount() const { return resident.size(); }
+
+    template <typename Fn>
+    void forEachResident(Fn&& fn) const {
+        for (const auto& [index, chunk] : resident) fn(*chunk);
+    }
+
+private:
+    using ChunkMap = std::map<int, std::unique_ptr<Chunk>>;
+
+    void request(int index, sf::Vector2f center) {
+        if (!pending.insert(index).second) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // Les plus proches de la caméra d'abord.
+            float cx = (index + 0.5f) * level->chunkWidth();
+            if (std::abs(cx - center.x) < level->chunkWidth() * 2.f) requests.push_front(index);
+            else requests.push_back(index);
+        }
+        cv.notify_one();
+    }
+
+    void integrateReady() {
+        std::vector<std::unique_ptr<Chunk>> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(ready);
+        }
+        for (auto& chunk : done) {
+            pending.erase(chunk->index);
+            if (!resident.count(chunk->index)) insertResident(std::move(chunk));
+        }
+    }
+
+    ChunkMap::iterator insertResident(std::unique_ptr<Chunk> chunk) {
+        chunk->lastWanted = frame;
+        residentBytes += chunk->memoryBytes();
+        int index = chunk->index;
+        return resident.emplace(index, std::move(chunk)).first;
+    }
+
+    void evictOverBudget() {
+        while (residentBytes > budget) {
+            auto victim = resident.end();
+            for (auto it = resident.begin(); it != resident.end(); ++it) {
+                if (std::binary_search(wanted.begin(), wanted.end(), it->first)) continue;
+                if (victim == resident.end() || it->second->lastWanted < victim->second->lastWanted) victim = it;
+            }
+            if (victim == resident.end()) break;
+            residentBytes -= victim->second->memoryBytes();
+            resident.erase(victim);
+        }
+    }
+
+    void workerLoop() {
+        HitchTrace::nameThread("streaming");
+        for (;;) {
+            int index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stopping || !requests.empty(); });
+                if (stopping) return;
+                index = requests.front();
+                requests.pop_front();
+            }
+            std::unique_ptr<Chunk> chunk = buildChunk(index);
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.push_back(std::move(chunk));
+        }
+    }
+
+    // Lecture seule du niveau mappé : sûr depuis le thread de chargement.
+    std::unique_ptr<Chunk> buildChunk(int index) const {
+        TraceScope scope("LevelStreamer::buildChunk");
+        auto chunk = std::make_unique<Chunk>();
+        chunk->index = index;
+
+        if (index >= 0 && uint32_t(index) < level->chunkCount()) {
+            const LevelFormat::ChunkRecord& rec = level->chunks()[index];
+            chunk->platforms.reserve(rec.platformCount);
+            for (uint32_t i = 0; i < rec.platformCount; ++i) {
+                const auto& r = level->platforms()[rec.firstPlatform + i];
+                Platform& p = chunk->platforms.emplace_back(sf::Vector2f{r.w, r.h}, sf::Vector2f{r.x, r.y},
+                                                            (r.flags & LevelFormat::OneWay) != 0);
+                if (r.flags & LevelFormat::Moving)
+                    p.setMoving((r.flags & LevelFormat::MoveHorizontal) != 0, r.moveRange, r.moveSpeed);
+            }
+            chunk->spawnZones.assign(level->spawnZones() + rec.firstSpawnZone,
+                                     level->spawnZones() + rec.firstSpawnZone + rec.spawnZoneCount);
+        }
+
+        // Décor déterministe : même graine et même chunk, mêmes éléments.
+        std::mt19937 gen(level->backgroundSeed() * 2654435761u ^ uint32_t(index) * 40503u);
+        auto range = [&](float a, float b) { return std::uniform_real_distribution<float>(a, b)(gen); };
+        float x0 = index * level->chunkWidth();
+        for (int l = 0; l < 3; ++l) {
+            int count = int(std::lround((5 + l * 3) * level->chunkWidth() / 3000.f));
+            for (int i = 0; i < count; ++i) {
+                float w = range(150.f, 400.f - l * 100.f);
+                float h = range(100.f, 300.f - l * 50.f);
+                chunk->background.push_back({{x0 + range(0.f, level->chunkWidth()), 1100.f - h - range(0.f, 100.f)},
+                                             {w, h}, uint8_t(l)});
+            }
+        }
+        return chunk;
+    }
+
+    const Level* level = nullptr;
+    size_t budget;
+    size_t residentBytes = 0;
+    uint64_t frame = 0, activeVersion = 0;
+
+    ChunkMap resident;
+    std::set<int> pending;
+    // Réutilisés d'une frame à l'autre : update() n'alloue plus en régime établi.
+    std::vector<int> wanted;
+    std::vector<Chunk*> nextActive;
+    std::vector<Chunk*> active;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<int> requests;
+    std::vector<std::unique_ptr<Chunk>> ready;
+    bool stopping = false;
+};
+
+// ============================================================================
+// BACKGROUND
+// ============================================================================
+
+class Background {
+public:
+    Background() {
+        particles.gravity = -20.f;
+        particles.drag = 0.1f;
+    }
 
-                        float progress = flightTime / (Config::FLIGHT_DURATION * playerStats.flightDurationMultiplier);
-                        sf::RectangleShape flightFill{{276.f * progress, 18.f}};
-                        flightFill.setPosition({center.x - 138.f, top + 22.f});
-                        flightFill.setFillColor(sf::Color(100, 200, 255, 230));
-                        target.draw(flightFill);
-
-                        if (hasFont) {
-                            sf::Text flightLabel(font, "VOL DRAGON", 12);
-                            flightLabel.setFillColor(sf::Color::White);
-                            sf::FloatRect fb = flightLabel.getGlobalBounds();
-                            flightLabel.setPosition({center.x - fb.size.x / 2.f, top + 23.f});
-                            target.draw(flightLabel);
-                        }
-                    }
+    // Particules en coordonnées écran : elles montent sur toute la largeur de la vue.
+    void update(float dt, float viewWidth) {
+        if (random.range(0, 100) < 5.f * moteRate) {
+            particles.emit({random.range(0.f, viewWidth), 1150.f}, ParticlePreset::BackgroundMote, 1);
+        }
+        particles.update(dt);
+    }
 
-                    // Vague
-                    sf::RectangleShape waveBox{{180.f, 60.f}};
-                    waveBox.setPosition({left + size.x - 200.f, top + 20.f});
-                    waveBox.setFillColor(sf::Color(10, 12, 20, 220));
-                    waveBox.setOutlineThickness(2.f);
-                    waveBox.setOutlineColor(sf::Color(60, 70, 90, 200));
-                    target.draw(waveBox);
-
-                    if (hasFont) {
-                        sf::Text waveLabel(font, "VAGUE " + std::to_string(currentWave), 22);
-                        waveLabel.setFillColor(sf::Color(255, 220, 100));
-                        waveLabel.setStyle(sf::Text::Bold);
-                        waveLabel.setPosition({left + size.x - 185.f, top + 28.f});
-                        target.draw(waveLabel);
-
-                        sf::Text enemyLabel(font, "Ennemis: " + std::to_string(currentEnemies), 14);
-                        enemyLabel.setFillColor(sf::Color(255, 100, 100));
-                        enemyLabel.setPosition({left + size.x - 185.f, top + 55.f});
-                        target.draw(enemyLabel);
-                    }
+    // Les éléments de décor viennent des chunks résidents du streaming.
+    void draw(sf::RenderTarget& target, sf::Vector2f camOffset, const LevelStreamer& streamer, ShapeBatch& batch) const {
+        sf::Vector2f viewSize = target.getView().getSize();
+        for (int l = 0; l < 3; ++l) {
+            float parallax = Config::BACKGROUND_PARALLAX[l];
+            sf::Color color(20 + l * 10, 25 + l * 10, 40 + l * 15);
+            streamer.forEachResident([&](const Chunk& chunk) {
+                for (const auto& elem : chunk.background) {
+                    if (elem.layer != l) continue;
+                    sf::Vector2f pos = elem.position - camOffset * parallax;
+                    if (pos.x + elem.size.x < 0 || pos.x > viewSize.x) continue;
+                    batch.rect(pos, elem.size, color);
                 }
+            });
+        }
+        batch.flush(target);
+        particles.draw(target);
+    }
+
+    void setMoteRate(float rate) { moteRate = rate; }
 
 private:
-    int currentHealth = Config::MAX_HEALTH;
-    int currentMaxHealth = Config::MAX_HEALTH;
-    int currentSoul = 0;
-    float flightTime = 0;
-    int currentWave = 1;
-    int currentEnemies = 0;
-    PlayerStats playerStats;
-    mutable float pulseTimer = 0;
+    float moteRate = 1.f;
+    mutable ParticleSystem particles{500, 31};
+    EffectsRandom random{32};
 };
 
 // ============================================================================
-// CONTROLS HINT
+// CAMERA & SCREEN SHAKE
 // ============================================================================
 
-class ControlsHint {
+class Camera {
 public:
-    void draw(sf::RenderTarget& target) const {
-        sf::Vector2f size = target.getView().getSize();
-        sf::Vector2f center = target.getView().getCenter();
-        float left = center.x - size.x / 2.f;
-        float bottom = center.y + size.y / 2.f;
+    Camera(sf::Vector2f size) : viewSize(size) {
+        view.setSize(size);
+        view.setCenter(size / 2.f);
+    }
 
-        sf::RectangleShape bg{{size.x - 40.f, 40.f}};
-        bg.setPosition({left + 20.f, bottom - 55.f});
-        bg.setFillColor(sf::Color(10, 12, 20, 180));
-        bg.setOutlineThickness(1.f);
-        bg.setOutlineColor(sf::Color(50, 60, 80, 150));
-        target.draw(bg);
+    void follow(sf::Vector2f target, float dt) {
+        sf::Vector2f desired = target;
+        desired.x = std::clamp(desired.x, viewSize.x / 2.f, levelBounds.x - viewSize.x / 2.f);
+        desired.y = std::clamp(desired.y, viewSize.y / 2.f, levelBounds.y - viewSize.y / 2.f);
+        view.setCenter(Math::lerp(view.getCenter(), desired, 5.f * dt));
+    }
 
-        if (FontManager::instance().isLoaded()) {
-            auto& font = FontManager::instance().getFont();
-            sf::Text controls(font, "[Fleches/WASD] Deplacer   [Espace] Sauter   [V] Attaquer   [Shift] Dash   [Y-H-P] Dragon   [Echap] Pause", 14);
-            controls.setFillColor(sf::Color(150, 150, 150));
-            sf::FloatRect cb = controls.getGlobalBounds();
-            controls.setPosition({center.x - cb.size.x / 2.f, bottom - 48.f});
-            target.draw(controls);
-        }
+    void applyShake(sf::Vector2f offset) { view.setCenter(view.getCenter() + offset); }
+    void setLevelBounds(sf::Vector2f bounds) { levelBounds = bounds; }
+    sf::View& getView() { return view; }
+    sf::Vector2f getCenter() const { return view.getCenter(); }
+
+private:
+    sf::View view;
+    sf::Vector2f viewSize;
+    sf::Vector2f levelBounds{3000.f, 1200.f};
+};
+
+class ScreenShake {
+public:
+    void shake(float intensity, float dur) {
+        this->intensity = std::max(this->intensity, intensity);
+        duration = std::max(duration, dur);
+        timer = 0;
+    }
+
+    sf::Vector2f update(float dt) {
+        if (duration <= 0) return {0, 0};
+        timer += dt;
+        if (timer >= duration) { duration = intensity = 0; return {0, 0}; }
+        return random.insideCircle(intensity * (1.f - timer / duration));
     }
+
+private:
+    float intensity = 0, duration = 0, timer = 0;
+    EffectsRandom random{41};
 };
 
 // ============================================================================
-// PAUSE MENU (CENTRÉ)
+// MONDE (SIMULATION DE LA PARTIE)
 // ============================================================================
 
-class PauseMenu {
-public:
-    enum class Result { None, Resume, MainMenu, Quit };
+// État complet de la simulation, de taille fixe : capturer et restaurer ne
+// font que copier des records, sans allocation. Le niveau n'en fait pas
+// partie : un instantané se restaure sur le niveau où il a été pris.
+struct WorldSnapshot {
+    static constexpr uint32_t MAGIC = 0x53575753; // "SWWS" en little-endian
+    static constexpr uint16_t VERSION = 5;
+    static constexpr size_t MAX_ENEMIES = 256;
+    static constexpr size_t MAX_PROJECTILES = Config::MAX_PROJECTILES;
+    // Les ennemis n'ont pas de plafond : leur table de slots ne grandit que
+    // jusqu'au pic d'ennemis vivants, très loin en dessous.
+    static constexpr uint32_t MAX_ENEMY_SLOTS = 1u << 16;
+
+    std::array<Player::Snapshot, Config::MAX_PLAYERS> players;
+    WaveManager::Snapshot waves;
+    float worldTime;
+    std::mt19937 rng;
+    uint32_t aiCursor = 0;
+    uint32_t playerCount = 0, enemyCount = 0, projectileCount = 0;
+    uint32_t enemyGeneration = 1, projectileGeneration = 1; // prochaines générations des slot maps
+    std::array<Enemy::Snapshot, MAX_ENEMIES> enemies;
+    std::array<Projectile::Snapshot, MAX_PROJECTILES> projectiles;
+    std::array<SlotHandle, MAX_ENEMIES> enemyHandles;
+    std::array<SlotHandle, MAX_PROJECTILES> projectileHandles;
+
+    // Sauvegarde compacte : en-tête puis uniquement les records utilisés.
+    // Le format suit la mise en mémoire de cette build (même exécutable).
+    bool save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        auto put = [&](const void* src, size_t n) { out.write(static_cast<const char*>(src), std::streamsize(n)); };
+        uint32_t header[3] = {MAGIC, VERSION, uint32_t(sizeof(WorldSnapshot))};
+        put(header, sizeof(header));
+        put(&playerCount, sizeof(playerCount));
+        put(players.data(), playerCount * sizeof(Player::Snapshot));
+        put(&waves, sizeof(waves));
+        put(&worldTime, sizeof(worldTime));
+        put(&rng, sizeof(rng));
+        put(&aiCursor, sizeof(aiCursor));
+        put(&enemyCount, sizeof(enemyCount));
+        put(&projectileCount, sizeof(projectileCount));
+        put(&enemyGeneration, sizeof(enemyGeneration));
+        put(&projectileGeneration, sizeof(projectileGeneration));
+        put(enemies.data(), enemyCount * sizeof(Enemy::Snapshot));
+        put(projectiles.data(), projectileCount * sizeof(Projectile::Snapshot));
+        put(enemyHandles.data(), enemyCount * sizeof(SlotHandle));
+        put(projectileHandles.data(), projectileCount * sizeof(SlotHandle));
+        return bool(out);
+    }
 
-    Result update(const InputManager& input) {
-        if (input.justPressed("down")) selected = (selected + 1) % 3;
-        if (input.justPressed("up")) selected = (selected + 2) % 3;
+    bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        auto get = [&](void* dst, size_t n) { return bool(in.read(static_cast<char*>(dst), std::streamsize(n))); };
+        uint32_t header[3];
+        if (!get(header, sizeof(header)) || header[0] != MAGIC || header[1] != VERSION ||
+            header[2] != sizeof(WorldSnapshot))
+            return false;
+        if (!get(&playerCount, sizeof(playerCount)) || playerCount == 0 || playerCount > Config::MAX_PLAYERS ||
+            !get(players.data(), playerCount * sizeof(Player::Snapshot)) || !get(&waves, sizeof(waves)) || !get(&worldTime, sizeof(worldTime)) ||
+            !get(&rng, sizeof(rng)) || !get(&aiCursor, sizeof(aiCursor)) || !get(&enemyCount, sizeof(enemyCount)) ||
+            !get(&projectileCount, sizeof(projectileCount)) || !get(&enemyGeneration, sizeof(enemyGeneration)) ||
+            !get(&projectileGeneration, sizeof(projectileGeneration)))
+            return false;
+        if (enemyCount > MAX_ENEMIES || projectileCount > MAX_PROJECTILES ||
+            waves.queuedCount > WaveManager::MAX_QUEUED)
+            return false;
+        return get(enemies.data(), enemyCount * sizeof(Enemy::Snapshot)) &&
+               get(projectiles.data(), projectileCount * sizeof(Projectile::Snapshot)) &&
+               get(enemyHandles.data(), enemyCount * sizeof(SlotHandle)) &&
+               get(projectileHandles.data(), projectileCount * sizeof(SlotHandle)) &&
+               validRecords() &&
+               validHandles(enemyHandles.data(), enemyCount, MAX_ENEMY_SLOTS, enemyGeneration) &&
+               validHandles(projectileHandles.data(), projectileCount, uint32_t(MAX_PROJECTILES), projectileGeneration);
+    }
 
-        if (input.justPressed("pause")) return Result::Resume;
+private:
+    // Énumérés et tailles lus du disque, vérifiés avant d'atteindre les switch
+    // et les tableaux de la simulation.
+    bool validRecords() const {
+        for (size_t i = 0; i < playerCount; ++i)
+            if (size_t(players[i].state) >= Player::STATE_COUNT) return false;
+        for (size_t i = 0; i < enemyCount; ++i)
+            if (size_t(enemies[i].type) >= Enemy::TYPE_COUNT || size_t(enemies[i].moveState) >= Enemy::STATE_COUNT)
+                return false;
+        for (size_t i = 0; i < projectileCount; ++i)
+            if (projectiles[i].trailCount > Projectile::MAX_TRAIL) return false;
+        for (size_t i = 0; i < waves.queuedCount; ++i)
+            if (size_t(waves.queued[i]) >= Enemy::TYPE_COUNT) return false;
+        return size_t(waves.waiting) < WaveManager::WAIT_COUNT;
+    }
 
-        if (input.justPressed("confirm")) {
-            if (selected == 0) return Result::Resume;
-            if (selected == 1) return Result::MainMenu;
-            if (selected == 2) return Result::Quit;
+    // Handles lus du disque : indices distincts et bornés, générations déjà
+    // attribuées (de 1 à nextGeneration - 1). Sinon SlotMap::restore
+    // construirait une table de slots corrompue ou démesurée.
+    static bool validHandles(const SlotHandle* handles, size_t count, uint32_t maxIndex, uint32_t nextGeneration) {
+        std::array<uint32_t, std::max(MAX_ENEMIES, MAX_PROJECTILES)> indices;
+        for (size_t i = 0; i < count; ++i) {
+            const SlotHandle& h = handles[i];
+            if (h.index >= maxIndex || h.generation == 0 || h.generation >= nextGeneration) return false;
+            indices[i] = h.index;
         }
+        auto end = indices.begin() + std::ptrdiff_t(count);
+        std::sort(indices.begin(), end);
+        return std::adjacent_find(indices.begin(), end) == end;
+    }
+};
 
-        return Result::None;
+class World {
+public:
+    World() : level(Level::builtin()) {
+        players.reserve(Config::MAX_PLAYERS);
+        projectiles.setCapacity(Config::MAX_PROJECTILES);
+        players.emplace_back(level.startPosition());
+        buildFromLevel();
+        effects.gravity = 300.f;
+        effects.drag = 1.f;
     }
 
-    void draw(sf::RenderTarget& target) const {
-        sf::Vector2f size = target.getView().getSize();
-        sf::Vector2f center = target.getView().getCenter();
-        float left = center.x - size.x / 2.f;
-        float top = center.y - size.y / 2.f;
+    void loadLevel(Level newLevel) {
+        streamer.close();
+        level = std::move(newLevel);
+        buildFromLevel();
+    }
 
-        sf::RectangleShape overlay;
-        overlay.setSize(size);
-        overlay.setPosition({left, top});
-        overlay.setFillColor(sf::Color(0, 0, 0, 180));
-        target.draw(overlay);
+    // Coopération : le second joueur apparaît à côté du premier.
+    void setPlayerCount(size_t count) {
+        count = std::clamp<size_t>(count, 1, Config::MAX_PLAYERS);
+        while (players.size() > count) players.pop_back();
+        while (players.size() < count) {
+            Player& p = players.emplace_back(spawnPosition(players.size()));
+            p.setTint(sf::Color(255, 200, 150, 230));
+            p.setTelemetry(telemetry, uint8_t(players.size() - 1));
+        }
+    }
 
-        sf::RectangleShape panel{{380.f, 320.f}};
-        panel.setPosition({center.x - 190.f, center.y - 160.f});
-        panel.setFillColor(sf::Color(15, 20, 35, 250));
-        panel.setOutlineThickness(3.f);
-        panel.setOutlineColor(sf::Color(100, 150, 200, 200));
-        target.draw(panel);
+    // Graine commune aux pairs d'une partie en réseau.
+    void seed(unsigned int s) { rng.seed(s); }
 
-        auto& font = FontManager::instance().getFont();
-        bool hasFont = FontManager::instance().isLoaded();
+    // Vagues enchaînées sans écran d'améliorations (coopération en réseau).
+    void setAutoAdvanceWaves(bool enabled) { autoAdvanceWaves = enabled; }
 
-        if (hasFont) {
-            sf::Text title(font, "PAUSE", 42);
-            title.setFillColor(sf::Color(150, 200, 255));
-            title.setStyle(sf::Text::Bold);
-            sf::FloatRect tb = title.getGlobalBounds();
-            title.setPosition({center.x - tb.size.x / 2.f, center.y - 140.f});
-            target.draw(title);
-        }
+    void reset() {
+        worldTime = 0;
+        for (size_t i = 0; i < players.size(); ++i) players[i].fullReset(spawnPosition(i));
+        enemies.clear();
+        projectiles.clear();
+        aiCursor = 0;
+        prewarmWave(1);
+        waveManager.startWave(1);
+        // Les chunks autour du départ sont chargés avant la première frame.
+        stream(true);
+    }
 
-        std::vector<std::string> options = {"Reprendre", "Menu Principal", "Quitter"};
+    // false si le monde dépasse la capacité de l'instantané (rien n'est écrit alors).
+    bool capture(WorldSnapshot& snap) const {
+        if (enemies.size() > WorldSnapshot::MAX_ENEMIES || projectiles.size() > WorldSnapshot::MAX_PROJECTILES)
+            return false;
+        snap.playerCount = uint32_t(players.size());
+        for (size_t i = 0; i < players.size(); ++i) snap.players[i] = players[i].snapshot();
+        snap.waves = waveManager.snapshot();
+        snap.worldTime = worldTime;
+        snap.rng = rng.getEngine();
+        snap.aiCursor = aiCursor;
+        snap.enemyCount = uint32_t(enemies.size());
+        snap.enemyGeneration = enemies.getNextGeneration();
+        for (size_t i = 0; i < enemies.size(); ++i) {
+            snap.enemies[i] = enemies[i].snapshot();
+            snap.enemyHandles[i] = enemies.handleAt(i);
+        }
+        snap.projectileCount = uint32_t(projectiles.size());
+        snap.projectileGeneration = projectiles.getNextGeneration();
+        for (size_t i = 0; i < projectiles.size(); ++i) {
+            snap.projectiles[i] = projectiles[i].snapshot();
+            snap.projectileHandles[i] = projectiles.handleAt(i);
+        }
+        return true;
+    }
 
-        for (size_t i = 0; i < options.size(); ++i) {
-            float btnY = center.y - 50.f + i * 65.f;
+    // Réutilise les ennemis et projectiles existants ; n'alloue que s'il en manque.
+    // Les handles pris avant la capture restent valides après.
+    void restore(const WorldSnapshot& snap) {
+        setPlayerCount(snap.playerCount);
+        for (size_t i = 0; i < players.size(); ++i) players[i].restore(snap.players[i]);
+        waveManager.restore(snap.waves);
+        worldTime = snap.worldTime;
+        aiCursor = snap.aiCursor;
+
+        // Recréer un ennemi manquant consomme des tirages : le générateur est restauré après.
+        enemies.restore(snap.enemyHandles.data(), snap.enemyCount, snap.enemyGeneration, [this, &snap](size_t i) {
+            return Enemy(snap.enemies[i].position, snap.enemies[i].type, 0, rng);
+        });
+        for (uint32_t i = 0; i < snap.enemyCount; ++i) enemies[i].restore(snap.enemies[i]);
+        rng.setEngine(snap.rng);
+
+        projectiles.restore(snap.projectileHandles.data(), snap.projectileCount, snap.projectileGeneration, [&snap](size_t i) {
+            return Projectile(snap.projectiles[i].position, {1.f, 0.f}, 0.f, snap.projectiles[i].baseColor);
+        });
+        for (uint32_t i = 0; i < snap.projectileCount; ++i) projectiles[i].restore(snap.projectiles[i]);
+
+        effects.clear();
+        stream(true);
+        for (Chunk* chunk : streamer.getActiveChunks())
+            for (auto& plat : chunk->platforms) plat.syncTime(worldTime);
+    }
 
-            sf::RectangleShape btn{{280.f, 50.f}};
-            btn.setPosition({center.x - 140.f, btnY});
+    // Un tick de simulation. Déterministe : mêmes entrées et même état donnent
+    // le même résultat, condition du netcode rollback.
+    void update(float dt, const PlayerInputs& inputs) {
+        TraceScope trace("World::update");
+        AllocScope allocScope(AllocTracking::Scope::Simulation);
+        worldTime += dt;
+        stream(false);
+        for (Chunk* chunk : streamer.getActiveChunks())
+            for (auto& plat : chunk->platforms) plat.update(dt, worldTime);
+
+        for (size_t i = 0; i < players.size(); ++i) {
+            players[i].handleInput(inputs[i], dt);
+            players[i].update(dt, activePlatforms, bounds);
+        }
 
-            if (i == selected) {
-                btn.setFillColor(sf::Color(60, 80, 120, 240));
-                btn.setOutlineThickness(2.f);
-                btn.setOutlineColor(sf::Color(150, 200, 255, 255));
-            } else {
-                btn.setFillColor(sf::Color(40, 50, 70, 200));
-                btn.setOutlineThickness(1.f);
-                btn.setOutlineColor(sf::Color(80, 100, 130, 150));
+        AllocScope projectileScope(AllocTracking::Scope::Projectiles);
+        for (auto& proj : projectiles) {
+            proj.update(dt, bounds);
+            for (auto& player : players) {
+                if (proj.isActive() && proj.getBounds().findIntersection(player.getCollisionBounds())) {
+                    player.takeDamage(int(proj.getDamage()));
+                    proj.deactivate();
+                    screenShake.shake(10.f, 0.2f);
+                }
             }
-            target.draw(btn);
+        }
+        projectiles.eraseIf([](const Projectile& p) { return !p.isActive(); });
 
-            if (hasFont) {
-                sf::Text opt(font, options[i], 22);
-                opt.setFillColor(sf::Color::White);
-                sf::FloatRect ob = opt.getGlobalBounds();
-                opt.setPosition({center.x - ob.size.x / 2.f, btnY + 12.f});
-                target.draw(opt);
-            }
+        AllocScope enemyScope(AllocTracking::Scope::Enemies);
+        waveManager.update(dt, enemies, players.front().getPosition());
+        if (effectScale < 1.f) { // nouveaux venus (vagues, coop, restauration) au palier courant
+            for (auto& player : players) player.setEffectScale(effectScale);
+            for (auto& enemy : enemies) enemy.setEffectScale(effectScale);
         }
-    }
 
-    void reset() { selected = 0; }
+        updateEnemies(dt);
+
+        for (size_t e = 0; e < enemies.size(); ++e) {
+            Enemy& enemy = enemies[e];
+            for (auto& player : players) {
+                if (player.getIsAttacking() && enemy.isAlive() &&
+                    player.getAttackBounds().findIntersection(enemy.getBounds())) {
+                    enemy.takeDamage(player.getAttackDamage());
+                    screenShake.shake(6.f, 0.1f);
+                    player.addSoul(10);
+                    if (!enemy.isAlive()) {
+                        waveManager.enemyKilled();
+                        player.addSoul(20);
+                        if (telemetry)
+                            telemetry->record(TelemetryLog::EventType::EnemyKill, uint8_t(enemy.getType()),
+                                              int16_t(&player - players.data()), waveManager.getCurrentWave(),
+                                              enemy.getPosition(), enemies.handleAt(e).generation);
+                    }
+                }
 
-private:
-    size_t selected = 0;
-};
+                if (enemy.isAlive() && player.getCollisionBounds().findIntersection(enemy.getBounds())) {
+                    player.takeDamage(enemy.getDamage());
+                    screenShake.shake(12.f, 0.25f);
+                }
+            }
+        }
 
-// ============================================================================
-// MENU PRINCIPAL (CENTRÉ DYNAMIQUEMENT)
-// ============================================================================
+        enemies.eraseIf([](const Enemy& e) { return !e.isAlive(); });
 
-class MainMenu {
-public:
-    enum class Result { None, Play, Quit };
+        if (autoAdvanceWaves && waveManager.isWaveComplete()) {
+            prewarmWave(waveManager.getCurrentWave() + 1);
+            waveManager.startWave(waveManager.getCurrentWave() + 1);
+            for (auto& player : players) player.heal(1);
+        }
 
-    MainMenu() {
-        particles.gravity = -15.f;
-        particles.drag = 0.2f;
+        AllocScope particleScope(AllocTracking::Scope::Particles);
+        effects.update(dt);
     }
 
-    Result update(float dt, const InputManager& input) {
-        timer += dt;
+    // Les formes temporaires passent par les lots de la frame, un draw par couche.
+    void draw(sf::RenderTarget& target, FrameBatches& batches) const {
+        TraceScope trace("World::draw");
+        const sf::RenderStates additive(sf::BlendAdd);
+        platformMesh.draw(target, activePlatforms, activeVersion);
 
-        if (input.justPressed("down") || input.justPressed("up")) {
-            selected = (selected + 1) % 2;
+        if (batches.quality.projectileTrails) {
+            for (const auto& proj : projectiles) proj.drawTrail(batches.scratch);
+            batches.scratch.flush(target);
+        }
+        for (const auto& proj : projectiles) proj.draw(batches.scratch);
+        batches.scratch.flush(target);
+        if (batches.quality.projectileGlow) {
+            for (const auto& proj : projectiles) proj.drawGlow(batches.glow);
+            batches.glow.flush(target, additive);
         }
 
-        if (input.justPressed("confirm")) {
-            if (selected == 0) return Result::Play;
-            if (selected == 1) return Result::Quit;
+        for (const auto& enemy : enemies) enemy.drawGlow(batches.glow);
+        batches.glow.flush(target, additive);
+        for (const auto& enemy : enemies) enemy.draw(target, batches);
+        batches.overlay.flush(target);
+
+        for (const auto& player : players) player.draw(target, batches);
+        batches.overlay.flush(target);
+        AllocScope particleScope(AllocTracking::Scope::Particles);
+        effects.draw(target);
+    }
+
+    // Empreinte de l'état simulé, comparée entre pairs pour détecter une désynchronisation.
+    uint32_t checksum() const {
+        uint32_t h = 2166136261u;
+        auto mix = [&h](const void* data, size_t n) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < n; ++i) { h ^= bytes[i]; h *= 16777619u; }
+        };
+        auto mixValue = [&mix](auto v) { mix(&v, sizeof(v)); };
+        mixValue(worldTime);
+        mixValue(waveManager.getCurrentWave());
+        mixValue(waveManager.getEnemiesRemaining());
+        for (const auto& player : players) {
+            mixValue(player.getPosition().x);
+            mixValue(player.getPosition().y);
+            mixValue(player.getHealth());
+        }
+        for (const auto& enemy : enemies) {
+            mixValue(enemy.getPosition().x);
+            mixValue(enemy.getPosition().y);
         }
+        for (const auto& proj : projectiles) {
+            mixValue(proj.getBounds().position.x);
+            mixValue(proj.getBounds().position.y);
+        }
+        return h;
+    }
 
-        return Result::None;
+    bool allPlayersDead() const {
+        return std::all_of(players.begin(), players.end(),
+                           [](const Player& p) { return p.getState() == Player::State::Dead; });
     }
 
-    void draw(sf::RenderTarget& target) {
-        // Obtenir les dimensions réelles de l'écran
-        sf::Vector2f viewSize = target.getView().getSize();
-        sf::Vector2f viewCenter = target.getView().getCenter();
+    // Points d'entrée directs, utilisés par les scénarios de stress.
+    SlotHandle spawnEnemy(sf::Vector2f pos, Enemy::Type type) {
+        SlotHandle handle = enemies.respawn(pos, type, waveManager.getCurrentWave(), rng);
+        if (telemetry)
+            telemetry->record(TelemetryLog::EventType::EnemySpawn, uint8_t(type), 0, waveManager.getCurrentWave(), pos, handle.generation);
+        return handle;
+    }
 
-        float left = viewCenter.x - viewSize.x / 2.f;
-        float top = viewCenter.y - viewSize.y / 2.f;
-        float centerX = viewCenter.x;
-        float centerY = viewCenter.y;
-        float width = viewSize.x;
-        float height = viewSize.y;
+    SlotHandle spawnProjectile(sf::Vector2f pos, sf::Vector2f dir, float speed, sf::Color color) {
+        return projectiles.respawn(pos, dir, speed, color);
+    }
 
-        // Background plein écran
-        sf::RectangleShape bg;
-        bg.setSize(viewSize);
-        bg.setPosition({left, top});
-        bg.setFillColor(sf::Color(8, 10, 20));
-        target.draw(bg);
+    // Ennemis et projectiles dormants pour la vague à venir : ses apparitions
+    // recyclent leurs formes et leurs particules au lieu d'allouer en jeu, et
+    // les listes de l'IA ont déjà la place pour tous.
+    void prewarmWave(int wave) {
+        AllocScope scope(AllocTracking::Scope::Enemies);
+        enemies.prewarm(size_t(WaveManager::waveSizeFor(wave)));
+        projectiles.prewarm(Config::PREWARM_PROJECTILES);
+        size_t peak = enemies.size() + enemies.getSpareCount();
+        for (auto& bucket : enemyBuckets) bucket.reserve(peak);
+        farEnemies.reserve(peak);
+    }
 
-        // Particules
-        if (Random::instance().range(0, 100) < 8) {
-            ParticleConfig cfg;
-            cfg.startColor = sf::Color(80, 130, 200, 120);
-            cfg.endColor = sf::Color(50, 80, 150, 0);
-            cfg.minSpeed = 15.f; cfg.maxSpeed = 40.f;
-            cfg.direction = -1.57f; cfg.spread = 0.4f;
-            cfg.minLife = 4.f; cfg.maxLife = 7.f;
-            particles.emit({left + Random::instance().range(0.f, width), top + height + 20.f}, cfg, 1);
-        }
-        particles.update(1.f/60.f);
-        particles.draw(target);
+    // nullptr une fois l'entité retirée : à garder plutôt qu'un pointeur d'une frame à l'autre.
+    Enemy* findEnemy(SlotHandle h) { return enemies.get(h); }
+    const Enemy* findEnemy(SlotHandle h) const { return enemies.get(h); }
+    Projectile* findProjectile(SlotHandle h) { return projectiles.get(h); }
+    const Projectile* findProjectile(SlotHandle h) const { return projectiles.get(h); }
 
-        // Logo centré
-        float pulse = std::sin(timer * 2.f) * 0.1f + 1.f;
+    void emitEffect(sf::Vector2f pos, const ParticleConfig& cfg, int count) { effects.emit(pos, cfg, count); }
 
-        sf::CircleShape logoGlow(130.f);
-        logoGlow.setOrigin({130.f, 130.f});
-        logoGlow.setPosition({centerX, centerY - 150.f});
-        logoGlow.setFillColor(sf::Color(80, 150, 255, 40));
-        logoGlow.setScale({pulse, pulse});
-        target.draw(logoGlow, sf::RenderStates(sf::BlendAdd));
+    // Journal d'événements (nullptr : aucun). En rollback, la session n'y garde que les frames confirmées.
+    void setTelemetry(TelemetryLog* log) {
+        telemetry = log;
+        waveManager.setTelemetry(log);
+        for (size_t i = 0; i < players.size(); ++i) players[i].setTelemetry(log, uint8_t(i));
+    }
+    TelemetryLog* getTelemetry() const { return telemetry; }
+
+    // Palier de qualité : part des particules émises par tout le monde simulé.
+    void setEffectScale(float scale) {
+        effectScale = scale;
+        effects.emissionScale = scale;
+        for (auto& player : players) player.setEffectScale(scale);
+        for (auto& enemy : enemies) enemy.setEffectScale(scale);
+    }
 
-        sf::CircleShape logo(100.f);
-        logo.setOrigin({100.f, 100.f});
-        logo.setPosition({centerX, centerY - 150.f});
-        logo.setFillColor(sf::Color(100, 180, 255, 220));
-        logo.setOutlineThickness(5.f);
-        logo.setOutlineColor(sf::Color(150, 200, 255, 255));
-        target.draw(logo);
+    Player& getPlayer(size_t index = 0) { return players[index]; }
+    const Player& getPlayer(size_t index = 0) const { return players[index]; }
+    size_t getPlayerCount() const { return players.size(); }
+    WaveManager& getWaveManager() { return waveManager; }
+    const WaveManager& getWaveManager() const { return waveManager; }
+    ScreenShake& getScreenShake() { return screenShake; }
+    size_t getEnemyCount() const { return enemies.size(); }
+    size_t getProjectileCount() const { return projectiles.size(); }
+    size_t getThinksLastTick() const { return thinksLastTick; }
+    const FlowField& getFlowField() const { return flowField; }
+    size_t getPlatformCount() const { return activePlatforms.size(); }
+    const Level& getLevel() const { return level; }
+    const LevelBounds& getBounds() const { return bounds; }
+    const LevelStreamer& getStreamer() const { return streamer; }
 
-        auto& font = FontManager::instance().getFont();
-        bool hasFont = FontManager::instance().isLoaded();
+private:
+    void buildFromLevel() {
+        bounds = level.bounds();
+        flowField.build(level);
+        activePlatforms.clear();
+        activeVersion = ~0ull;
+        // Les chunks actifs ne contiennent jamais plus que le niveau entier.
+        size_t movingPlatforms = size_t(std::count_if(level.platforms(), level.platforms() + level.platformCount(),
+            [](const LevelFormat::PlatformRecord& r) { return (r.flags & LevelFormat::Moving) != 0; }));
+        activePlatforms.reserve(level.platformCount());
+        activeSpawnZones.reserve(level.spawnZoneCount());
+        platformMesh.reserve(level.platformCount() - movingPlatforms, movingPlatforms);
+        waveManager.setSpawnZones(level.spawnZones(), level.spawnZoneCount());
+        streamer.open(level);
+    }
 
-        if (hasFont) {
-            // Titre centré
-            sf::Text title(font, "SOUL WORLD", 72);
-            title.setFillColor(sf::Color(150, 200, 255));
-            title.setStyle(sf::Text::Bold);
-            sf::FloatRect titleBounds = title.getGlobalBounds();
-            title.setPosition({centerX - titleBounds.size.x / 2.f, centerY - 20.f});
-            target.draw(title);
+    sf::Vector2f spawnPosition(size_t index) const {
+        return level.startPosition() + sf::Vector2f{60.f * float(index), 0.f};
+    }
 
-            // Sous-titre
-            sf::Text subtitle(font, "Infinite Waves", 28);
-            subtitle.setFillColor(sf::Color(200, 180, 100));
-            sf::FloatRect subBounds = subtitle.getGlobalBounds();
-            subtitle.setPosition({centerX - subBounds.size.x / 2.f, centerY + 60.f});
-            target.draw(subtitle);
+    // Ennemis rangés par (type, état), puis chaque seau passe dans son noyau
+    // spécialisé ; seules les étapes communes restent dans l'ordre dense.
+    void updateEnemies(float dt) {
+        TraceScope trace("World::updateEnemies");
+        scheduleThinking();
+        for (auto& bucket : enemyBuckets) bucket.clear();
+        for (auto& enemy : enemies) {
+            if (!enemy.isAlive()) continue;
+            enemy.beginUpdate(dt, rng);
+            if (enemy.needsMove()) enemyBuckets[enemy.bucket()].push_back(&enemy);
         }
+        moveBuckets(std::make_index_sequence<Enemy::BUCKET_COUNT>{});
+        for (auto& enemy : enemies)
+            if (enemy.isAlive()) enemy.finishUpdate(dt, activePlatforms, bounds);
+    }
 
-        // Boutons centrés
-        std::vector<std::string> options = {"JOUER", "QUITTER"};
-        float buttonY = centerY + 140.f;
+    template <size_t... I>
+    void moveBuckets(std::index_sequence<I...>) {
+        (Enemy::moveBucket<Enemy::Type(I / Enemy::STATE_COUNT), Enemy::MovementState(I % Enemy::STATE_COUNT)>(
+             enemyBuckets[I], projectiles), ...);
+    }
 
-        for (size_t i = 0; i < options.size(); ++i) {
-            float btnX = centerX - 140.f;
-            float btnY = buttonY + i * 75.f;
+    // Niveau de détail de l'IA : près d'un joueur, chaque ennemi réfléchit à
+    // chaque tick. Plus loin, un budget fixe de réflexions par tick tourne sur
+    // les ennemis éloignés ; le coût de l'IA ne croît plus avec leur nombre.
+    // Le curseur fait partie de l'instantané (rollback déterministe).
+    void scheduleThinking() {
+        updateFlowField();
+        farEnemies.clear();
+        thinksLastTick = 0;
+        for (auto& enemy : enemies) {
+            if (!enemy.isAlive()) continue;
+            sf::Vector2f target = targetFor(enemy.getPosition());
+            bool near = Math::distance(enemy.getPosition(), target) < Config::AI_FULL_RATE_RADIUS;
+            enemy.plan(target, headingFor(enemy.getPosition(), target), near);
+            if (near) ++thinksLastTick;
+            else farEnemies.push_back(&enemy);
+        }
+        if (farEnemies.empty()) return;
+
+        size_t budget = std::min(farEnemies.size(), Config::AI_FAR_THINKS_PER_TICK);
+        size_t start = aiCursor % farEnemies.size();
+        for (size_t i = 0; i < budget; ++i) {
+            Enemy* e = farEnemies[(start + i) % farEnemies.size()];
+            sf::Vector2f target = targetFor(e->getPosition());
+            e->plan(target, headingFor(e->getPosition(), target), true);
+        }
+        thinksLastTick += budget;
+        aiCursor = uint32_t((start + budget) % farEnemies.size());
+    }
 
-            sf::RectangleShape btn{{280.f, 55.f}};
-            btn.setPosition({btnX, btnY});
+    // Le champ vise les mêmes joueurs que targetFor() : les vivants, ou tous.
+    void updateFlowField() {
+        std::array<sf::Vector2f, Config::MAX_PLAYERS> targets;
+        size_t count = 0;
+        for (const auto& player : players)
+            if (player.getState() != Player::State::Dead) targets[count++] = player.getPosition();
+        if (count == 0)
+            for (const auto& player : players) targets[count++] = player.getPosition();
+        flowField.update(targets.data(), count);
+    }
 
-            if (i == selected) {
-                btn.setFillColor(sf::Color(60, 80, 120, 240));
-                btn.setOutlineThickness(3.f);
-                btn.setOutlineColor(sf::Color(150, 200, 255, 255));
+    // Cap du champ de flux ; tout droit dans la cellule du joueur ou hors de portée.
+    sf::Vector2f headingFor(sf::Vector2f pos, sf::Vector2f target) const {
+        sf::Vector2f dir = flowField.direction(pos);
+        return dir != sf::Vector2f{0, 0} ? dir : Math::normalize(target - pos);
+    }
 
-                sf::CircleShape arrow(12.f, 3);
-                arrow.setOrigin({12.f, 12.f});
-                arrow.setRotation(sf::degrees(90.f));
-                arrow.setPosition({btnX - 30.f, btnY + 27.f});
-                arrow.setFillColor(sf::Color(150, 200, 255, 255));
-                target.draw(arrow);
-            } else {
-                btn.setFillColor(sf::Color(40, 50, 70, 200));
-                btn.setOutlineThickness(2.f);
-                btn.setOutlineColor(sf::Color(80, 100, 130, 150));
-            }
-            target.draw(btn);
+    // Les ennemis visent le joueur vivant le plus proche.
+    sf::Vector2f targetFor(sf::Vector2f pos) const {
+        const Player* best = &players.front();
+        for (const auto& player : players) {
+            bool bestDead = best->getState() == Player::State::Dead;
+            bool dead = player.getState() == Player::State::Dead;
+            if ((bestDead && !dead) ||
+                (bestDead == dead && Math::distance(pos, player.getPosition()) < Math::distance(pos, best->getPosition())))
+                best = &player;
+        }
+        return best->getPosition();
+    }
 
-            if (hasFont) {
-                sf::Text opt(font, options[i], 28);
-                opt.setFillColor(sf::Color::White);
-                opt.setStyle(sf::Text::Bold);
-                sf::FloatRect optBounds = opt.getGlobalBounds();
-                opt.setPosition({centerX - optBounds.size.x / 2.f, btnY + 10.f});
-                target.draw(opt);
-            }
+    // Chunks actifs autour des joueurs (et non de la caméra) : l'ensemble des
+    // plateformes en collision ne dépend que de l'état simulé.
+    void stream(bool blocking) {
+        sf::Vector2f lo = players.front().getPosition(), hi = lo;
+        for (const auto& player : players) {
+            lo = {std::min(lo.x, player.getPosition().x), std::min(lo.y, player.getPosition().y)};
+            hi = {std::max(hi.x, player.getPosition().x), std::max(hi.y, player.getPosition().y)};
         }
+        streamer.update((lo + hi) / 2.f, viewSize + (hi - lo), worldTime, blocking);
+        refreshActive();
+    }
 
-        // Instructions en bas
-        if (hasFont) {
-            sf::Text hint(font, "Fleches + Entree pour naviguer", 18);
-            hint.setFillColor(sf::Color(120, 120, 120));
-            sf::FloatRect hintBounds = hint.getGlobalBounds();
-            hint.setPosition({centerX - hintBounds.size.x / 2.f, top + height - 80.f});
-            target.draw(hint);
+    // Reconstruit la liste des plateformes (et zones d'apparition) des chunks actifs.
+    void refreshActive() {
+        if (streamer.getActiveVersion() == activeVersion) return;
+        activeVersion = streamer.getActiveVersion();
 
-            sf::Text version(font, "v1.0 - F11 plein ecran", 14);
-            version.setFillColor(sf::Color(80, 80, 80));
-            sf::FloatRect verBounds = version.getGlobalBounds();
-            version.setPosition({centerX - verBounds.size.x / 2.f, top + height - 45.f});
-            target.draw(version);
+        activePlatforms.clear();
+        activeSpawnZones.clear();
+        for (const Chunk* chunk : streamer.getActiveChunks()) {
+            for (const auto& plat : chunk->platforms) activePlatforms.push_back(&plat);
+            activeSpawnZones.insert(activeSpawnZones.end(), chunk->spawnZones.begin(), chunk->spawnZones.end());
         }
+        // Sans zone active, on garde celles du niveau entier.
+        if (!activeSpawnZones.empty())
+            waveManager.setSpawnZones(activeSpawnZones.data(), activeSpawnZones.size());
+        else
+            waveManager.setSpawnZones(level.spawnZones(), level.spawnZoneCount());
     }
 
-private:
-    size_t selected = 0;
-    float timer = 0;
-    mutable ParticleSystem particles{300};
+    Level level;
+    LevelBounds bounds;
+    std::vector<Player> players;
+    LevelStreamer streamer;
+    PlatformList activePlatforms;
+    std::vector<LevelFormat::SpawnZone> activeSpawnZones;
+    uint64_t activeVersion = ~0ull;
+    float worldTime = 0;
+    sf::Vector2f viewSize{float(Config::WINDOW_WIDTH), float(Config::WINDOW_HEIGHT)};
+    SlotMap<Enemy> enemies;
+    std::array<std::vector<Enemy*>, Enemy::BUCKET_COUNT> enemyBuckets; // refaits à chaque tick, pointeurs valides le temps du tick
+    std::vector<Enemy*> farEnemies;
+    FlowField flowField;
+    uint32_t aiCursor = 0;
+    size_t thinksLastTick = 0;
+    SlotMap<Projectile> projectiles;
+    Random rng; // simulation : avant waveManager, qui tire dedans
+    WaveManager waveManager{rng};
+    ScreenShake screenShake;
+    mutable ParticleSystem effects{4000, 13, 4}; // emitEffect() accepte des dégradés ad hoc
+    mutable PlatformMesh platformMesh;
+    bool autoAdvanceWaves = false;
+    float effectScale = 1.f;
+    TelemetryLog* telemetry = nullptr;
 };
 
 // ============================================================================
-// WAVE COMPLETE POPUP
+// NETCODE (ROLLBACK)
 // ============================================================================
 
-class WaveCompletePopup {
+// Canal de datagrammes non fiable et non bloquant vers un seul pair.
+class Transport {
 public:
-    void show(int wave) { currentWave = wave; timer = 0; isActive = true; }
+    virtual ~Transport() = default;
+    virtual void send(const void* data, size_t size) = 0;
+    // Taille du datagramme reçu, ou std::nullopt si rien n'attend.
+    virtual std::optional<size_t> receive(void* data, size_t capacity) = 0;
+};
 
-    void update(float dt) {
-        if (!isActive) return;
-        timer += dt;
-        if (timer >= duration) isActive = false;
+class UdpTransport : public Transport {
+public:
+    static std::unique_ptr<UdpTransport> open(unsigned short localPort, const std::string& host, unsigned short remotePort) {
+        std::optional<sf::IpAddress> address = sf::IpAddress::resolve(host);
+        if (!address) {
+            std::cerr << "Hote introuvable: " << host << std::endl;
+            return nullptr;
+        }
+        std::unique_ptr<UdpTransport> transport(new UdpTransport(*address, remotePort));
+        if (transport->socket.bind(localPort) != sf::Socket::Status::Done) {
+            std::cerr << "Port UDP indisponible: " << localPort << std::endl;
+            return nullptr;
+        }
+        transport->socket.setBlocking(false);
+        return transport;
     }
 
-    void draw(sf::RenderTarget& target) const {
-        if (!isActive) return;
+    void send(const void* data, size_t size) override { (void)socket.send(data, size, remote, remotePort); }
 
-        sf::Vector2f center = target.getView().getCenter();
+    std::optional<size_t> receive(void* data, size_t capacity) override {
+        for (;;) {
+            size_t received = 0;
+            std::optional<sf::IpAddress> sender;
+            unsigned short port = 0;
+            if (socket.receive(data, capacity, received, sender, port) != sf::Socket::Status::Done) return std::nullopt;
+            if (sender && *sender == remote && port == remotePort) return received;
+        }
+    }
 
-        float alpha = 1.f;
-        if (timer < 0.3f) alpha = timer / 0.3f;
-        else if (timer > duration - 0.5f) alpha = (duration - timer) / 0.5f;
+private:
+    UdpTransport(sf::IpAddress address, unsigned short port) : remote(address), remotePort(port) {}
 
-        sf::RectangleShape banner{{450.f, 90.f}};
-        banner.setPosition({center.x - 225.f, center.y - 45.f});
-        banner.setFillColor(sf::Color(20, 40, 60, uint8_t(230 * alpha)));
-        banner.setOutlineThickness(3.f);
-        banner.setOutlineColor(sf::Color(100, 200, 100, uint8_t(255 * alpha)));
-        target.draw(banner);
+    sf::UdpSocket socket;
+    sf::IpAddress remote;
+    unsigned short remotePort;
+};
 
-        if (FontManager::instance().isLoaded()) {
-            auto& font = FontManager::instance().getFont();
-            sf::Text text(font, "VAGUE " + std::to_string(currentWave) + " COMPLETE!", 36);
-            text.setFillColor(sf::Color(100, 255, 100, uint8_t(255 * alpha)));
-            text.setStyle(sf::Text::Bold);
-            sf::FloatRect tb = text.getGlobalBounds();
-            text.setPosition({center.x - tb.size.x / 2.f, center.y - 22.f});
-            target.draw(text);
-        }
-    }
+// Liaison en mémoire entre deux extrémités, avec latence, gigue et pertes
+// simulées (en ticks) : remplace le réseau pour tester le rollback en local.
+class LoopbackLink {
+public:
+    struct Settings {
+        int latencyTicks = 4;
+        int jitterTicks = 2;
+        int lossPercent = 0;
+    };
 
-    bool active() const { return isActive; }
+    explicit LoopbackLink(Settings s, unsigned int seed = 1)
+    : settings(s), gen(seed), ends{Endpoint(*this, 0), Endpoint(*this, 1)} {}
+
+    LoopbackLink(const LoopbackLink&) = delete;
+    LoopbackLink& operator=(const LoopbackLink&) = delete;
+
+    Transport& endpoint(int side) { return ends[side]; }
+
+    // Une fois par tick de simulation : fait avancer l'horloge de livraison.
+    void advance() { ++tick; }
 
 private:
-    int currentWave = 0;
-    float timer = 0, duration = 2.f;
-    bool isActive = false;
-};
+    static constexpr size_t MAX_DATAGRAM = 256;
 
-// ============================================================================
-// BACKGROUND
-// ============================================================================
+    struct Datagram {
+        uint64_t deliverAt;
+        size_t size;
+        std::array<uint8_t, MAX_DATAGRAM> bytes;
+    };
 
-class Background {
-public:
-    Background() {
-        for (int l = 0; l < 3; ++l) {
-            float parallax = 0.1f + l * 0.2f;
-            sf::Color color(20 + l * 10, 25 + l * 10, 40 + l * 15);
+    class Endpoint : public Transport {
+    public:
+        Endpoint(LoopbackLink& link, int side) : link(link), side(side) {}
+
+        void send(const void* data, size_t size) override {
+            if (size > MAX_DATAGRAM) return;
+            std::uniform_int_distribution<int> percent(0, 99), jitter(0, link.settings.jitterTicks);
+            if (percent(link.gen) < link.settings.lossPercent) return;
+            Datagram d{link.tick + uint64_t(link.settings.latencyTicks + jitter(link.gen)), size, {}};
+            std::memcpy(d.bytes.data(), data, size);
+            link.queues[1 - side].push_back(d);
+        }
 
-            for (int i = 0; i < 5 + l * 3; ++i) {
-                sf::RectangleShape elem;
-                float w = Random::instance().range(150.f, 400.f - l * 100.f);
-                float h = Random::instance().range(100.f, 300.f - l * 50.f);
-                elem.setSize({w, h});
-                elem.setPosition({Random::instance().range(-100.f, 3100.f), 1100.f - h - Random::instance().range(0.f, 100.f)});
-                elem.setFillColor(color);
-                layers.push_back({elem, parallax});
+        // Premier datagramme arrivé à échéance : la gigue peut réordonner.
+        std::optional<size_t> receive(void* data, size_t capacity) override {
+            auto& queue = link.queues[side];
+            for (auto it = queue.begin(); it != queue.end(); ++it) {
+                if (it->deliverAt > link.tick) continue;
+                size_t size = std::min(it->size, capacity);
+                std::memcpy(data, it->bytes.data(), size);
+                queue.erase(it);
+                return size;
             }
+            return std::nullopt;
         }
 
-        particles.gravity = -20.f;
-        particles.drag = 0.1f;
+    private:
+        LoopbackLink& link;
+        int side;
+    };
+
+    Settings settings;
+    std::mt19937 gen;
+    uint64_t tick = 0;
+    std::deque<Datagram> queues[2];
+    Endpoint ends[2];
+};
+
+namespace NetFormat {
+    constexpr uint32_t MAGIC = 0x4E575753; // "SWWN" en little-endian
+    constexpr int MAX_INPUTS = 32;
+
+    // Chaque paquet répète les inputs locaux non confirmés : une perte ou un
+    // désordre se rattrape au paquet suivant, sans retransmission.
+    struct InputPacket {
+        uint32_t magic;
+        int32_t firstFrame;      // frame du premier input de inputs[]
+        int32_t ackFrame;        // dernier input du destinataire reçu sans trou
+        int32_t checksumFrame;   // -1 : pas d'empreinte
+        uint32_t checksum;
+        uint16_t count;
+        uint16_t inputs[MAX_INPUTS];
+    };
+
+    static_assert(std::is_trivially_copyable_v<InputPacket>);
+}
+
+// Rollback façon GGPO pour deux joueurs : l'input distant est prédit (dernier
+// reçu), et quand le vrai diffère on restaure l'instantané de la frame fautive
+// puis on rejoue jusqu'à la frame courante. L'input local est appliqué avec
+// un léger délai pour réduire les rollbacks.
+class RollbackSession {
+public:
+    RollbackSession(World& world, Transport& transport, size_t localPlayer)
+    : world(world), transport(transport), local(localPlayer), remote(1 - localPlayer),
+      snapshots(Config::ROLLBACK_WINDOW + 2) {
+        checksumFrames.fill(-1);
     }
 
-    void update(float dt) {
-        if (Random::instance().range(0, 100) < 5) {
-            ParticleConfig cfg;
-            cfg.startColor = sf::Color(100, 120, 180, 100);
-            cfg.endColor = sf::Color(80, 100, 150, 0);
-            cfg.minSpeed = 10.f; cfg.maxSpeed = 30.f;
-            cfg.direction = -1.57f; cfg.spread = 0.5f;
-            cfg.minLife = 3.f; cfg.maxLife = 6.f;
-            cfg.minSize = 2.f; cfg.maxSize = 4.f;
-            particles.emit({Random::instance().range(0.f, 3000.f), 1150.f}, cfg, 1);
+    // Un tick. false : trop d'avance sur le pair, on l'attend (rien n'est simulé).
+    bool advance(uint16_t localBits) {
+        poll();
+        if (rollbackFrom >= 0) rollback();
+        checkRemoteChecksum();
+        confirmTelemetry();
+
+        if (frame - (remoteConfirmed + 1) >= Config::ROLLBACK_WINDOW) {
+            sendInputs();
+            return false;
         }
-        particles.update(dt);
+
+        localLatest = frame + Config::NETPLAY_INPUT_DELAY;
+        localInputs[localLatest % HISTORY] = localBits;
+        simulate(frame);
+        ++frame;
+        sendInputs();
+        return true;
+    }
+
+    int getFrame() const { return frame; }
+    int getPredictedFrames() const { return std::max(0, frame - 1 - remoteConfirmed); }
+    int getLastRollbackDepth() const { return lastRollbackDepth; }
+    uint64_t getResimulatedTicks() const { return resimulatedTicks; }
+    bool isDesynced() const { return desynced; }
+    // Dernière frame dont l'empreinte a été comparée à celle du pair et trouvée égale.
+    int getVerifiedFrame() const { return verifiedFrame; }
+
+private:
+    static constexpr int HISTORY = 128;
+    static_assert(HISTORY > Config::ROLLBACK_WINDOW + Config::NETPLAY_INPUT_DELAY + NetFormat::MAX_INPUTS);
+
+    uint16_t localValue(int f) const { return f < 0 ? 0 : localInputs[f % HISTORY]; }
+
+    uint16_t remoteValue(int f) const {
+        if (f < 0) return 0;
+        if (f <= remoteConfirmed) return remoteInputs[f % HISTORY];
+        return remoteConfirmed >= 0 ? remoteInputs[remoteConfirmed % HISTORY] : 0;
     }
 
-    void draw(sf::RenderTarget& target, sf::Vector2f camOffset) const {
-        for (const auto& [elem, parallax] : layers) {
-            sf::RectangleShape drawShape = elem;
-            drawShape.setPosition(elem.getPosition() - camOffset * parallax);
-            target.draw(drawShape);
+    void poll() {
+        NetFormat::InputPacket packet;
+        while (std::optional<size_t> size = transport.receive(&packet, sizeof(packet))) {
+            if (*size < offsetof(NetFormat::InputPacket, inputs) || packet.magic != NetFormat::MAGIC ||
+                packet.count > NetFormat::MAX_INPUTS)
+                continue;
+
+            for (int k = 0; k < packet.count; ++k) {
+                int f = packet.firstFrame + k;
+                if (f <= remoteConfirmed) continue;
+                if (f != remoteConfirmed + 1) break; // trou : le prochain paquet le comblera
+                remoteInputs[f % HISTORY] = packet.inputs[k];
+                remoteConfirmed = f;
+                if (f < frame && usedRemote[f % HISTORY] != packet.inputs[k])
+                    rollbackFrom = rollbackFrom < 0 ? f : std::min(rollbackFrom, f);
+            }
+            remoteAck = std::max(remoteAck, int(packet.ackFrame));
+            if (packet.checksumFrame > remoteChecksumFrame) {
+                remoteChecksumFrame = packet.checksumFrame;
+                remoteChecksum = packet.checksum;
+            }
         }
-        particles.draw(target);
     }
 
-private:
-    std::vector<std::pair<sf::RectangleShape, float>> layers;
-    mutable ParticleSystem particles{500};
-};
+    void rollback() {
+        int from = rollbackFrom;
+        rollbackFrom = -1;
+        world.restore(snapshots[from % snapshots.size()]);
+        // Les événements des frames rejouées remplacent ceux de la prédiction.
+        if (TelemetryLog* telemetry = world.getTelemetry()) telemetry->discardFrom(from);
+        for (int f = from; f < frame; ++f) simulate(f);
+        lastRollbackDepth = frame - from;
+        resimulatedTicks += uint64_t(frame - from);
+    }
 
-// ============================================================================
-// CAMERA & SCREEN SHAKE
-// ============================================================================
+    // Sauve l'état avant f, puis simule f avec les inputs connus ou prédits.
+    void simulate(int f) {
+        world.capture(snapshots[f % snapshots.size()]);
+
+        PlayerInputs inputs{};
+        inputs[local] = {localValue(f), localValue(f - 1)};
+        inputs[remote] = {remoteValue(f), remoteValue(f - 1)};
+        usedRemote[f % HISTORY] = inputs[remote].held;
+        TelemetryLog* telemetry = world.getTelemetry();
+        if (telemetry) telemetry->beginSpeculative(f);
+        world.update(Config::FIXED_DT, inputs);
+        if (telemetry) telemetry->endSpeculative();
+
+        checksums[f % HISTORY] = world.checksum();
+        checksumFrames[f % HISTORY] = f;
+    }
 
-class Camera {
-public:
-    Camera(sf::Vector2f size) : viewSize(size) {
-        view.setSize(size);
-        view.setCenter(size / 2.f);
+    void sendInputs() {
+        NetFormat::InputPacket packet{};
+        packet.magic = NetFormat::MAGIC;
+        packet.firstFrame = std::max(remoteAck + 1, localLatest - NetFormat::MAX_INPUTS + 1);
+        packet.count = uint16_t(std::max(0, localLatest - packet.firstFrame + 1));
+        for (int k = 0; k < packet.count; ++k) packet.inputs[k] = localValue(packet.firstFrame + k);
+        packet.ackFrame = remoteConfirmed;
+
+        // Dernière frame simulée avec des inputs tous confirmés : son état est définitif.
+        int settled = std::min(remoteConfirmed, frame - 1);
+        packet.checksumFrame = settled >= 0 && checksumFrames[settled % HISTORY] == settled ? settled : -1;
+        packet.checksum = packet.checksumFrame >= 0 ? checksums[settled % HISTORY] : 0;
+
+        transport.send(&packet, offsetof(NetFormat::InputPacket, inputs) + packet.count * sizeof(uint16_t));
     }
 
-    void follow(sf::Vector2f target, float dt) {
-        sf::Vector2f desired = target;
-        desired.x = std::clamp(desired.x, viewSize.x / 2.f, levelBounds.x - viewSize.x / 2.f);
-        desired.y = std::clamp(desired.y, viewSize.y / 2.f, levelBounds.y - viewSize.y / 2.f);
-        view.setCenter(Math::lerp(view.getCenter(), desired, 5.f * dt));
+    // Après le rollback, les frames aux inputs tous confirmés sont définitives :
+    // leurs événements peuvent partir au journal.
+    void confirmTelemetry() {
+        if (TelemetryLog* telemetry = world.getTelemetry()) telemetry->confirmThrough(std::min(remoteConfirmed, frame - 1));
     }
 
-    void applyShake(sf::Vector2f offset) { view.setCenter(view.getCenter() + offset); }
-    void setLevelBounds(sf::Vector2f bounds) { levelBounds = bounds; }
-    sf::View& getView() { return view; }
-    sf::Vector2f getCenter() const { return view.getCenter(); }
+    // Après le rollback : nos empreintes doivent refléter les inputs confirmés.
+    void checkRemoteChecksum() {
+        int f = remoteChecksumFrame;
+        if (f < 0 || desynced || f > remoteConfirmed || f >= frame || checksumFrames[f % HISTORY] != f) return;
+        if (checksums[f % HISTORY] != remoteChecksum) {
+            desynced = true;
+            std::cerr << "Desynchronisation detectee a la frame " << f << std::endl;
+        } else {
+            verifiedFrame = std::max(verifiedFrame, f);
+        }
+    }
 
-private:
-    sf::View view;
-    sf::Vector2f viewSize;
-    sf::Vector2f levelBounds{3000.f, 1200.f};
+    World& world;
+    Transport& transport;
+    size_t local, remote;
+
+    int frame = 0;
+    int localLatest = Config::NETPLAY_INPUT_DELAY - 1;
+    int remoteConfirmed = -1;
+    int remoteAck = -1;
+    int rollbackFrom = -1;
+    int remoteChecksumFrame = -1;
+    uint32_t remoteChecksum = 0;
+
+    std::array<uint16_t, HISTORY> localInputs{}, remoteInputs{}, usedRemote{};
+    std::array<uint32_t, HISTORY> checksums{};
+    std::array<int, HISTORY> checksumFrames;
+    std::vector<WorldSnapshot> snapshots; // état avant la frame f en [f % taille]
+
+    int lastRollbackDepth = 0;
+    uint64_t resimulatedTicks = 0;
+    int verifiedFrame = -1;
+    bool desynced = false;
 };
 
-class ScreenShake {
+// Pair simulé dans le même processus : son propre monde, sa propre session
+// et un bot qui joue le second joueur. Sert à tester le netcode sans réseau.
+class LoopbackPeer {
 public:
-    void shake(float intensity, float dur) {
-        this->intensity = std::max(this->intensity, intensity);
-        duration = std::max(duration, dur);
-        timer = 0;
+    LoopbackPeer(Level level, Transport& transport) : session(world, transport, 1) {
+        world.loadLevel(std::move(level));
+        world.seed(Config::NETPLAY_SEED);
+        world.setPlayerCount(2);
+        world.setAutoAdvanceWaves(true);
+        world.reset();
     }
 
-    sf::Vector2f update(float dt) {
-        if (duration <= 0) return {0, 0};
-        timer += dt;
-        if (timer >= duration) { duration = intensity = 0; return {0, 0}; }
-        return Random::instance().insideCircle(intensity * (1.f - timer / duration));
-    }
+    bool advance() { return session.advance(botInput()); }
+    const RollbackSession& getSession() const { return session; }
 
 private:
-    float intensity = 0, duration = 0, timer = 0;
+    // Suit le premier joueur, saute quand il est plus haut, attaque en rythme.
+    uint16_t botInput() const {
+        const Player& self = world.getPlayer(1);
+        const Player& leader = world.getPlayer(0);
+        int f = session.getFrame();
+        uint16_t bits = 0;
+        float dx = leader.getPosition().x - self.getPosition().x;
+        if (dx > 120.f) bits |= PlayerInput::Right;
+        else if (dx < -120.f) bits |= PlayerInput::Left;
+        if (leader.getPosition().y < self.getPosition().y - 80.f && f % 40 < 10) bits |= PlayerInput::Jump;
+        if (f % 24 < 2) bits |= PlayerInput::Attack;
+        return bits;
+    }
+
+    World world;
+    RollbackSession session;
 };
 
 // ============================================================================
 // GAME
 // ============================================================================
 
-enum class GameState { MainMenu, Playing, Paused, Upgrading, GameOver };
+enum class GameState { Loading, MainMenu, Playing, Paused, Upgrading, GameOver };
 
 class Game {
 public:
-    Game() : window(sf::VideoMode({Config::WINDOW_WIDTH, Config::WINDOW_HEIGHT}),
-                    "Soul World", sf::Style::Default, sf::State::Fullscreen),
-                    camera({float(Config::WINDOW_WIDTH), float(Config::WINDOW_HEIGHT)}),
-                    player({200.f, 900.f}) {
-                        window.setFramerateLimit(60);
-                        FontManager::instance().loadFont();
-                        camera.setLevelBounds({3000.f, 1200.f});
-                        createLevel();
+    // openWindow = false : aucune fenêtre, le rendu passe par render(target) (benchmarks hors écran).
+    // packPath : paquet de ressources ; absent, la police est cherchée dans les dossiers système.
+    explicit Game(bool openWindow = true, const std::string& packPath = Config::ASSET_PACK_PATH)
+    : camera({float(Config::WINDOW_WIDTH), float(Config::WINDOW_HEIGHT)}) {
+                        if (openWindow) {
+                            window.create(sf::VideoMode({Config::WINDOW_WIDTH, Config::WINDOW_HEIGHT}),
+                                          "Soul World", sf::Style::Default, sf::State::Fullscreen);
+                            applyFrameLimit();
+                            render(); // écran de chargement, avant toute lecture disque
+                        }
+                        pack = AssetPack::open(packPath);
+                        if (pack) fontAsset = pack->find("fonts/main.ttf");
+                        pendingFont = loader.submit([asset = fontAsset] {
+                            return asset ? FontManager::findFont(asset->data, asset->size) : FontManager::findFont();
+                        });
+                        pendingAtlas = loader.submit([packPath] {
+                            return SpriteAtlas::loadOrBake(SpriteAtlas::cacheDirectory(packPath));
+                        });
+                        applyLevel();
+                    }
+
+                    bool loadLevel(const std::string& path) {
+                        std::optional<Level> level = Level::load(path);
+                        if (!level) return false;
+                        world.loadLevel(std::move(*level));
+                        applyLevel();
+                        return true;
+                    }
+
+                    // required = false : un niveau introuvable laisse le niveau embarqué.
+                    void loadLevelAsync(const std::string& path, bool required) {
+                        levelPath = path;
+                        levelRequired = required;
+                        pendingLevel = loader.submit([path] { return Level::load(path); });
+                    }
+
+                    // Niveau lu en place dans le paquet ; false s'il n'y figure pas.
+                    bool loadPackedLevelAsync(const std::string& name) {
+                        std::optional<AssetPack::Asset> asset = pack ? pack->find(name) : std::nullopt;
+                        if (!asset) return false;
+                        levelPath = name;
+                        levelRequired = true;
+                        pendingLevel = loader.submit([asset = *asset] {
+                            return Level::fromMemory(asset.data, asset.size, asset.owner);
+                        });
+                        return true;
+                    }
+
+                    // Bloque jusqu'à la fin des chargements en cours (début de partie, benchmarks).
+                    void finishLoading() {
+                        if (pendingFont.valid()) pendingFont.wait();
+                        if (pendingLevel.valid()) pendingLevel.wait();
+                        if (pendingAtlas.valid()) pendingAtlas.wait();
+                        pollAssets();
                     }
 
-                    void createLevel() {
-                        platforms.clear();
-                        platforms.emplace_back(sf::Vector2f{2800.f, 50.f}, sf::Vector2f{100.f, 1050.f});
-                        platforms.emplace_back(sf::Vector2f{250.f, 25.f}, sf::Vector2f{300.f, 850.f}, true);
-                        platforms.emplace_back(sf::Vector2f{300.f, 25.f}, sf::Vector2f{650.f, 700.f}, true);
-                        platforms.emplace_back(sf::Vector2f{200.f, 25.f}, sf::Vector2f{1050.f, 600.f}, true);
-                        platforms.emplace_back(sf::Vector2f{350.f, 25.f}, sf::Vector2f{1400.f, 750.f}, true);
-                        platforms.emplace_back(sf::Vector2f{200.f, 25.f}, sf::Vector2f{1850.f, 550.f}, true);
-                        platforms.emplace_back(sf::Vector2f{300.f, 25.f}, sf::Vector2f{2200.f, 680.f}, true);
-                        platforms.emplace_back(sf::Vector2f{50.f, 400.f}, sf::Vector2f{50.f, 700.f});
-                        platforms.emplace_back(sf::Vector2f{50.f, 400.f}, sf::Vector2f{2900.f, 700.f});
-
-                        Platform& m1 = platforms.emplace_back(sf::Vector2f{150.f, 25.f}, sf::Vector2f{500.f, 500.f}, true);
-                        m1.setMoving(true, 150.f, 1.5f);
-                        Platform& m2 = platforms.emplace_back(sf::Vector2f{150.f, 25.f}, sf::Vector2f{1200.f, 450.f}, true);
-                        m2.setMoving(false, 100.f, 2.f);
-                        Platform& m3 = platforms.emplace_back(sf::Vector2f{200.f, 25.f}, sf::Vector2f{2000.f, 400.f}, true);
-                        m3.setMoving(true, 200.f, 1.f);
+                    bool hasLoadError() const { return loadError; }
+
+                    void applyLevel() {
+                        const LevelBounds& bounds = world.getBounds();
+                        camera.setLevelBounds({bounds.width, bounds.height});
                     }
 
                     void startNewGame() {
-                        player.fullReset({200.f, 900.f});
-                        enemies.clear();
-                        projectiles.clear();
-                        waveManager.startWave(1);
+                        finishLoading();
+                        if (netplay) startNetplay();
+                        world.reset();
+                        takeCheckpoint();
                         state = GameState::Playing;
                     }
 
+                    // Coopération en rollback avec un pair simulé dans le processus.
+                    void enableLoopback(LoopbackLink::Settings settings) {
+                        netplay = true;
+                        loopbackSettings = settings;
+                    }
+
+                    // Coopération en rollback en UDP ; localPlayer : 0 ou 1, l'inverse chez le pair.
+                    bool enableUdp(unsigned short localPort, const std::string& host, unsigned short remotePort, size_t localPlayer) {
+                        udp = UdpTransport::open(localPort, host, remotePort);
+                        if (!udp) return false;
+                        netplay = true;
+                        this->localPlayer = localPlayer;
+                        return true;
+                    }
+
                     void run() {
-                        sf::Clock clock;
+                        sf::Clock clock, work;
+                        int64_t frameStart = HitchTrace::now();
                         while (window.isOpen()) {
                             float dt = std::min(clock.restart().asSeconds(), 1.f/30.f);
+                            work.restart();
+                            AllocTracking::beginFrame();
                             handleEvents();
                             update(dt);
-                            render();
+                            sf::Clock renderClock;
+                            render(window);
+                            AllocTracking::endFrame();
+                            // Travail de la frame seulement : l'attente de la limite de 60 fps n'en fait pas partie.
+                            sampleFrameTime(work.getElapsedTime().asSeconds() * 1000.f);
+                            {
+                                TraceScope trace("display");
+                                window.display();
+                            }
+                            // En rendu logiciel (llvmpipe), le remplissage des pixels se paie à
+                            // l'échange des tampons : la mesure s'arrête après display().
+                            sampleRenderTime(renderClock.getElapsedTime().asSeconds() * 1000.f);
+                            if (dynamicResolution) paceFrame();
+                            // Frame vue par le joueur, attente comprise : c'est elle qui saccade.
+                            int64_t frameEnd = HitchTrace::now();
+                            if (hitchCapture) hitchCapture->endFrame(frameStart, frameEnd);
+                            frameStart = frameEnd;
                         }
+                        if (AllocTracking::ENABLED) AllocTracking::report(std::cerr);
+                    }
+
+                    // Alimente le régulateur de qualité ; applique le palier s'il change.
+                    void sampleFrameTime(float frameMs) {
+                        if (quality.sample(frameMs)) applyQuality();
+                        if (telemetry) telemetry->record(TelemetryLog::EventType::FrameTime, uint8_t(quality.getLevel()), 0, 0, {frameMs, 0.f});
+                    }
+
+                    // Résolution interne du monde ajustée au temps de rendu (rendu logiciel).
+                    void enableDynamicResolution() {
+                        dynamicResolution = true;
+                        resolution.reset();
+                        applyFrameLimit();
+                    }
+
+                    void sampleRenderTime(float renderMs) {
+                        if (dynamicResolution) resolution.sample(renderMs);
+                    }
+
+                    // Journal binaire des événements de jeu (soulworld_teldump pour le relire).
+                    bool enableTelemetry(const std::string& path) {
+                        telemetry = TelemetryLog::open(path);
+                        if (!telemetry) return false;
+                        world.setTelemetry(telemetry.get());
+                        upgradeSystem.setTelemetry(telemetry.get());
+                        return true;
+                    }
+
+                    const TelemetryLog* getTelemetry() const { return telemetry.get(); }
+
+                    // Trace Chrome des frames qui dépassent le seuil (hitch_<n>.json).
+                    void enableHitchCapture(const HitchCapture::Settings& settings) {
+                        hitchCapture = std::make_unique<HitchCapture>(settings);
+                    }
+
+                    void applyQuality() {
+                        const QualityLevel& q = quality.current();
+                        world.setEffectScale(q.particleScale);
+                        background.setMoteRate(q.backgroundMoteRate);
                     }
 
                     void handleEvents() {
@@ -2037,6 +6278,8 @@ public:
                                 if (key->code == sf::Keyboard::Key::F11) toggleFullscreen();
                             }
                         }
+                        TraceScope trace("Game::handleEvents");
+                        AllocScope scope(AllocTracking::Scope::Input);
                         input.update();
                     }
 
@@ -2049,11 +6292,34 @@ public:
                             window.create(sf::VideoMode({1280, 720}),
                                           "Soul World", sf::Style::Default, sf::State::Windowed);
                         }
-                        window.setFramerateLimit(60);
+                        applyFrameLimit();
+                    }
+
+                    // Avec la résolution dynamique, le rendu est chronométré jusqu'à
+                    // display() compris ; la limite de 60 fps de SFML dort dans display(),
+                    // elle est donc remplacée par paceFrame(), appelé après la mesure.
+                    void applyFrameLimit() {
+                        if (window.isOpen()) window.setFramerateLimit(dynamicResolution ? 0 : 60);
+                    }
+
+                    void paceFrame() {
+                        float remaining = Config::FRAME_BUDGET_MS / 1000.f - paceClock.getElapsedTime().asSeconds();
+                        if (remaining > 0) sf::sleep(sf::seconds(remaining));
+                        paceClock.restart();
                     }
 
                     void update(float dt) {
+                        TraceScope trace("Game::update");
+                        pollAssets();
+                        AllocScope scope(state == GameState::Playing ? AllocTracking::Scope::Simulation : AllocTracking::Scope::Menus);
+
                         switch (state) {
+                            case GameState::Loading: {
+                                // Le menu n'attend que sa police ; le niveau peut finir après.
+                                if (!pendingFont.valid()) state = GameState::MainMenu;
+                                break;
+                            }
+
                             case GameState::MainMenu: {
                                 auto result = mainMenu.update(dt, input);
                                 if (result == MainMenu::Result::Play) startNewGame();
@@ -2068,60 +6334,36 @@ public:
                                     break;
                                 }
 
-                                for (auto& plat : platforms) plat.update(dt);
-                                player.handleInput(input, dt);
-                                player.update(dt, platforms);
-
-                                for (auto& proj : projectiles) {
-                                    proj.update(dt);
-                                    if (proj.isActive() && proj.getBounds().findIntersection(player.getCollisionBounds())) {
-                                        player.takeDamage(int(proj.getDamage()));
-                                        proj.deactivate();
-                                        screenShake.shake(10.f, 0.2f);
-                                    }
-                                }
-                                projectiles.erase(std::remove_if(projectiles.begin(), projectiles.end(),
-                                                                 [](const Projectile& p) { return !p.isActive(); }), projectiles.end());
-
-                                waveManager.update(dt, enemies, player.getPosition());
-
-                                for (auto& enemy : enemies) {
-                                    enemy->update(dt, player.getPosition(), projectiles, platforms);
-
-                                    if (player.getIsAttacking() && enemy->isAlive() &&
-                                        player.getAttackBounds().findIntersection(enemy->getBounds())) {
-                                        enemy->takeDamage(player.getAttackDamage());
-                                    screenShake.shake(6.f, 0.1f);
-                                    player.addSoul(10);
-                                    if (!enemy->isAlive()) { waveManager.enemyKilled(); player.addSoul(20); }
-                                        }
-
-                                        if (enemy->isAlive() && player.getCollisionBounds().findIntersection(enemy->getBounds())) {
-                                            player.takeDamage(enemy->getDamage());
-                                            screenShake.shake(12.f, 0.25f);
-                                        }
+                                if (session) {
+                                    stepNetplay(dt);
+                                } else {
+                                    if (input.justPressed("quicksave")) quickSave();
+                                    if (input.justPressed("quickload")) quickLoad();
+                                    world.update(dt, PlayerInputs{PlayerInput::from(input)});
                                 }
 
-                                enemies.erase(std::remove_if(enemies.begin(), enemies.end(),
-                                                             [](const std::unique_ptr<Enemy>& e) { return !e->isAlive(); }), enemies.end());
+                                Player& player = world.getPlayer(localPlayer);
+                                WaveManager& waveManager = world.getWaveManager();
 
                                 if (waveManager.isWaveComplete()) {
                                     wavePopup.show(waveManager.getCurrentWave());
                                     upgradeSystem.generateChoices();
+                                    world.prewarmWave(waveManager.getCurrentWave() + 1);
                                     state = GameState::Upgrading;
                                 }
 
                                 wavePopup.update(dt);
                                 camera.follow(player.getPosition(), dt);
-                                camera.applyShake(screenShake.update(dt));
-                                background.update(dt);
+                                camera.applyShake(world.getScreenShake().update(dt));
+                                background.update(dt, camera.getView().getSize().x);
 
+                                AllocScope hudScope(AllocTracking::Scope::Hud);
                                 hud.update(player.getHealth(), player.getStats().maxHealth,
                                            player.getSoulEnergy(), player.getFlightTimer(),
                                            waveManager.getCurrentWave(), waveManager.getEnemiesRemaining(),
                                            player.getStats());
 
-                                if (player.getState() == Player::State::Dead) {
+                                if (world.allPlayersDead()) {
                                     state = GameState::GameOver;
                                     gameOverTimer = 0;
                                 }
@@ -2140,9 +6382,10 @@ public:
                                 wavePopup.update(dt);
                                 int choice = upgradeSystem.update(input);
                                 if (choice >= 0) {
-                                    upgradeSystem.applyUpgrade(choice, player.getStats());
-                                    player.heal(1);
-                                    waveManager.startWave(waveManager.getCurrentWave() + 1);
+                                    upgradeSystem.applyUpgrade(choice, world.getPlayer().getStats());
+                                    world.getPlayer().heal(1);
+                                    world.getWaveManager().startWave(world.getWaveManager().getCurrentWave() + 1);
+                                    takeCheckpoint();
                                     state = GameState::Playing;
                                 }
                                 break;
@@ -2150,7 +6393,12 @@ public:
 
                             case GameState::GameOver: {
                                 gameOverTimer += dt;
-                                if (input.justPressed("confirm") && gameOverTimer > 1.f) startNewGame();
+                                // En réseau, rejouer exigerait l'accord du pair : retour au menu seulement.
+                                if (input.justPressed("confirm") && gameOverTimer > 1.f && !session) startNewGame();
+                                if (input.justPressed("retry") && gameOverTimer > 1.f && hasCheckpoint && !session) {
+                                    world.restore(*checkpoint);
+                                    state = GameState::Playing;
+                                }
                                 if (input.justPressed("back")) state = GameState::MainMenu;
                                 break;
                             }
@@ -2158,41 +6406,183 @@ public:
                     }
 
                     void render() {
-                        window.clear(sf::Color(5, 8, 15));
+                        render(window);
+                        window.display();
+                    }
 
-                        if (state == GameState::MainMenu) {
-                            window.setView(window.getDefaultView());
-                            mainMenu.draw(window);
-                        } else {
-                            window.setView(camera.getView());
-
-                            sf::View defView = window.getDefaultView();
-                            window.setView(defView);
-                            background.draw(window, camera.getCenter() - sf::Vector2f{
-                                defView.getSize().x / 2.f, defView.getSize().y / 2.f});
-                            window.setView(camera.getView());
-
-                            for (const auto& plat : platforms) plat.draw(window);
-                            for (const auto& proj : projectiles) proj.draw(window);
-                            for (const auto& enemy : enemies) enemy->draw(window);
-                            player.draw(window);
-
-                            window.setView(defView);
-                            hud.draw(window);
-                            controls.draw(window);
-                            wavePopup.draw(window);
-
-                            if (state == GameState::Paused) pauseMenu.draw(window);
-                            if (state == GameState::Upgrading) upgradeSystem.draw(window);
-                            if (state == GameState::GameOver) drawGameOver();
+                    void render(sf::RenderTarget& target) {
+                        TraceScope trace("Game::render");
+                        AllocScope scope(AllocTracking::Scope::Render);
+                        target.clear(sf::Color(5, 8, 15));
+                        bool frozen = state == GameState::Paused || state == GameState::Upgrading || state == GameState::GameOver;
+                        if (!frozen) frozenValid = false;
+
+                        if (state == GameState::Loading) {
+                            target.setView(target.getDefaultView());
+                            drawSplash(target);
+                        } else if (state == GameState::MainMenu) {
+                            target.setView(target.getDefaultView());
+                            mainMenu.draw(target);
+                        } else if (state == GameState::Playing || !renderFrozen(target)) {
+                            drawScene(target);
+                            drawOverlay(target);
                         }
+                    }
 
-                        window.display();
+                    // Monde et HUD, sans les menus par-dessus. Résolution dynamique
+                    // en dessous de 100 % : décor et monde sont rendus dans un coin de
+                    // sceneTarget (même vue, viewport réduit) puis agrandis à la taille
+                    // de la cible ; le HUD reste à la résolution native.
+                    void drawScene(sf::RenderTarget& target) {
+                        TraceScope trace("Game::drawScene");
+                        // Tout le stockage temporaire de la frame vient de l'arène.
+                        frameArena.reset();
+                        FrameBatches batches(frameArena, quality.current(), &atlas);
+
+                        sf::View defView = target.getDefaultView();
+                        float scale = dynamicResolution ? resolution.getScale() : 1.f;
+                        bool scaled = scale < 1.f && prepareSceneTarget(target.getSize());
+                        sf::RenderTarget& worldTarget = scaled ? static_cast<sf::RenderTarget&>(sceneTarget) : target;
+                        sf::FloatRect viewport({0.f, 0.f}, {scale, scale});
+                        if (scaled) sceneTarget.clear(sf::Color(5, 8, 15));
+
+                        sf::View backgroundView = defView;
+                        if (scaled) backgroundView.setViewport(viewport);
+                        worldTarget.setView(backgroundView);
+                        background.draw(worldTarget, camera.getCenter() - sf::Vector2f{
+                            defView.getSize().x / 2.f, defView.getSize().y / 2.f}, world.getStreamer(), batches.scratch);
+
+                        sf::View worldView = camera.getView();
+                        if (scaled) worldView.setViewport(viewport);
+                        worldTarget.setView(worldView);
+                        world.draw(worldTarget, batches);
+
+                        target.setView(defView);
+                        if (scaled) {
+                            // Même arrondi que SFML pour le viewport réduit.
+                            sf::Vector2u size = target.getSize();
+                            sf::Vector2i region{int(std::lround(float(size.x) * scale)), int(std::lround(float(size.y) * scale))};
+                            sceneTarget.display();
+                            sf::Sprite upscale(sceneTarget.getTexture());
+                            upscale.setTextureRect({{0, 0}, region});
+                            upscale.setScale({float(size.x) / float(region.x), float(size.y) / float(region.y)});
+                            target.draw(upscale, sf::BlendNone);
+                        }
+
+                        AllocScope hudScope(AllocTracking::Scope::Hud);
+                        hud.draw(target, batches.overlay);
+                        controls.draw(target, batches.overlay);
+
+                        if (session) drawNetStats(target);
+                    }
+
+                    // Texture du monde à la taille de la cible, réallouée seulement si
+                    // celle-ci change : l'échelle ne fait que réduire le viewport.
+                    bool prepareSceneTarget(sf::Vector2u size) {
+                        if (sceneFailed) return false;
+                        if (sceneTarget.getSize() == size) return true;
+                        if (!sceneTarget.resize(size)) {
+                            std::cerr << "Texture de resolution dynamique indisponible, rendu natif" << std::endl;
+                            sceneFailed = true;
+                            return false;
+                        }
+                        sceneTarget.setSmooth(true);
+                        return true;
+                    }
+
+                    void drawOverlay(sf::RenderTarget& target) {
+                        TraceScope trace("Game::drawOverlay");
+                        target.setView(target.getDefaultView());
+                        ShapeBatch batch(frameArena, 256);
+                        AllocScope scope(AllocTracking::Scope::Menus);
+                        wavePopup.draw(target, batch);
+
+                        if (state == GameState::Paused) pauseMenu.draw(target);
+                        if (state == GameState::Upgrading) upgradeSystem.draw(target);
+                        if (state == GameState::GameOver) drawGameOver(target);
+                    }
+
+                    // Pause, améliorations, fin de partie : le monde ne bouge plus. Il est
+                    // rendu une fois dans frozenScene à l'entrée de l'état ; l'image
+                    // composée (monde + menu) n'est refaite que si le menu change, sinon
+                    // chaque frame se résume à la recopier. false : textures indisponibles,
+                    // l'appelant dessine tout directement.
+                    bool renderFrozen(sf::RenderTarget& target) {
+                        sf::Vector2u size = target.getSize();
+                        if (!frozenValid || frozenScene.getSize() != size) {
+                            if (frozenScene.getSize() != size && (!frozenScene.resize(size) || !frozenFrame.resize(size))) {
+                                if (!frozenFailed) std::cerr << "Cache de la scene figee indisponible" << std::endl;
+                                frozenFailed = true;
+                                return false;
+                            }
+                            frozenScene.clear(sf::Color(5, 8, 15));
+                            drawScene(frozenScene);
+                            frozenScene.display();
+                            frozenValid = true;
+                            frozenKey = -1;
+                        }
+
+                        long key = overlayKey();
+                        if (key != frozenKey) {
+                            frameArena.reset();
+                            frozenFrame.setView(frozenFrame.getDefaultView());
+                            frozenFrame.draw(sf::Sprite(frozenScene.getTexture()), sf::BlendNone);
+                            drawOverlay(frozenFrame);
+                            frozenFrame.display();
+                            frozenKey = key;
+                            ++frozenRedraws;
+                        }
+
+                        target.setView(target.getDefaultView());
+                        target.draw(sf::Sprite(frozenFrame.getTexture()), sf::BlendNone);
+                        return true;
+                    }
+
+                    // Tout ce qui change l'image des menus : sélection, fondus, minuteries.
+                    long overlayKey() const {
+                        long key = long(state);
+                        if (wavePopup.active()) key += 8 * (1 + long(wavePopup.getTimer() * 60.f));
+                        if (state == GameState::Paused) key += 8 * 1024 * long(pauseMenu.getSelected());
+                        if (state == GameState::Upgrading) key += 8 * 1024 * long(upgradeSystem.getSelected());
+                        if (state == GameState::GameOver)
+                            key += 8 * 1024 * (2 * long(std::min(gameOverTimer * 150.f, 220.f)) + (gameOverTimer > 1.f));
+                        return key;
+                    }
+
+                    GameState getState() const { return state; }
+                    World& getWorld() { return world; }
+                    const FrameArena& getFrameArena() const { return frameArena; }
+                    size_t getFrozenRedraws() const { return frozenRedraws; }
+                    const QualityGovernor& getQuality() const { return quality; }
+                    const ResolutionScaler& getResolution() const { return resolution; }
+                    bool isDynamicResolution() const { return dynamicResolution; }
+
+                    // Sans police : uniquement des formes, affichable dès la première frame.
+                    void drawSplash(sf::RenderTarget& target) const {
+                        sf::Vector2f center = target.getView().getCenter();
+
+                        sf::CircleShape orb(18.f);
+                        orb.setOrigin({18.f, 18.f});
+                        orb.setPosition({center.x, center.y - 50.f});
+                        orb.setFillColor(sf::Color(100, 150, 255, 200));
+                        target.draw(orb);
+
+                        sf::RectangleShape frame{{400.f, 12.f}};
+                        frame.setPosition({center.x - 200.f, center.y});
+                        frame.setFillColor(sf::Color(20, 25, 40));
+                        frame.setOutlineThickness(2.f);
+                        frame.setOutlineColor(sf::Color(80, 100, 150));
+                        target.draw(frame);
+
+                        sf::RectangleShape bar{{400.f * loader.progress(), 12.f}};
+                        bar.setPosition({center.x - 200.f, center.y});
+                        bar.setFillColor(sf::Color(100, 150, 255));
+                        target.draw(bar);
                     }
 
-                    void drawGameOver() {
-                        sf::Vector2f center = window.getView().getCenter();
-                        sf::Vector2f size = window.getView().getSize();
+                    void drawGameOver(sf::RenderTarget& target) {
+                        sf::Vector2f center = target.getView().getCenter();
+                        sf::Vector2f size = target.getView().getSize();
                         float left = center.x - size.x / 2.f;
                         float top = center.y - size.y / 2.f;
 
@@ -2201,83 +6591,265 @@ public:
                         overlay.setSize(size);
                         overlay.setPosition({left, top});
                         overlay.setFillColor(sf::Color(10, 0, 0, uint8_t(alpha)));
-                        window.draw(overlay);
+                        target.draw(overlay);
 
                         sf::RectangleShape box{{480.f, 220.f}};
                         box.setPosition({center.x - 240.f, center.y - 110.f});
                         box.setFillColor(sf::Color(30, 15, 20, 250));
                         box.setOutlineThickness(3.f);
                         box.setOutlineColor(sf::Color(200, 80, 80, 255));
-                        window.draw(box);
+                        target.draw(box);
 
-                        if (FontManager::instance().isLoaded()) {
-                            auto& font = FontManager::instance().getFont();
+                        if (fonts.isLoaded()) {
+                            const sf::Font& font = fonts.getFont();
 
                             sf::Text gameOver(font, "GAME OVER", 52);
                             gameOver.setFillColor(sf::Color(255, 100, 100));
                             gameOver.setStyle(sf::Text::Bold);
                             sf::FloatRect gob = gameOver.getGlobalBounds();
                             gameOver.setPosition({center.x - gob.size.x / 2.f, center.y - 90.f});
-                            window.draw(gameOver);
+                            target.draw(gameOver);
 
-                            sf::Text waveReached(font, "Vague atteinte: " + std::to_string(waveManager.getCurrentWave()), 26);
+                            sf::Text waveReached(font, "Vague atteinte: " + std::to_string(world.getWaveManager().getCurrentWave()), 26);
                             waveReached.setFillColor(sf::Color(255, 220, 100));
                             sf::FloatRect wrb = waveReached.getGlobalBounds();
                             waveReached.setPosition({center.x - wrb.size.x / 2.f, center.y - 15.f});
-                            window.draw(waveReached);
+                            target.draw(waveReached);
 
-                            if (gameOverTimer > 1.f) {
+                            if (gameOverTimer > 1.f && session) {
+                                sf::Text menu(font, "[Echap] Menu", 20);
+                                menu.setFillColor(sf::Color(200, 100, 100));
+                                sf::FloatRect mb = menu.getGlobalBounds();
+                                menu.setPosition({center.x - mb.size.x / 2.f, center.y + 45.f});
+                                target.draw(menu);
+                            } else if (gameOverTimer > 1.f) {
                                 sf::Text retry(font, "[Entree] Rejouer", 20);
                                 retry.setFillColor(sf::Color(100, 200, 100));
                                 retry.setPosition({center.x - 170.f, center.y + 45.f});
-                                window.draw(retry);
+                                target.draw(retry);
 
                                 sf::Text menu(font, "[Echap] Menu", 20);
                                 menu.setFillColor(sf::Color(200, 100, 100));
                                 menu.setPosition({center.x + 20.f, center.y + 45.f});
-                                window.draw(menu);
+                                target.draw(menu);
+
+                                if (hasCheckpoint) {
+                                    sf::Text resume(font, "[R] Reprendre la vague", 20);
+                                    resume.setFillColor(sf::Color(100, 180, 255));
+                                    sf::FloatRect rb = resume.getGlobalBounds();
+                                    resume.setPosition({center.x - rb.size.x / 2.f, center.y + 75.f});
+                                    target.draw(resume);
+                                }
                             }
                         }
                     }
 
+                    void drawNetStats(sf::RenderTarget& target) {
+                        int predicted = session->getPredictedFrames(), depth = session->getLastRollbackDepth();
+                        bool desync = session->isDesynced();
+                        sf::Text* text = netStats.get(predicted * 1000 + depth * 2 + desync, [&] {
+                            std::string line = "prediction " + std::to_string(predicted) + "  rollback " + std::to_string(depth);
+                            return desync ? line + "  DESYNC" : line;
+                        });
+                        if (!text) return;
+                        text->setFillColor(desync ? sf::Color(255, 90, 90) : sf::Color(150, 170, 200));
+                        text->setPosition({target.getView().getSize().x - text->getGlobalBounds().size.x - 20.f, 95.f});
+                        target.draw(*text);
+                    }
+
 private:
+                    // Les deux pairs partent du même état : même graine, deux joueurs,
+                    // vagues enchaînées (l'écran d'améliorations n'est pas synchronisé).
+                    void startNetplay() {
+                        world.seed(Config::NETPLAY_SEED);
+                        world.setPlayerCount(2);
+                        world.setAutoAdvanceWaves(true);
+                        tickAccumulator = 0;
+
+                        session.reset();
+                        peer.reset();
+                        link.reset();
+                        if (udp) {
+                            session = std::make_unique<RollbackSession>(world, *udp, localPlayer);
+                        } else {
+                            link = std::make_unique<LoopbackLink>(loopbackSettings);
+                            peer = std::make_unique<LoopbackPeer>(*world.getLevel().copy(), link->endpoint(1));
+                            session = std::make_unique<RollbackSession>(world, link->endpoint(0), 0);
+                        }
+                    }
+
+                    // Pas fixe : la simulation doit être identique chez les deux pairs.
+                    void stepNetplay(float dt) {
+                        TraceScope trace("Game::stepNetplay");
+                        tickAccumulator += dt;
+                        uint16_t bits = PlayerInput::heldBits(input);
+                        while (tickAccumulator >= Config::FIXED_DT) {
+                            tickAccumulator -= Config::FIXED_DT;
+                            if (!session->advance(bits)) {
+                                tickAccumulator = 0; // en attente du pair
+                                if (!peer) break;
+                            }
+                            if (peer) peer->advance();
+                            if (link) link->advance();
+                        }
+                    }
+
+                    // Point de reprise en début de vague ([R] sur l'écran de fin).
+                    void takeCheckpoint() { hasCheckpoint = world.capture(*checkpoint); }
+
+                    void quickSave() {
+                        if (!world.capture(*quickSlot) || !quickSlot->save(Config::QUICKSAVE_PATH))
+                            std::cerr << "Sauvegarde impossible: " << Config::QUICKSAVE_PATH << std::endl;
+                    }
+
+                    void quickLoad() {
+                        if (quickSlot->load(Config::QUICKSAVE_PATH)) world.restore(*quickSlot);
+                        else std::cerr << "Aucune sauvegarde valide: " << Config::QUICKSAVE_PATH << std::endl;
+                    }
+
+                    // Récupère sans bloquer les ressources terminées par le pool.
+                    void pollAssets() {
+                        if (AssetLoader::isReady(pendingFont))
+                            fonts.setFont(pendingFont.get(), fontAsset ? fontAsset->owner : nullptr);
+                        // Avant l'atlas, les entités sont tracées en formes tessellées.
+                        if (AssetLoader::isReady(pendingAtlas)) atlas.upload(pendingAtlas.get());
+
+                        if (AssetLoader::isReady(pendingLevel)) {
+                            std::optional<Level> level = pendingLevel.get();
+                            if (level) {
+                                world.loadLevel(std::move(*level));
+                                applyLevel();
+                            } else if (levelRequired) {
+                                std::cerr << "Niveau introuvable: " << levelPath << std::endl;
+                                loadError = true;
+                                window.close();
+                            }
+                        }
+                    }
+
     sf::RenderWindow window;
     bool isFullscreen = true;
 
-    GameState state = GameState::MainMenu;
+    GameState state = GameState::Loading;
     InputManager input;
 
-    MainMenu mainMenu;
-    PauseMenu pauseMenu;
-    UpgradeSystem upgradeSystem;
-    GameHUD hud;
-    ControlsHint controls;
-    WaveCompletePopup wavePopup;
+    FontManager fonts; // avant les menus et le HUD, qui la gardent par référence
+    MainMenu mainMenu{fonts};
+    PauseMenu pauseMenu{fonts};
+    UpgradeSystem upgradeSystem{fonts};
+    GameHUD hud{fonts};
+    ControlsHint controls{fonts};
+    WaveCompletePopup wavePopup{fonts};
 
     Camera camera;
-    ScreenShake screenShake;
     Background background;
 
-    Player player;
-    std::vector<Platform> platforms;
-    std::vector<std::unique_ptr<Enemy>> enemies;
-    std::vector<Projectile> projectiles;
-
-    WaveManager waveManager;
+    std::unique_ptr<TelemetryLog> telemetry; // avant world, qui garde un pointeur dessus
+    std::unique_ptr<HitchCapture> hitchCapture;
+    World world;
     float gameOverTimer = 0;
+
+    bool netplay = false;
+    size_t localPlayer = 0;
+    float tickAccumulator = 0;
+    LoopbackLink::Settings loopbackSettings;
+    std::unique_ptr<UdpTransport> udp;
+    std::unique_ptr<LoopbackLink> link;
+    std::unique_ptr<LoopbackPeer> peer;
+    std::unique_ptr<RollbackSession> session;
+    CachedText netStats{fonts, 14, sf::Color(150, 170, 200)};
+
+    FrameArena frameArena;
+    QualityGovernor quality;
+
+    // Scène figée (pause, améliorations, fin de partie) et image composée avec le menu.
+    sf::RenderTexture frozenScene, frozenFrame;
+    bool frozenValid = false, frozenFailed = false;
+    sf::RenderTexture sceneTarget; // monde à résolution réduite, agrandi ensuite
+    ResolutionScaler resolution;
+    bool dynamicResolution = false, sceneFailed = false;
+    sf::Clock paceClock; // limite de 60 fps quand display() est chronométré
+    long frozenKey = -1;
+    size_t frozenRedraws = 0;
+
+    // Alloués une fois : prendre ou restaurer un instantané n'alloue plus rien.
+    std::unique_ptr<WorldSnapshot> checkpoint = std::make_unique<WorldSnapshot>();
+    std::unique_ptr<WorldSnapshot> quickSlot = std::make_unique<WorldSnapshot>();
+    bool hasCheckpoint = false;
+
+    std::optional<AssetPack> pack;
+    std::optional<AssetPack::Asset> fontAsset;
+    std::future<std::optional<sf::Font>> pendingFont;
+    std::future<std::optional<Level>> pendingLevel;
+    std::future<sf::Image> pendingAtlas;
+    SpriteAtlas atlas;
+    std::string levelPath;
+    bool levelRequired = false;
+    bool loadError = false;
+
+    // Déclaré en dernier : ses threads s'arrêtent avant la destruction du reste.
+    AssetLoader loader;
 };
 
 // ============================================================================
 // MAIN
 // ============================================================================
 
-int main() {
+// Les benchmarks incluent ce fichier et fournissent leur propre main().
+#ifndef SOUL_WORLD_NO_MAIN
+int main(int argc, char** argv) {
     try {
-        Game game;
+        std::string levelPath = "levels/default.swl";
+        std::string packPath = Config::ASSET_PACK_PATH;
+        bool explicitLevel = false;
+        std::optional<LoopbackLink::Settings> loopback;
+        std::vector<std::string> net; // portLocal, hote, portDistant, joueur
+        std::string telemetryPath;
+        std::optional<HitchCapture::Settings> hitches;
+        bool dynamicResolution = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--level" && i + 1 < argc) { levelPath = argv[++i]; explicitLevel = true; }
+            else if (arg == "--pack" && i + 1 < argc) packPath = argv[++i];
+            else if (arg == "--loopback") {
+                loopback.emplace();
+                if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                    loopback->latencyTicks = std::stoi(argv[++i]);
+            } else if (arg == "--telemetry" && i + 1 < argc) {
+                telemetryPath = argv[++i];
+            } else if (arg == "--hitch-trace") {
+                hitches.emplace();
+                if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                    hitches->thresholdMs = std::stof(argv[++i]);
+                if (i + 1 < argc && argv[i + 1][0] != '-') hitches->directory = argv[++i];
+            } else if (arg == "--dynamic-resolution") {
+                dynamicResolution = true;
+            } else if (arg == "--net" && i + 4 < argc) {
+                net.assign(argv + i + 1, argv + i + 5);
+                i += 4;
+            } else {
+                std::cerr << "Usage: " << argv[0] << " [--level fichier] [--pack fichier] "
+                          << "[--loopback [latence]] [--net portLocal hote portDistant 1|2] "
+                          << "[--telemetry fichier.swt] [--hitch-trace [seuilMs] [dossier]] [--dynamic-resolution]" << std::endl;
+                return 2;
+            }
+        }
+        Game game(true, packPath);
+        if (explicitLevel || !game.loadPackedLevelAsync("levels/default.swl"))
+            game.loadLevelAsync(levelPath, explicitLevel);
+        if (loopback) game.enableLoopback(*loopback);
+        if (!telemetryPath.empty() && !game.enableTelemetry(telemetryPath)) return 1;
+        if (hitches) game.enableHitchCapture(*hitches);
+        if (dynamicResolution) game.enableDynamicResolution();
+        if (!net.empty() && !game.enableUdp(static_cast<unsigned short>(std::stoi(net[0])), net[1],
+                                            static_cast<unsigned short>(std::stoi(net[2])), net[3] == "2" ? 1 : 0))
+            return 1;
         game.run();
+        if (game.hasLoadError()) return 1;
     } catch (const std::exception& e) {
         std::cerr << "Erreur: " << e.what() << std::endl;
         return 1;
     }
     return 0;
 }
+#endif
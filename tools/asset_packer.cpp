@@ -0,0 +1,75 @@
+// ============================================================================
+// SOUL WORLD - Empaqueteur de ressources (fichiers -> paquet .swp)
+// ============================================================================
+//
+// Usage : soulworld_pack <sortie.swp> <nom>=<fichier> ...
+//         soulworld_pack --list <paquet.swp>
+//
+// Noms utilisés par le jeu :
+//   fonts/main.ttf        police de l'interface
+//   levels/<niveau>.swl   niveaux compilés par soulworld_levelc
+
+#define SOUL_WORLD_NO_MAIN
+#include "../main.cpp"
+
+namespace {
+
+bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    bytes.resize(size_t(in.tellg()));
+    in.seekg(0);
+    return bool(in.read(reinterpret_cast<char*>(bytes.data()), std::streamsize(bytes.size())));
+}
+
+bool pack(const std::string& outPath, int count, char** specs) {
+    PackBuilder builder;
+    for (int i = 0; i < count; ++i) {
+        std::string spec = specs[i];
+        auto eq = spec.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Entree invalide (attendu nom=fichier): " << spec << std::endl;
+            return false;
+        }
+        std::string name = spec.substr(0, eq), path = spec.substr(eq + 1);
+        std::vector<uint8_t> bytes;
+        if (!readFile(path, bytes)) {
+            std::cerr << "Impossible de lire " << path << std::endl;
+            return false;
+        }
+        if (!builder.add(name, std::move(bytes))) {
+            std::cerr << "Nom invalide ou en double: " << name << std::endl;
+            return false;
+        }
+    }
+
+    if (!builder.save(outPath)) {
+        std::cerr << "Impossible d'ecrire " << outPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool list(const std::string& path) {
+    std::optional<AssetPack> pack = AssetPack::open(path);
+    if (!pack) {
+        std::cerr << "Paquet illisible: " << path << std::endl;
+        return false;
+    }
+    std::cout << path << ": version " << pack->header().version << ", " << pack->header().fileSize
+              << " octets, " << pack->entryCount() << " ressources\n";
+    for (uint32_t i = 0; i < pack->entryCount(); ++i) {
+        const PackFormat::Entry& e = pack->entries()[i];
+        std::cout << "  " << e.name << "  " << e.size << " octets @" << e.offset << "\n";
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::string(argv[1]) == "--list") return list(argv[2]) ? 0 : 1;
+    if (argc >= 2 && std::string(argv[1]) != "--list") return pack(argv[1], argc - 2, argv + 2) ? 0 : 1;
+    std::cerr << "Usage: " << argv[0] << " <sortie.swp> <nom>=<fichier> ... | --list <paquet.swp>" << std::endl;
+    return 2;
+}
@@ -0,0 +1,109 @@
+// ============================================================================
+// SOUL WORLD - Compilateur de niveaux (texte -> binaire .swl)
+// ============================================================================
+//
+// Usage : soulworld_levelc <entree.txt> <sortie.swl>
+//         soulworld_levelc --info <niveau.swl>
+//
+// Format texte (une directive par ligne, '#' pour les commentaires) :
+//   bounds <largeur> <hauteur> <solY>
+//   start <x> <y>
+//   background <graine>
+//   platform <x> <y> <l> <h> [oneway]
+//   moving <x> <y> <l> <h> <horizontal|vertical> <amplitude> <vitesse>
+//   spawn <minX> <maxX> <y>
+
+#define SOUL_WORLD_NO_MAIN
+#include "../main.cpp"
+
+#include <sstream>
+
+namespace {
+
+bool compile(const std::string& inPath, const std::string& outPath) {
+    std::ifstream in(inPath);
+    if (!in) {
+        std::cerr << "Impossible d'ouvrir " << inPath << std::endl;
+        return false;
+    }
+
+    LevelBuilder builder;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        std::istringstream ss(line.substr(0, line.find('#')));
+        std::string cmd;
+        if (!(ss >> cmd)) continue;
+
+        bool ok = true;
+        if (cmd == "bounds") {
+            float w, h, floorY;
+            ok = bool(ss >> w >> h >> floorY);
+            if (ok) builder.bounds(w, h, floorY);
+        } else if (cmd == "start") {
+            float x, y;
+            ok = bool(ss >> x >> y);
+            if (ok) builder.start({x, y});
+        } else if (cmd == "background") {
+            uint32_t seed;
+            ok = bool(ss >> seed);
+            if (ok) builder.backgroundSeed(seed);
+        } else if (cmd == "platform") {
+            float x, y, w, h;
+            std::string flag;
+            ok = bool(ss >> x >> y >> w >> h);
+            ss >> flag;
+            if (ok) builder.platform({w, h}, {x, y}, flag == "oneway");
+        } else if (cmd == "moving") {
+            float x, y, w, h, range, speed;
+            std::string axis;
+            ok = bool(ss >> x >> y >> w >> h >> axis >> range >> speed) &&
+                 (axis == "horizontal" || axis == "vertical");
+            if (ok) builder.movingPlatform({w, h}, {x, y}, axis == "horizontal", range, speed);
+        } else if (cmd == "spawn") {
+            float minX, maxX, y;
+            ok = bool(ss >> minX >> maxX >> y);
+            if (ok) builder.spawnZone(minX, maxX, y);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << inPath << ":" << lineNo << ": directive invalide: " << line << std::endl;
+            return false;
+        }
+    }
+
+    if (!builder.save(outPath)) {
+        std::cerr << "Impossible d'ecrire " << outPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool info(const std::string& path) {
+    std::optional<Level> level = Level::load(path);
+    if (!level) {
+        std::cerr << "Niveau illisible: " << path << std::endl;
+        return false;
+    }
+    const auto& h = level->header();
+    std::cout << path << ": version " << h.version << ", " << h.fileSize << " octets\n"
+              << "  limites " << h.width << " x " << h.height << ", sol " << h.floorY << "\n"
+              << "  depart (" << h.startX << ", " << h.startY << "), graine decor " << h.backgroundSeed << "\n"
+              << "  " << level->platformCount() << " plateformes, "
+              << level->spawnZoneCount() << " zones d'apparition\n"
+              << "  " << level->chunkCount() << " chunks de " << level->chunkWidth()
+              << ", portee " << level->chunkReach() << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::string(argv[1]) == "--info") return info(argv[2]) ? 0 : 1;
+    if (argc == 3) return compile(argv[1], argv[2]) ? 0 : 1;
+    std::cerr << "Usage: " << argv[0] << " <entree.txt> <sortie.swl> | --info <niveau.swl>" << std::endl;
+    return 2;
+}
@@ -0,0 +1,59 @@
+// ============================================================================
+// SOUL WORLD - Lecteur du journal de télémétrie (.swt -> CSV)
+// ============================================================================
+//
+// Usage : soulworld_teldump <journal.swt> [sortie.csv]
+// Sans sortie, le CSV va sur stdout. Colonnes :
+//   time,event,subject,amount,value,entity,x,y
+
+#define SOUL_WORLD_NO_MAIN
+#include "../main.cpp"
+
+#include <cstdio>
+
+namespace {
+
+bool dump(const std::string& path, std::ostream& csv) {
+    std::ifstream in(path, std::ios::binary);
+    TelemetryFormat::Header header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != TelemetryFormat::MAGIC ||
+        header.version != TelemetryFormat::VERSION || header.recordSize != sizeof(TelemetryFormat::Event)) {
+        std::cerr << "Journal illisible: " << path << std::endl;
+        return false;
+    }
+
+    csv << "time,event,subject,amount,value,entity,x,y\n";
+    TelemetryFormat::Event e;
+    size_t count = 0;
+    char line[160];
+    while (in.read(reinterpret_cast<char*>(&e), sizeof(e))) {
+        if (uint8_t(e.type) >= uint8_t(TelemetryFormat::EventType::Count)) {
+            std::cerr << "Evenement inconnu au record " << count << std::endl;
+            return false;
+        }
+        std::snprintf(line, sizeof(line), "%.6f,%s,%u,%d,%d,%u,%.3f,%.3f\n", double(e.time),
+                      TelemetryFormat::NAMES[size_t(e.type)], unsigned(e.subject), int(e.amount), int(e.value), unsigned(e.entity),
+                      double(e.x), double(e.y));
+        csv << line;
+        ++count;
+    }
+    if (in.gcount() != 0) std::cerr << "Record tronque en fin de fichier (ignore)" << std::endl;
+    std::cerr << count << " evenements" << std::endl;
+    return bool(csv);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 2) return dump(argv[1], std::cout) ? 0 : 1;
+    if (argc == 3) {
+        std::ofstream out(argv[2]);
+        if (!out) {
+            std::cerr << "Impossible d'ecrire " << argv[2] << std::endl;
+            return 1;
+        }
+        return dump(argv[1], out) ? 0 : 1;
+    }
+    std::cerr << "Usage: " << argv[0] << " <journal.swt> [sortie.csv]" << std::endl;
+    return 2;
+}